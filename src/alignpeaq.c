@@ -0,0 +1,387 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * alignpeaq.c: Search the time offset of a test signal by evaluating
+ * candidate offsets in parallel.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Determines the offset at which a test signal (e.g. a decoded item of
+ * unknown codec delay) best matches the reference by evaluating it at a set
+ * of candidate offsets, where cross-correlation is unreliable because of
+ * heavy distortion or transients. Both signals are WAV files (16, 24 or 32
+ * bit integer or 32 bit float at 48 kHz).
+ *
+ * An offset of d samples means that sample n + d of the test signal is
+ * compared to sample n of the reference, i.e. a positive offset compensates
+ * a delay of the test signal. Missing test samples at either end are
+ * replaced by silence, so every candidate covers the whole reference.
+ *
+ * The candidates, either listed with --offsets or spaced --step samples
+ * apart within +/- --range samples, are evaluated in one run by separate
+ * peaq elements on up to --jobs threads. The reference is split into buffers
+ * only once; these are pushed, read-only and without copying, to all
+ * elements. The candidate with the highest objective difference grade (or,
+ * with --criterion=nmr, the lowest noise-to-mask ratio MOV) is reported
+ * together with all its results.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "toolutil.h"
+
+#define SAMPLING_RATE 48000
+#define BLOCK_FRAMES 4800
+
+typedef struct _Candidate Candidate;
+
+struct _Candidate
+{
+  gint offset;
+  gboolean ok;
+  gdouble odg;
+  gdouble di;
+  gdouble nmr;
+  GstStructure *results;
+};
+
+static gboolean advanced = FALSE;
+static gdouble playback_level = 92.;
+static gint range = 480;
+static gint step = 48;
+static gchar *offset_list = NULL;
+static gint jobs = 0;
+static gchar *criterion = "odg";
+static gchar **arguments;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced, "use advanced version",
+   NULL},
+  {"basic", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &advanced,
+   "use basic version (default)", NULL},
+  {"playback-level", 0, 0, G_OPTION_ARG_DOUBLE, &playback_level,
+   "playback level in dB SPL (default: 92)", "DB"},
+  {"range", 'r', 0, G_OPTION_ARG_INT, &range,
+   "search offsets from -N to N samples (default: 480)", "N"},
+  {"step", 's', 0, G_OPTION_ARG_INT, &step,
+   "spacing of the searched offsets in samples (default: 48)", "N"},
+  {"offsets", 'o', 0, G_OPTION_ARG_STRING, &offset_list,
+   "comma-separated list of offsets in samples to evaluate instead of the "
+   "range", "LIST"},
+  {"jobs", 'j', 0, G_OPTION_ARG_INT, &jobs,
+   "number of candidates to evaluate in parallel (default: number of "
+   "processors)", "N"},
+  {"criterion", 'c', 0, G_OPTION_ARG_STRING, &criterion,
+   "select the candidate with the highest objective difference grade (odg, "
+   "default) or the lowest noise-to-mask ratio (nmr)", "NAME"},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &arguments, NULL,
+   "REFFILE TESTFILE"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+/* shared by all candidates */
+static gfloat *test;
+static gsize test_frames;
+static guint channels;
+static gsize frames;
+static GstBuffer **ref_blocks;
+
+/*
+ * parse_offsets:
+ * @count: Location to store the number of candidates.
+ *
+ * Returns: The candidate offsets as given by --offsets or --range and
+ * --step, to be freed with g_free(), or %NULL on error.
+ */
+static gint *
+parse_offsets (guint *count)
+{
+  gint *offsets;
+  guint i;
+
+  if (offset_list) {
+    gchar **items = g_strsplit (offset_list, ",", -1);
+    *count = g_strv_length (items);
+    offsets = g_new (gint, MAX (*count, 1));
+    for (i = 0; i < *count; i++) {
+      gchar *end;
+      offsets[i] = strtol (items[i], &end, 10);
+      if (end == items[i] || *end != '\0') {
+        g_printf ("Error: %s is no offset\n", items[i]);
+        g_strfreev (items);
+        g_free (offsets);
+        return NULL;
+      }
+    }
+    g_strfreev (items);
+    if (*count == 0) {
+      puts ("Error: no offsets given");
+      g_free (offsets);
+      return NULL;
+    }
+    return offsets;
+  }
+
+  if (range < 0 || step <= 0) {
+    puts ("Error: the range must not be negative and the step positive");
+    return NULL;
+  }
+  *count = 2 * (range / step) + 1;
+  offsets = g_new (gint, *count);
+  for (i = 0; i < *count; i++)
+    offsets[i] = ((gint) i - (gint) (range / step)) * step;
+  return offsets;
+}
+
+/*
+ * split_reference:
+ * @ref: Interleaved reference samples.
+ *
+ * Wraps the reference in read-only buffers of #BLOCK_FRAMES frames without
+ * copying it, to be pushed to the elements of all candidates.
+ *
+ * Returns: A %NULL-terminated array of the buffers.
+ */
+static GstBuffer **
+split_reference (gfloat *ref)
+{
+  guint count = (frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+  GstBuffer **blocks = g_new (GstBuffer *, count + 1);
+  guint i;
+  for (i = 0; i < count; i++) {
+    gsize size = MIN (BLOCK_FRAMES, frames - i * BLOCK_FRAMES) * channels *
+      sizeof (gfloat);
+    blocks[i] =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+                                   ref + i * BLOCK_FRAMES * channels, size, 0,
+                                   size, NULL, NULL);
+  }
+  blocks[count] = NULL;
+  return blocks;
+}
+
+/*
+ * shifted_test_block:
+ * @offset: The offset of the candidate.
+ * @position: The first reference frame of the block.
+ * @block_frames: The number of frames of the block.
+ *
+ * Returns: A buffer of the test frames matching the reference frames from
+ * @position on, with silence where the shifted test signal does not extend.
+ */
+static GstBuffer *
+shifted_test_block (gint offset, gsize position, gsize block_frames)
+{
+  gsize size = block_frames * channels * sizeof (gfloat);
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gint64 first = (gint64) position + offset;
+  gint64 begin = CLAMP (first, 0, (gint64) test_frames);
+  gint64 end = CLAMP (first + (gint64) block_frames, 0, (gint64) test_frames);
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  memset (map.data, 0, size);
+  if (end > begin)
+    memcpy (map.data + (begin - first) * channels * sizeof (gfloat),
+            test + begin * channels, (end - begin) * channels *
+            sizeof (gfloat));
+  gst_buffer_unmap (buffer, &map);
+  return buffer;
+}
+
+/*
+ * evaluate_candidate:
+ * @data: The #Candidate to evaluate.
+ * @user_data: Unused.
+ *
+ * Runs the reference and the test signal shifted by the offset of the
+ * candidate through a new peaq element. Called from the thread pool.
+ */
+static void
+evaluate_candidate (gpointer data, gpointer user_data)
+{
+  Candidate *candidate = data;
+  GstElement *peaq;
+  GstPad *ref_src, *test_src;
+  gsize position;
+  guint i;
+
+  peaq = gst_element_factory_make ("peaq", NULL);
+  if (!peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    exit (2);
+  }
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "playback-level", playback_level,
+                "console_output", FALSE, NULL);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, channels);
+  peaq_toolutil_start_stream (test_src, channels);
+
+  candidate->ok = TRUE;
+  for (i = 0, position = 0; candidate->ok && ref_blocks[i];
+       i++, position += BLOCK_FRAMES) {
+    gsize block_frames = MIN (BLOCK_FRAMES, frames - position);
+    if (gst_pad_push (ref_src, gst_buffer_ref (ref_blocks[i])) !=
+        GST_FLOW_OK ||
+        gst_pad_push (test_src,
+                      shifted_test_block (candidate->offset, position,
+                                          block_frames)) != GST_FLOW_OK)
+      candidate->ok = FALSE;
+  }
+
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "odg", &candidate->odg, "di", &candidate->di,
+                "results", &candidate->results, NULL);
+  /* without the NMR the candidate cannot be ranked */
+  if (!candidate->results ||
+      !gst_structure_get_double (candidate->results,
+                                 advanced ? "segmental-nmr" : "total-nmr",
+                                 &candidate->nmr))
+    candidate->ok = FALSE;
+
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gfloat *ref;
+  guint ref_channels;
+  gsize ref_frames;
+  gint *offsets;
+  guint count, i, failures = 0;
+  gboolean by_nmr;
+  Candidate *candidates;
+  Candidate *best = NULL;
+  GThreadPool *pool;
+  gint64 t;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "alignpeaq evaluates TESTFILE against REFFILE at a number of candidate\n"
+                                "offsets in parallel and reports the best matching one.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (arguments == NULL || arguments[0] == NULL || arguments[1] == NULL ||
+      arguments[2] != NULL) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (strcmp (criterion, "odg") != 0 && strcmp (criterion, "nmr") != 0) {
+    g_printf ("Error: unknown criterion %s\n", criterion);
+    return 1;
+  }
+  by_nmr = strcmp (criterion, "nmr") == 0;
+  offsets = parse_offsets (&count);
+  if (!offsets)
+    return 1;
+
+  ref = peaq_toolutil_read_wav (arguments[0], &ref_channels, &ref_frames);
+  test = peaq_toolutil_read_wav (arguments[1], &channels, &test_frames);
+  if (!ref || !test || ref_channels != channels || channels > 2) {
+    if (ref && test)
+      g_printf ("Error: %s and %s must both be mono or stereo\n",
+                arguments[0], arguments[1]);
+    g_free (ref);
+    g_free (test);
+    g_free (offsets);
+    return 1;
+  }
+  frames = ref_frames;
+  ref_blocks = split_reference (ref);
+
+  candidates = g_new0 (Candidate, count);
+  t = g_get_monotonic_time ();
+  pool = g_thread_pool_new (evaluate_candidate, NULL,
+                            jobs > 0 ? jobs : (gint) g_get_num_processors (),
+                            FALSE, NULL);
+  for (i = 0; i < count; i++) {
+    candidates[i].offset = offsets[i];
+    g_thread_pool_push (pool, &candidates[i], NULL);
+  }
+  /* waits for all candidates to be evaluated */
+  g_thread_pool_free (pool, FALSE, TRUE);
+  t = g_get_monotonic_time () - t;
+
+  g_printf ("%8s %8s %8s %8s\n", "offset", "ODG", "DI", "NMR");
+  for (i = 0; i < count; i++) {
+    Candidate *candidate = &candidates[i];
+    if (!candidate->ok) {
+      g_printf ("%8d   failed\n", candidate->offset);
+      failures++;
+      continue;
+    }
+    g_printf ("%8d %8.3f %8.3f %8.3f\n", candidate->offset, candidate->odg,
+              candidate->di, candidate->nmr);
+    if (!best || (by_nmr ? candidate->nmr < best->nmr :
+                  candidate->odg > best->odg))
+      best = candidate;
+  }
+
+  g_printf ("\n%u candidates evaluated in %.2f s\n", count, t * 1e-6);
+  if (best) {
+    gchar *results = gst_structure_to_string (best->results);
+    g_printf ("Best offset: %d samples (%.3f ms)\n", best->offset,
+              1000. * best->offset / SAMPLING_RATE);
+    g_printf ("Objective Difference Grade: %.3f\n", best->odg);
+    g_printf ("Distortion Index: %.3f\n", best->di);
+    g_printf ("Results: %s\n", results);
+    g_free (results);
+  }
+
+  for (i = 0; i < count; i++)
+    if (candidates[i].results)
+      gst_structure_free (candidates[i].results);
+  g_free (candidates);
+  for (i = 0; ref_blocks[i]; i++)
+    gst_buffer_unref (ref_blocks[i]);
+  g_free (ref_blocks);
+  g_free (offsets);
+  g_free (ref);
+  g_free (test);
+
+  gst_deinit ();
+
+  return failures > 0 || !best ? 1 : 0;
+}
@@ -0,0 +1,387 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * batchpeaq.c: Evaluate a list of items, reusing previously stored results.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Evaluates the reference/test pairs of WAV files (16, 24 or 32 bit integer
+ * or 32 bit float at 48 kHz) listed in a manifest, one pair of file names
+ * separated by whitespace per line (empty lines and lines starting with # are
+ * ignored).
+ *
+ * Each pair is identified by the SHA-256 hash of the decoded samples of both
+ * signals together with the configuration, i.e. the mode, the playback level
+ * and the version of GstPEAQ. The results are stored under this key in an
+ * append-only results store (--store), of which an index is built in memory
+ * on start-up, so pairs already evaluated before, possibly under different
+ * file names, or appearing several times in the manifest are not computed
+ * again. As the key does not cover changes to the code without a change of
+ * the version, the store should be removed (or --store pointed elsewhere)
+ * after modifying the algorithm.
+ *
+ * The store is a text file with one line per result, holding the key, the
+ * objective difference grade and the distortion index; a truncated last line
+ * (e.g. after an interruption) is ignored.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "toolutil.h"
+
+#define SAMPLING_RATE 48000
+#define BLOCK_FRAMES 4800
+
+typedef struct _Result Result;
+
+struct _Result
+{
+  gdouble odg;
+  gdouble di;
+};
+
+static gboolean advanced = FALSE;
+static gdouble playback_level = 92.;
+static gchar *store_filename = "peaq-results.store";
+static gboolean no_store = FALSE;
+static gchar **arguments;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced, "use advanced version",
+   NULL},
+  {"basic", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &advanced,
+   "use basic version (default)", NULL},
+  {"playback-level", 0, 0, G_OPTION_ARG_DOUBLE, &playback_level,
+   "playback level in dB SPL (default: 92)", "DB"},
+  {"store", 0, 0, G_OPTION_ARG_FILENAME, &store_filename,
+   "results store (default: peaq-results.store)", "FILE"},
+  {"no-store", 0, 0, G_OPTION_ARG_NONE, &no_store,
+   "neither use nor update the results store", NULL},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &arguments, NULL,
+   "MANIFEST"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+/*
+ * compute_key:
+ * @ref: Interleaved reference samples.
+ * @test: Interleaved test samples.
+ * @channels: Number of channels.
+ * @frames: Number of frames of both signals.
+ *
+ * Returns: The hexadecimal SHA-256 hash of the configuration and the samples
+ * (as little endian floats, so the key does not depend on the host), to be
+ * freed with g_free().
+ */
+static gchar *
+compute_key (gfloat const *ref, gfloat const *test, guint channels,
+             gsize frames)
+{
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  gchar level[G_ASCII_DTOSTR_BUF_SIZE];
+  gchar *config = g_strdup_printf ("gstpeaq %s %s %s %u %" G_GSIZE_FORMAT
+                                   "\n", PACKAGE_VERSION,
+                                   advanced ? "advanced" : "basic",
+                                   g_ascii_dtostr (level, sizeof (level),
+                                                   playback_level),
+                                   channels, frames);
+  gfloat const *signals[2] = { ref, test };
+  guint32 block[BLOCK_FRAMES];
+  gchar *key;
+  guint s;
+  gsize i, j, n;
+
+  g_checksum_update (checksum, (guchar const *) config, strlen (config));
+  g_free (config);
+  for (s = 0; s < 2; s++) {
+    for (i = 0; i < frames * channels; i += n) {
+      n = MIN (BLOCK_FRAMES, frames * channels - i);
+      memcpy (block, signals[s] + i, n * sizeof (guint32));
+      for (j = 0; j < n; j++)
+        block[j] = GUINT32_TO_LE (block[j]);
+      g_checksum_update (checksum, (guchar const *) block,
+                         n * sizeof (guint32));
+    }
+  }
+  key = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+  return key;
+}
+
+/*
+ * load_store:
+ * @filename: Name of the results store or %NULL.
+ * @truncated: Location to store whether the last line is incomplete.
+ *
+ * Builds the index of the results store, later entries replacing earlier ones
+ * with the same key. Without a store, the index starts empty and only serves
+ * to skip duplicates within the manifest.
+ *
+ * Returns: A #GHashTable mapping the keys to #Result.
+ */
+static GHashTable *
+load_store (gchar const *filename, gboolean *truncated)
+{
+  GHashTable *index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                             g_free);
+  gchar *contents;
+  gsize length;
+  gchar **lines;
+  guint i;
+
+  *truncated = FALSE;
+  if (!filename || !g_file_get_contents (filename, &contents, &length, NULL))
+    return index;
+  *truncated = length > 0 && contents[length - 1] != '\n';
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+  /* the last element follows the final newline, so it is either empty or
+   * a truncated line */
+  for (i = 0; lines[i] && lines[i + 1]; i++) {
+    gchar **fields = g_strsplit (lines[i], " ", -1);
+    if (g_strv_length (fields) == 3 && strlen (fields[0]) == 64) {
+      Result *result = g_new (Result, 1);
+      result->odg = g_ascii_strtod (fields[1], NULL);
+      result->di = g_ascii_strtod (fields[2], NULL);
+      g_hash_table_replace (index, g_strdup (fields[0]), result);
+    }
+    g_strfreev (fields);
+  }
+  g_strfreev (lines);
+  return index;
+}
+
+/*
+ * analyse:
+ * @ref: Interleaved reference samples.
+ * @test: Interleaved test samples.
+ * @channels: Number of channels.
+ * @frames: Number of frames of both signals.
+ * @result: Location to store the result.
+ *
+ * Runs the signals through a new peaq element.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+analyse (gfloat const *ref, gfloat const *test, guint channels, gsize frames,
+         Result *result)
+{
+  gboolean ok = TRUE;
+  GstElement *peaq;
+  GstPad *ref_src, *test_src;
+  gsize position;
+
+  peaq = gst_element_factory_make ("peaq", NULL);
+  if (!peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    exit (2);
+  }
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "playback-level", playback_level,
+                "console_output", FALSE, NULL);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, channels);
+  peaq_toolutil_start_stream (test_src, channels);
+
+  for (position = 0; ok && position < frames; position += BLOCK_FRAMES) {
+    gsize size = MIN (BLOCK_FRAMES, frames - position) * channels *
+      sizeof (gfloat);
+    if (peaq_toolutil_push_block (ref_src, ref + position * channels,
+                                  size) != GST_FLOW_OK ||
+        peaq_toolutil_push_block (test_src, test + position * channels,
+                                  size) != GST_FLOW_OK) {
+      puts ("Error: pushing data failed");
+      ok = FALSE;
+    }
+  }
+
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "odg", &result->odg, "di", &result->di, NULL);
+
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gchar *manifest;
+  gchar **lines;
+  GHashTable *index;
+  FILE *store = NULL;
+  gboolean truncated;
+  guint hits = 0, misses = 0, failures = 0;
+  gdouble hit_time = 0., miss_time = 0.;
+  guint i;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "batchpeaq computes the objective difference grades of the reference/test\n"
+                                "pairs listed in MANIFEST, reusing the results of identical pairs.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (arguments == NULL || arguments[0] == NULL || arguments[1] != NULL) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (!g_file_get_contents (arguments[0], &manifest, NULL, NULL)) {
+    g_printf ("Error: could not read %s\n", arguments[0]);
+    return 1;
+  }
+
+  index = load_store (no_store ? NULL : store_filename, &truncated);
+  if (!no_store) {
+    store = g_fopen (store_filename, "a");
+    if (!store) {
+      g_printf ("Error: could not open %s\n", store_filename);
+      return 1;
+    }
+    /* terminate an incomplete last line so it does not garble the next */
+    if (truncated)
+      fputc ('\n', store);
+  }
+
+  g_printf ("%8s %8s %-4s  %s\n", "ODG", "DI", "", "pair");
+  lines = g_strsplit (manifest, "\n", -1);
+  g_free (manifest);
+  for (i = 0; lines[i]; i++) {
+    gchar **files;
+    gfloat *ref, *test;
+    guint ref_channels, test_channels;
+    gsize ref_frames, test_frames, frames;
+    gchar *key;
+    Result *result;
+    gboolean hit;
+    gint64 t;
+    guint j, k;
+
+    g_strstrip (lines[i]);
+    if (lines[i][0] == '\0' || lines[i][0] == '#')
+      continue;
+    files = g_strsplit_set (lines[i], " \t", -1);
+    /* remove empty fields from repeated separators */
+    for (j = k = 0; files[j]; j++)
+      if (files[j][0] != '\0')
+        files[k++] = files[j];
+      else
+        g_free (files[j]);
+    files[k] = NULL;
+    if (k != 2) {
+      g_printf ("Error: line %u of %s is no pair of file names\n", i + 1,
+                arguments[0]);
+      g_strfreev (files);
+      failures++;
+      continue;
+    }
+
+    t = g_get_monotonic_time ();
+    ref = peaq_toolutil_read_wav (files[0], &ref_channels, &ref_frames);
+    test = peaq_toolutil_read_wav (files[1], &test_channels, &test_frames);
+    if (!ref || !test || ref_channels != test_channels || ref_channels > 2) {
+      if (ref && test)
+        g_printf ("Error: %s and %s must both be mono or stereo\n", files[0],
+                  files[1]);
+      g_free (ref);
+      g_free (test);
+      g_strfreev (files);
+      failures++;
+      continue;
+    }
+    frames = MIN (ref_frames, test_frames);
+
+    key = compute_key (ref, test, ref_channels, frames);
+    result = g_hash_table_lookup (index, key);
+    hit = result != NULL;
+    if (!hit) {
+      result = g_new (Result, 1);
+      if (analyse (ref, test, ref_channels, frames, result)) {
+        gchar odg[G_ASCII_DTOSTR_BUF_SIZE], di[G_ASCII_DTOSTR_BUF_SIZE];
+        if (store) {
+          fprintf (store, "%s %s %s\n", key,
+                   g_ascii_dtostr (odg, sizeof (odg), result->odg),
+                   g_ascii_dtostr (di, sizeof (di), result->di));
+          fflush (store);
+        }
+        g_hash_table_insert (index, key, result);
+        key = NULL;
+      } else {
+        g_free (result);
+        result = NULL;
+        failures++;
+      }
+    }
+    if (result)
+      g_printf ("%8.3f %8.3f %-4s  %s %s\n", result->odg, result->di,
+                hit ? "hit" : "miss", files[0], files[1]);
+    if (hit) {
+      hits++;
+      hit_time += (g_get_monotonic_time () - t) * 1e-6;
+    } else if (result) {
+      misses++;
+      miss_time += (g_get_monotonic_time () - t) * 1e-6;
+    }
+
+    g_free (key);
+    g_free (ref);
+    g_free (test);
+    g_strfreev (files);
+  }
+  g_strfreev (lines);
+
+  g_printf ("\n%u pairs: %u hits (%.1f%%, %.2f s), %u misses (%.2f s), "
+            "%u failed\n", hits + misses + failures, hits,
+            hits + misses > 0 ? 100. * hits / (hits + misses) : 0., hit_time,
+            misses, miss_time, failures);
+
+  if (store)
+    fclose (store);
+  g_hash_table_unref (index);
+
+  gst_deinit ();
+
+  return failures > 0 ? 1 : 0;
+}
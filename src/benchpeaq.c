@@ -0,0 +1,478 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * benchpeaq.c: Benchmark for the peaq element.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Runs the peaq element on generated noise for both the basic and the
+ * advanced version and for one up to --channels channels and reports the
+ * throughput (as multiple of real-time) and the current and peak memory usage
+ * as reported by the #GstPeaq:memory property. Run with "make bench".
+ *
+ * Every configuration is run --repeat times and the time spent per processing
+ * stage (as reported by the #GstPeaq:stats property, normalized to
+ * milliseconds per second of audio) is summarized by its median and median
+ * absolute deviation (MAD). With --save-baseline, these are written to a JSON
+ * file; with --baseline, they are compared to a previously saved file and the
+ * program exits with a non-zero status if the median of any stage exceeds the
+ * baseline median by more than --threshold (relative) and at the same time by
+ * more than NOISE_FACTOR times the combined MADs, so that noisy stages do not
+ * cause spurious failures. Run with "make bench-save-baseline" and
+ * "make bench-check".
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define SAMPLES_PER_BUFFER 1024
+#define NOISE_FACTOR 3.
+/* scale factor to make the MAD a consistent estimator of the standard
+ * deviation for normally distributed data */
+#define MAD_SCALE 1.4826
+
+typedef struct _BenchResult BenchResult;
+typedef struct _Samples Samples;
+
+struct _BenchResult
+{
+  gdouble realtime_factor;
+  guint64 memory_total;
+  guint64 memory_peak;
+  guint64 memory_states;
+  guint64 memory_adapters_peak;
+  GstStructure *stats;
+};
+
+struct _Samples
+{
+  gchar *key;
+  GArray *values;
+  gdouble median;
+  gdouble mad;
+};
+
+static gint max_channels = 2;
+static gdouble duration = 10.;
+static gint repeat = 5;
+static gchar *save_baseline_file = NULL;
+static gchar *baseline_file = NULL;
+static gdouble threshold = 0.1;
+
+static GOptionEntry option_entries[] = {
+  {"channels", 'c', 0, G_OPTION_ARG_INT, &max_channels,
+   "benchmark one up to N channels (default: 2)", "N"},
+  {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+   "length of the generated signals in seconds (default: 10)", "SECONDS"},
+  {"repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+   "number of runs per configuration (default: 5)", "N"},
+  {"save-baseline", 0, 0, G_OPTION_ARG_FILENAME, &save_baseline_file,
+   "save per-stage timings to FILE", "FILE"},
+  {"baseline", 0, 0, G_OPTION_ARG_FILENAME, &baseline_file,
+   "compare per-stage timings to the ones saved in FILE", "FILE"},
+  {"threshold", 't', 0, G_OPTION_ARG_DOUBLE, &threshold,
+   "allowed relative slowdown per stage (default: 0.1)", "FRACTION"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static GstElement *
+create_pipeline (gboolean advanced, gint channels, guint num_buffers)
+{
+  GError *error = NULL;
+  GstElement *pipeline;
+  gchar *description =
+    g_strdup_printf ("peaq name=peaq advanced=%s console-output=false "
+                     "collect-stats=true stats-interval=0 "
+                     "audiotestsrc wave=white-noise num-buffers=%u "
+                     "samplesperbuffer=%u ! "
+                     "audio/x-raw,format=F32LE,rate=48000,channels=%d ! "
+                     "peaq.ref "
+                     "audiotestsrc wave=pink-noise num-buffers=%u "
+                     "samplesperbuffer=%u ! "
+                     "audio/x-raw,format=F32LE,rate=48000,channels=%d ! "
+                     "peaq.test",
+                     advanced ? "true" : "false", num_buffers,
+                     SAMPLES_PER_BUFFER, channels, num_buffers,
+                     SAMPLES_PER_BUFFER, channels);
+  pipeline = gst_parse_launch (description, &error);
+  g_free (description);
+  if (!pipeline) {
+    g_printf ("Error: could not create pipeline: %s\n", error->message);
+    g_error_free (error);
+    exit (2);
+  }
+  return pipeline;
+}
+
+static gboolean
+run_pipeline (GstElement *pipeline)
+{
+  gboolean ok = TRUE;
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    GError *err;
+    gchar *debug;
+    gst_message_parse_error (message, &err, &debug);
+    g_printf ("Error: %s\n", err->message);
+    g_error_free (err);
+    g_free (debug);
+    ok = FALSE;
+  }
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  return ok;
+}
+
+static gboolean
+run_benchmark (gboolean advanced, gint channels, BenchResult *result)
+{
+  guint num_buffers = duration * 48000 / SAMPLES_PER_BUFFER;
+  GstElement *pipeline = create_pipeline (advanced, channels, num_buffers);
+  GstElement *peaq = gst_bin_get_by_name (GST_BIN (pipeline), "peaq");
+  GstStructure *memory;
+  gint64 start_time;
+  gint64 end_time;
+  gboolean ok;
+
+  start_time = g_get_monotonic_time ();
+  ok = run_pipeline (pipeline);
+  end_time = g_get_monotonic_time ();
+
+  /* query before stopping, which flushes the adapters */
+  g_object_get (peaq, "memory", &memory, NULL);
+  gst_structure_get_uint64 (memory, "total", &result->memory_total);
+  gst_structure_get_uint64 (memory, "peak-total", &result->memory_peak);
+  gst_structure_get_uint64 (memory, "ear-model-states",
+                            &result->memory_states);
+  gst_structure_get_uint64 (memory, "peak-adapters",
+                            &result->memory_adapters_peak);
+  gst_structure_free (memory);
+  g_object_get (peaq, "stats", &result->stats, NULL);
+
+  result->realtime_factor = (gdouble) num_buffers * SAMPLES_PER_BUFFER /
+    48000. / ((end_time - start_time) * 1e-6);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (peaq);
+  gst_object_unref (pipeline);
+
+  return ok;
+}
+
+static gint
+compare_doubles (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  gdouble x = *(gdouble const *) a;
+  gdouble y = *(gdouble const *) b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static gdouble
+median (GArray *values)
+{
+  gdouble *sorted = g_new (gdouble, values->len);
+  gdouble result;
+  memcpy (sorted, values->data, values->len * sizeof (gdouble));
+  g_qsort_with_data (sorted, values->len, sizeof (gdouble), compare_doubles,
+                     NULL);
+  if (values->len % 2)
+    result = sorted[values->len / 2];
+  else
+    result = 0.5 * (sorted[values->len / 2 - 1] + sorted[values->len / 2]);
+  g_free (sorted);
+  return result;
+}
+
+static void
+samples_free (gpointer data)
+{
+  Samples *samples = data;
+  g_free (samples->key);
+  g_array_free (samples->values, TRUE);
+  g_free (samples);
+}
+
+static void
+add_sample (GPtrArray *all_samples, GHashTable *index, gchar *key,
+            gdouble value)
+{
+  Samples *samples = g_hash_table_lookup (index, key);
+  if (!samples) {
+    samples = g_new0 (Samples, 1);
+    samples->key = key;
+    samples->values = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    g_ptr_array_add (all_samples, samples);
+    g_hash_table_insert (index, samples->key, samples);
+  } else {
+    g_free (key);
+  }
+  g_array_append_val (samples->values, value);
+}
+
+/*
+ * add_stage_samples:
+ * @all_samples: Array of #Samples in the order of first occurrence.
+ * @index: Hash table mapping the keys to the entries of @all_samples.
+ * @advanced: Whether the advanced version was benchmarked.
+ * @channels: Number of channels benchmarked.
+ * @result: The #BenchResult of the run.
+ *
+ * Adds the time of every stage found in the stats of @result and the total
+ * time, in milliseconds per second of audio, to the samples with keys of the
+ * form mode/channels/stage.
+ */
+static void
+add_stage_samples (GPtrArray *all_samples, GHashTable *index,
+                   gboolean advanced, gint channels, BenchResult *result)
+{
+  gint i;
+  gchar const *mode = advanced ? "advanced" : "basic";
+  for (i = 0; i < gst_structure_n_fields (result->stats); i++) {
+    gchar const *name = gst_structure_nth_field_name (result->stats, i);
+    guint64 time;
+    if (g_str_has_suffix (name, "-time") &&
+        gst_structure_get_uint64 (result->stats, name, &time)) {
+      gchar *key = g_strdup_printf ("%s/%d/%.*s", mode, channels,
+                                    (gint) strlen (name) - 5, name);
+      add_sample (all_samples, index, key, time * 1e-6 / duration);
+    }
+  }
+  add_sample (all_samples, index,
+              g_strdup_printf ("%s/%d/total", mode, channels),
+              1000. / result->realtime_factor);
+}
+
+static void
+summarize_samples (GPtrArray *all_samples)
+{
+  guint i, j;
+  for (i = 0; i < all_samples->len; i++) {
+    Samples *samples = g_ptr_array_index (all_samples, i);
+    GArray *deviations = g_array_sized_new (FALSE, FALSE, sizeof (gdouble),
+                                            samples->values->len);
+    samples->median = median (samples->values);
+    for (j = 0; j < samples->values->len; j++) {
+      gdouble deviation =
+        fabs (g_array_index (samples->values, gdouble, j) - samples->median);
+      g_array_append_val (deviations, deviation);
+    }
+    samples->mad = median (deviations);
+    g_array_free (deviations, TRUE);
+  }
+}
+
+static gboolean
+save_baseline (gchar const *filename, GPtrArray *all_samples)
+{
+  guint i;
+  gboolean ok;
+  GError *error = NULL;
+  GString *json = g_string_new ("{\n  \"unit\": \"ms per second of audio\",\n"
+                                "  \"stages\": {\n");
+  for (i = 0; i < all_samples->len; i++) {
+    Samples *samples = g_ptr_array_index (all_samples, i);
+    gchar median_str[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar mad_str[G_ASCII_DTOSTR_BUF_SIZE];
+    g_ascii_dtostr (median_str, sizeof (median_str), samples->median);
+    g_ascii_dtostr (mad_str, sizeof (mad_str), samples->mad);
+    g_string_append_printf (json,
+                            "    \"%s\": {\"median\": %s, \"mad\": %s}%s\n",
+                            samples->key, median_str, mad_str,
+                            i + 1 < all_samples->len ? "," : "");
+  }
+  g_string_append (json, "  }\n}\n");
+  ok = g_file_set_contents (filename, json->str, json->len, &error);
+  if (!ok) {
+    g_printf ("Error: could not save baseline: %s\n", error->message);
+    g_error_free (error);
+  }
+  g_string_free (json, TRUE);
+  return ok;
+}
+
+/*
+ * load_baseline:
+ * @filename: Name of a file written by save_baseline().
+ *
+ * Reads the per-stage medians and MADs from @filename. Only the line-oriented
+ * layout written by save_baseline() is understood, not arbitrary JSON.
+ *
+ * Returns: A hash table mapping the keys to #Samples with empty values or
+ * %NULL if the file could not be read.
+ */
+static GHashTable *
+load_baseline (gchar const *filename)
+{
+  GError *error = NULL;
+  gchar *contents;
+  gchar **lines;
+  gchar **line;
+  GHashTable *baseline;
+
+  if (!g_file_get_contents (filename, &contents, NULL, &error)) {
+    g_printf ("Error: could not load baseline: %s\n", error->message);
+    g_error_free (error);
+    return NULL;
+  }
+  baseline = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                    samples_free);
+  lines = g_strsplit (contents, "\n", 0);
+  for (line = lines; *line; line++) {
+    gchar *key_start = strchr (*line, '"');
+    gchar *key_end = key_start ? strchr (key_start + 1, '"') : NULL;
+    gchar *median_str = strstr (*line, "\"median\":");
+    gchar *mad_str = strstr (*line, "\"mad\":");
+    Samples *samples;
+    if (!key_end || !median_str || !mad_str)
+      continue;
+    samples = g_new0 (Samples, 1);
+    samples->key = g_strndup (key_start + 1, key_end - key_start - 1);
+    samples->values = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    samples->median = g_ascii_strtod (median_str + strlen ("\"median\":"),
+                                      NULL);
+    samples->mad = g_ascii_strtod (mad_str + strlen ("\"mad\":"), NULL);
+    g_hash_table_replace (baseline, samples->key, samples);
+  }
+  g_strfreev (lines);
+  g_free (contents);
+  return baseline;
+}
+
+static gboolean
+compare_to_baseline (GPtrArray *all_samples, GHashTable *baseline)
+{
+  guint i;
+  gboolean ok = TRUE;
+  g_printf ("\n%-40s %12s %12s %9s\n", "stage [ms per s]", "baseline",
+            "current", "change");
+  for (i = 0; i < all_samples->len; i++) {
+    Samples *samples = g_ptr_array_index (all_samples, i);
+    Samples *base = g_hash_table_lookup (baseline, samples->key);
+    gdouble difference;
+    gboolean regressed;
+    if (!base || base->median <= 0.)
+      continue;
+    difference = samples->median - base->median;
+    regressed = difference > threshold * base->median &&
+      difference > NOISE_FACTOR * MAD_SCALE * (base->mad + samples->mad);
+    g_printf ("%-40s %12.3f %12.3f %+8.1f%%%s\n", samples->key, base->median,
+              samples->median, 100. * difference / base->median,
+              regressed ? "  REGRESSION" : "");
+    if (regressed)
+      ok = FALSE;
+  }
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gint advanced;
+  gint channels;
+  gboolean ok = TRUE;
+  GPtrArray *all_samples;
+  GHashTable *index;
+  GHashTable *baseline = NULL;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "benchpeaq measures throughput and memory usage of the peaq element.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (repeat < 1) {
+    g_printf ("Error: at least one run per configuration is required\n");
+    return 1;
+  }
+  if (baseline_file) {
+    baseline = load_baseline (baseline_file);
+    if (!baseline)
+      return 1;
+  }
+
+  all_samples = g_ptr_array_new_with_free_func (samples_free);
+  index = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_printf ("%-9s %8s %10s %14s %14s %14s %14s\n", "mode", "channels",
+            "realtime", "states [kB]", "adapters [kB]", "total [kB]",
+            "peak [kB]");
+  for (advanced = 0; advanced <= 1; advanced++) {
+    for (channels = 1; channels <= max_channels; channels++) {
+      BenchResult result;
+      GArray *realtime_factors = g_array_new (FALSE, FALSE, sizeof (gdouble));
+      gint run;
+      for (run = 0; run < repeat; run++) {
+        if (!run_benchmark (advanced, channels, &result)) {
+          ok = FALSE;
+          gst_structure_free (result.stats);
+          break;
+        }
+        g_array_append_val (realtime_factors, result.realtime_factor);
+        add_stage_samples (all_samples, index, advanced, channels, &result);
+        gst_structure_free (result.stats);
+      }
+      if (run == repeat)
+        g_printf ("%-9s %8d %9.1fx %14.1f %14.1f %14.1f %14.1f\n",
+                  advanced ? "advanced" : "basic", channels,
+                  median (realtime_factors), result.memory_states / 1024.,
+                  result.memory_adapters_peak / 1024.,
+                  result.memory_total / 1024., result.memory_peak / 1024.);
+      g_array_free (realtime_factors, TRUE);
+    }
+  }
+
+  summarize_samples (all_samples);
+  if (ok && save_baseline_file)
+    ok = save_baseline (save_baseline_file, all_samples);
+  if (baseline) {
+    if (!compare_to_baseline (all_samples, baseline)) {
+      g_printf ("\nFAILED: performance regressed by more than %.0f%%\n",
+                100. * threshold);
+      ok = FALSE;
+    }
+    g_hash_table_unref (baseline);
+  }
+
+  g_hash_table_unref (index);
+  g_ptr_array_unref (all_samples);
+
+  gst_deinit ();
+
+  return ok ? 0 : 1;
+}
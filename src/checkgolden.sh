@@ -0,0 +1,16 @@
+#!/bin/bash
+
+BASEDIR=`dirname $0`
+GOLDEN=${BASEDIR}/golden.trace.gz
+
+if [ ! -f $GOLDEN ]; then
+	echo "Golden trace not found, golden test NOT run."
+	exit 77
+fi
+
+TRACE=`mktemp`
+gunzip -c $GOLDEN > $TRACE
+./testgolden $TRACE
+RESULT=$?
+rm -f $TRACE
+exit $RESULT
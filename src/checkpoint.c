@@ -0,0 +1,422 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * checkpoint.c: Storage of processing state checkpoints.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:checkpoint
+ * @short_description: Storage of processing state checkpoints.
+ * @title: Checkpoints
+ *
+ * A #PeaqCheckpointFile holds the periodic #PeaqCheckpoint<!-- -->s taken
+ * during one run of the peaq element together with the per-frame
+ * contributions logged by its accumulators. When only part of an item has
+ * changed, processing can restart from the last checkpoint before the change
+ * and, once the recomputed state has converged back to a stored checkpoint
+ * after the change, the logged contributions from there on are replayed
+ * instead of processing the rest of the item again.
+ *
+ * The file starts with the eight bytes "PEAQCKP2", the last one being the
+ * format version, followed by a header (advanced flag, channels, number of
+ * accumulators, state size, accumulator size, number of checkpoints, whether
+ * a final state is present and the playback level), the accumulator logs
+ * (each preceded by its length) and the checkpoints, with the final state
+ * last. All values are stored as 64 bit little endian integers or doubles.
+ */
+
+#include "checkpoint.h"
+
+#include <glib/gstdio.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "PEAQCKP2"
+/* length of the magic without the version */
+#define CHECKPOINT_MAGIC_PREFIX 7
+
+static PeaqCheckpoint *checkpoint_new (PeaqCheckpointFile *file,
+                                       guint64 position);
+static void checkpoint_free (gpointer checkpoint);
+
+/**
+ * peaq_checkpoint_file_new:
+ * @advanced: Whether the checkpoints are from the advanced version.
+ * @channels: Number of channels.
+ * @playback_level: The playback level in dB SPL.
+ * @accum_count: Number of accumulators.
+ * @state_size: Number of values describing the processing state.
+ * @accum_size: Number of values describing the accumulator states.
+ *
+ * Creates an empty #PeaqCheckpointFile with one empty log per accumulator.
+ *
+ * Returns: The new #PeaqCheckpointFile.
+ */
+PeaqCheckpointFile *
+peaq_checkpoint_file_new (gboolean advanced, guint channels,
+                          gdouble playback_level, guint accum_count,
+                          gsize state_size, gsize accum_size)
+{
+  guint i;
+  PeaqCheckpointFile *file = g_new (PeaqCheckpointFile, 1);
+  file->advanced = advanced;
+  file->channels = channels;
+  file->playback_level = playback_level;
+  file->accum_count = accum_count;
+  file->state_size = state_size;
+  file->accum_size = accum_size;
+  file->checkpoints = g_ptr_array_new_with_free_func (checkpoint_free);
+  file->final = NULL;
+  file->logs = g_new (GArray *, accum_count);
+  for (i = 0; i < accum_count; i++)
+    file->logs[i] = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  return file;
+}
+
+/**
+ * peaq_checkpoint_file_free:
+ * @file: The #PeaqCheckpointFile to free.
+ *
+ * Frees @file including all checkpoints. The logs are unreferenced, so they
+ * stay valid as long as an accumulator still logs to them.
+ */
+void
+peaq_checkpoint_file_free (PeaqCheckpointFile *file)
+{
+  guint i;
+  g_ptr_array_unref (file->checkpoints);
+  if (file->final)
+    checkpoint_free (file->final);
+  for (i = 0; i < file->accum_count; i++)
+    g_array_unref (file->logs[i]);
+  g_free (file->logs);
+  g_free (file);
+}
+
+static PeaqCheckpoint *
+checkpoint_new (PeaqCheckpointFile *file, guint64 position)
+{
+  PeaqCheckpoint *checkpoint = g_new0 (PeaqCheckpoint, 1);
+  checkpoint->position = position;
+  checkpoint->loudness_reached_frame = G_MAXUINT;
+  checkpoint->log_positions = g_new0 (guint64, file->accum_count);
+  checkpoint->state = g_new0 (gdouble, file->state_size);
+  checkpoint->accum = g_new0 (gdouble, file->accum_size);
+  return checkpoint;
+}
+
+static void
+checkpoint_free (gpointer checkpoint)
+{
+  g_free (((PeaqCheckpoint *) checkpoint)->log_positions);
+  g_free (((PeaqCheckpoint *) checkpoint)->state);
+  g_free (((PeaqCheckpoint *) checkpoint)->accum);
+  g_free (checkpoint);
+}
+
+/**
+ * peaq_checkpoint_file_add:
+ * @file: The #PeaqCheckpointFile to add a checkpoint to.
+ * @position: The position of the checkpoint, which has to be larger than
+ * that of all checkpoints added before.
+ *
+ * Appends a new checkpoint and sets the positions of the logs to their
+ * current lengths. The remaining fields have to be filled in by the caller.
+ *
+ * Returns: The new #PeaqCheckpoint, owned by @file.
+ */
+PeaqCheckpoint *
+peaq_checkpoint_file_add (PeaqCheckpointFile *file, guint64 position)
+{
+  guint i;
+  PeaqCheckpoint *checkpoint = checkpoint_new (file, position);
+  for (i = 0; i < file->accum_count; i++)
+    checkpoint->log_positions[i] = file->logs[i]->len;
+  g_ptr_array_add (file->checkpoints, checkpoint);
+  return checkpoint;
+}
+
+/**
+ * peaq_checkpoint_file_set_final:
+ * @file: The #PeaqCheckpointFile to set the final state of.
+ * @position: The end of the processed data.
+ *
+ * Like peaq_checkpoint_file_add(), but for the state at the end of the item,
+ * replacing any previously set final state.
+ *
+ * Returns: The new #PeaqCheckpoint, owned by @file.
+ */
+PeaqCheckpoint *
+peaq_checkpoint_file_set_final (PeaqCheckpointFile *file, guint64 position)
+{
+  guint i;
+  if (file->final)
+    checkpoint_free (file->final);
+  file->final = checkpoint_new (file, position);
+  for (i = 0; i < file->accum_count; i++)
+    file->final->log_positions[i] = file->logs[i]->len;
+  return file->final;
+}
+
+/**
+ * peaq_checkpoint_file_find_before:
+ * @file: The #PeaqCheckpointFile to search.
+ * @position: The position to search for.
+ *
+ * Returns: The last #PeaqCheckpoint with a position of at most @position or
+ * %NULL if there is none.
+ */
+PeaqCheckpoint *
+peaq_checkpoint_file_find_before (PeaqCheckpointFile *file, guint64 position)
+{
+  guint i;
+  PeaqCheckpoint *found = NULL;
+  for (i = 0; i < file->checkpoints->len; i++) {
+    PeaqCheckpoint *checkpoint = g_ptr_array_index (file->checkpoints, i);
+    if (checkpoint->position > position)
+      break;
+    found = checkpoint;
+  }
+  return found;
+}
+
+static void
+write_values (FILE *out, guint64 const *values, gsize count)
+{
+  gsize i;
+  for (i = 0; i < count; i++) {
+    guint64 value_le = GUINT64_TO_LE (values[i]);
+    fwrite (&value_le, 8, 1, out);
+  }
+}
+
+static void
+write_doubles (FILE *out, gdouble const *values, gsize count)
+{
+  gsize i;
+  for (i = 0; i < count; i++) {
+    guint64 bits;
+    memcpy (&bits, values + i, 8);
+    write_values (out, &bits, 1);
+  }
+}
+
+static gboolean
+read_values (FILE *in, guint64 *values, gsize count)
+{
+  gsize i;
+  for (i = 0; i < count; i++) {
+    guint64 value_le;
+    if (fread (&value_le, 8, 1, in) != 1)
+      return FALSE;
+    values[i] = GUINT64_FROM_LE (value_le);
+  }
+  return TRUE;
+}
+
+static gboolean
+read_doubles (FILE *in, gdouble *values, gsize count)
+{
+  gsize i;
+  for (i = 0; i < count; i++) {
+    guint64 bits;
+    if (!read_values (in, &bits, 1))
+      return FALSE;
+    memcpy (values + i, &bits, 8);
+  }
+  return TRUE;
+}
+
+static void
+write_checkpoint (FILE *out, PeaqCheckpointFile *file,
+                  PeaqCheckpoint *checkpoint)
+{
+  guint64 header[4];
+  header[0] = checkpoint->position;
+  header[1] = checkpoint->frame_counter;
+  header[2] = checkpoint->frame_counter_fb;
+  header[3] = checkpoint->loudness_reached_frame;
+  write_values (out, header, 4);
+  write_doubles (out, &checkpoint->total_signal_energy, 1);
+  write_doubles (out, &checkpoint->total_noise_energy, 1);
+  write_values (out, checkpoint->log_positions, file->accum_count);
+  write_doubles (out, checkpoint->state, file->state_size);
+  write_doubles (out, checkpoint->accum, file->accum_size);
+}
+
+static PeaqCheckpoint *
+read_checkpoint (FILE *in, PeaqCheckpointFile *file)
+{
+  guint64 header[4];
+  guint i;
+  PeaqCheckpoint *checkpoint;
+  if (!read_values (in, header, 4))
+    return NULL;
+  checkpoint = checkpoint_new (file, header[0]);
+  checkpoint->frame_counter = header[1];
+  checkpoint->frame_counter_fb = header[2];
+  checkpoint->loudness_reached_frame = header[3];
+  if (!read_doubles (in, &checkpoint->total_signal_energy, 1) ||
+      !read_doubles (in, &checkpoint->total_noise_energy, 1) ||
+      !read_values (in, checkpoint->log_positions, file->accum_count) ||
+      !read_doubles (in, checkpoint->state, file->state_size) ||
+      !read_doubles (in, checkpoint->accum, file->accum_size)) {
+    checkpoint_free (checkpoint);
+    return NULL;
+  }
+  for (i = 0; i < file->accum_count; i++)
+    if (checkpoint->log_positions[i] > file->logs[i]->len) {
+      checkpoint_free (checkpoint);
+      return NULL;
+    }
+  return checkpoint;
+}
+
+/**
+ * peaq_checkpoint_file_write:
+ * @file: The #PeaqCheckpointFile to write.
+ * @filename: Name of the file to write to.
+ *
+ * Returns: %TRUE on success, %FALSE if @filename could not be written.
+ */
+gboolean
+peaq_checkpoint_file_write (PeaqCheckpointFile *file, gchar const *filename)
+{
+  guint64 header[7];
+  guint i;
+  gboolean ok;
+  FILE *out = g_fopen (filename, "wb");
+  if (!out)
+    return FALSE;
+  fwrite (CHECKPOINT_MAGIC, 1, strlen (CHECKPOINT_MAGIC), out);
+  header[0] = file->advanced;
+  header[1] = file->channels;
+  header[2] = file->accum_count;
+  header[3] = file->state_size;
+  header[4] = file->accum_size;
+  header[5] = file->checkpoints->len;
+  header[6] = file->final != NULL;
+  write_values (out, header, 7);
+  write_doubles (out, &file->playback_level, 1);
+  for (i = 0; i < file->accum_count; i++) {
+    guint64 len = file->logs[i]->len;
+    write_values (out, &len, 1);
+    write_doubles (out, (gdouble *) file->logs[i]->data, len);
+  }
+  for (i = 0; i < file->checkpoints->len; i++)
+    write_checkpoint (out, file, g_ptr_array_index (file->checkpoints, i));
+  if (file->final)
+    write_checkpoint (out, file, file->final);
+  ok = !ferror (out);
+  if (fclose (out) != 0)
+    ok = FALSE;
+  return ok;
+}
+
+/**
+ * peaq_checkpoint_file_read:
+ * @filename: Name of a file written with peaq_checkpoint_file_write().
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Returns: The #PeaqCheckpointFile read or %NULL if @filename could not be
+ * opened or is not a complete checkpoint file.
+ */
+PeaqCheckpointFile *
+peaq_checkpoint_file_read (gchar const *filename, GError **error)
+{
+  gchar magic[8];
+  guint64 header[7];
+  gdouble playback_level;
+  guint64 i;
+  PeaqCheckpointFile *file = NULL;
+  FILE *in = g_fopen (filename, "rb");
+  if (!in) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "could not open %s", filename);
+    return NULL;
+  }
+  if (fread (magic, 1, sizeof (magic), in) != sizeof (magic) ||
+      memcmp (magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_PREFIX) != 0)
+    goto invalid;
+  if (magic[CHECKPOINT_MAGIC_PREFIX] !=
+      CHECKPOINT_MAGIC[CHECKPOINT_MAGIC_PREFIX]) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "%s was written in checkpoint format version %c, expected %c",
+                 filename, magic[CHECKPOINT_MAGIC_PREFIX],
+                 CHECKPOINT_MAGIC[CHECKPOINT_MAGIC_PREFIX]);
+    fclose (in);
+    return NULL;
+  }
+  if (!read_values (in, header, 7) || !read_doubles (in, &playback_level, 1))
+    goto invalid;
+
+  file = peaq_checkpoint_file_new (header[0], header[1], playback_level,
+                                   header[2], header[3], header[4]);
+  for (i = 0; i < file->accum_count; i++) {
+    guint64 len;
+    if (!read_values (in, &len, 1))
+      goto invalid;
+    g_array_set_size (file->logs[i], len);
+    if (!read_doubles (in, (gdouble *) file->logs[i]->data, len))
+      goto invalid;
+  }
+  for (i = 0; i < header[5]; i++) {
+    PeaqCheckpoint *checkpoint = read_checkpoint (in, file);
+    if (!checkpoint)
+      goto invalid;
+    g_ptr_array_add (file->checkpoints, checkpoint);
+  }
+  if (header[6]) {
+    file->final = read_checkpoint (in, file);
+    if (!file->final)
+      goto invalid;
+  }
+  fclose (in);
+  return file;
+
+invalid:
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+               "%s is not a complete checkpoint file", filename);
+  if (file)
+    peaq_checkpoint_file_free (file);
+  fclose (in);
+  return NULL;
+}
+
+/**
+ * peaq_checkpoint_converged:
+ * @stored: The state stored in a #PeaqCheckpoint.
+ * @state: The current state.
+ * @size: Number of values in @stored and @state.
+ * @tolerance: Maximum allowed relative difference.
+ *
+ * Returns: %TRUE if all values of @state differ from those in @stored by at
+ * most @tolerance relative to the larger magnitude.
+ */
+gboolean
+peaq_checkpoint_converged (gdouble const *stored, gdouble const *state,
+                           gsize size, gdouble tolerance)
+{
+  gsize i;
+  for (i = 0; i < size; i++)
+    if (fabs (state[i] - stored[i]) >
+        tolerance * MAX (fabs (state[i]), fabs (stored[i])))
+      return FALSE;
+  return TRUE;
+}
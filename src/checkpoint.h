@@ -0,0 +1,113 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * checkpoint.h: Storage of processing state checkpoints.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__ 1
+
+#include <glib.h>
+
+typedef struct _PeaqCheckpoint PeaqCheckpoint;
+typedef struct _PeaqCheckpointFile PeaqCheckpointFile;
+
+/**
+ * PeaqCheckpoint:
+ * @position: Position in samples (per channel) up to which all frames have
+ * been processed, i.e. the start of the next frame.
+ * @frame_counter: Number of FFT frames processed.
+ * @frame_counter_fb: Number of filter bank frames processed.
+ * @loudness_reached_frame: Frame in which the loudness threshold was reached
+ * or G_MAXUINT.
+ * @total_signal_energy: Accumulated reference signal energy.
+ * @total_noise_energy: Accumulated noise energy.
+ * @log_positions: Length of each accumulator log at @position.
+ * @state: The processing state (ear models, level adapters and modulation
+ * processors).
+ * @accum: The accumulator states.
+ *
+ * The state of the peaq element after processing all frames starting before
+ * @position.
+ */
+struct _PeaqCheckpoint
+{
+  guint64 position;
+  guint frame_counter;
+  guint frame_counter_fb;
+  guint loudness_reached_frame;
+  gdouble total_signal_energy;
+  gdouble total_noise_energy;
+  guint64 *log_positions;
+  gdouble *state;
+  gdouble *accum;
+};
+
+/**
+ * PeaqCheckpointFile:
+ * @advanced: Whether the checkpoints are from the advanced version.
+ * @channels: Number of channels.
+ * @playback_level: The playback level in dB SPL the checkpoints were taken
+ * at.
+ * @accum_count: Number of accumulators (and accumulator logs).
+ * @state_size: Number of values in #PeaqCheckpoint.state.
+ * @accum_size: Number of values in #PeaqCheckpoint.accum.
+ * @checkpoints: The periodic #PeaqCheckpoint<!-- -->s in ascending order of
+ * their positions.
+ * @final: The state at the end of the item, including the final flush, or
+ * %NULL.
+ * @logs: The contributions logged by each accumulator, see
+ * peaq_movaccum_set_log().
+ *
+ * A set of checkpoints of one run of the peaq element.
+ */
+struct _PeaqCheckpointFile
+{
+  gboolean advanced;
+  guint channels;
+  gdouble playback_level;
+  guint accum_count;
+  gsize state_size;
+  gsize accum_size;
+  GPtrArray *checkpoints;
+  PeaqCheckpoint *final;
+  GArray **logs;
+};
+
+PeaqCheckpointFile *peaq_checkpoint_file_new (gboolean advanced,
+                                              guint channels,
+                                              gdouble playback_level,
+                                              guint accum_count,
+                                              gsize state_size,
+                                              gsize accum_size);
+void peaq_checkpoint_file_free (PeaqCheckpointFile *file);
+PeaqCheckpoint *peaq_checkpoint_file_add (PeaqCheckpointFile *file,
+                                          guint64 position);
+PeaqCheckpoint *peaq_checkpoint_file_set_final (PeaqCheckpointFile *file,
+                                                guint64 position);
+PeaqCheckpoint *peaq_checkpoint_file_find_before (PeaqCheckpointFile *file,
+                                                  guint64 position);
+gboolean peaq_checkpoint_file_write (PeaqCheckpointFile *file,
+                                     gchar const *filename);
+PeaqCheckpointFile *peaq_checkpoint_file_read (gchar const *filename,
+                                               GError **error);
+gboolean peaq_checkpoint_converged (gdouble const *stored,
+                                    gdouble const *state, gsize size,
+                                    gdouble tolerance);
+
+#endif
@@ -245,6 +245,119 @@ peaq_earmodel_get_unsmeared_excitation (PeaqEarModel const *model,
                                                                     state);
 }
 
+/**
+ * peaq_earmodel_get_state_size:
+ * @model: The #PeaqEarModel to determine the state data size of.
+ *
+ * Returns the number of bytes allocated by peaq_earmodel_state_alloc() for
+ * one instance of state data with the current number of bands.
+ *
+ * Returns: The size of the state data in bytes.
+ */
+gsize
+peaq_earmodel_get_state_size (PeaqEarModel const *model)
+{
+  return PEAQ_EARMODEL_GET_CLASS (model)->get_state_size (model);
+}
+
+/**
+ * peaq_earmodel_get_memory_size:
+ * @model: The #PeaqEarModel to determine the memory usage of.
+ *
+ * Returns the number of bytes allocated for @model itself, i.e. the instance
+ * structure, the per-band parameters and any data pre-computed by the derived
+ * class. Memory allocated for state data is not included; see
+ * peaq_earmodel_get_state_size() for that.
+ *
+ * Returns: The memory used by @model in bytes.
+ */
+gsize
+peaq_earmodel_get_memory_size (PeaqEarModel const *model)
+{
+  /* fc, internal_noise, ear_time_constants, excitation_threshold, threshold
+   * and loudness_factor */
+  return 6 * model->band_count * sizeof (gdouble) +
+    PEAQ_EARMODEL_GET_CLASS (model)->get_memory_size (model);
+}
+
+/**
+ * peaq_earmodel_get_checkpoint_size:
+ * @model: The #PeaqEarModel to determine the checkpoint size of.
+ *
+ * Returns the number of values written by
+ * peaq_earmodel_state_save_checkpoint() for one instance of state data with
+ * the current number of bands.
+ *
+ * Returns: The number of values in a checkpoint of the state data.
+ */
+gsize
+peaq_earmodel_get_checkpoint_size (PeaqEarModel const *model)
+{
+  return PEAQ_EARMODEL_GET_CLASS (model)->get_checkpoint_size (model);
+}
+
+/**
+ * peaq_earmodel_state_save_checkpoint:
+ * @model: The #PeaqEarModel the state belongs to.
+ * @state: The state data to save.
+ * @data: Array of peaq_earmodel_get_checkpoint_size() values to write to.
+ *
+ * Copies the part of @state which is carried over from one frame to the next
+ * (e.g. filter memories and time-smoothed excitations) to @data. Values only
+ * derived from the current frame are not included, so restoring the
+ * checkpoint with peaq_earmodel_state_restore_checkpoint() and processing the
+ * following frames gives the same results as continuing with @state.
+ */
+void
+peaq_earmodel_state_save_checkpoint (PeaqEarModel const *model,
+                                     gpointer state, gdouble *data)
+{
+  PEAQ_EARMODEL_GET_CLASS (model)->state_save_checkpoint (model, state, data);
+}
+
+/**
+ * peaq_earmodel_state_restore_checkpoint:
+ * @model: The #PeaqEarModel the state belongs to.
+ * @state: The state data to restore.
+ * @data: Array of peaq_earmodel_get_checkpoint_size() values as written by
+ * peaq_earmodel_state_save_checkpoint().
+ *
+ * Sets the part of @state which is carried over from one frame to the next
+ * from @data.
+ */
+void
+peaq_earmodel_state_restore_checkpoint (PeaqEarModel const *model,
+                                        gpointer state, gdouble const *data)
+{
+  PEAQ_EARMODEL_GET_CLASS (model)->state_restore_checkpoint (model, state,
+                                                             data);
+}
+
+/**
+ * peaq_earmodel_state_set_excitation:
+ * @model: The #PeaqEarModel the state belongs to.
+ * @state: The state data to modify.
+ * @excitation: Array of peaq_earmodel_get_band_count() values to use as
+ * excitation or %NULL to leave the excitation unchanged.
+ * @unsmeared_excitation: Array of peaq_earmodel_get_band_count() values to use
+ * as unsmeared excitation or %NULL to leave it unchanged.
+ *
+ * Overwrites the excitation patterns of @state as if they had been computed
+ * by the last call to peaq_earmodel_process_block(). This allows to re-run
+ * the subsequent processing stages from previously stored excitation
+ * patterns without applying the ear model again. Processing further blocks
+ * with @state afterwards gives undefined results.
+ */
+void
+peaq_earmodel_state_set_excitation (PeaqEarModel const *model, gpointer state,
+                                    gdouble const *excitation,
+                                    gdouble const *unsmeared_excitation)
+{
+  PEAQ_EARMODEL_GET_CLASS (model)->state_set_excitation (model, state,
+                                                         excitation,
+                                                         unsmeared_excitation);
+}
+
 /**
  * peaq_earmodel_get_band_count:
  * @model: The #PeaqEarModel to obtain the number of bands of.
@@ -132,6 +132,24 @@ struct _PeaqEarModel
  * @get_unsmeared_excitation: Function to obtain the current unsmeared
  * excitation from the state, called by
  * peaq_earmodel_get_unsmeared_excitation().
+ * @get_state_size: Function to determine the number of bytes allocated by
+ * @state_alloc, called by peaq_earmodel_get_state_size().
+ * @get_memory_size: Function to determine the number of bytes allocated for
+ * the instance of the derived class, including any pre-computed data, but
+ * excluding the fields of #PeaqEarModel, called by
+ * peaq_earmodel_get_memory_size().
+ * @get_checkpoint_size: Function to determine the number of values needed to
+ * store the part of the state carried over from one frame to the next, called
+ * by peaq_earmodel_get_checkpoint_size().
+ * @state_save_checkpoint: Function to copy the carried-over part of the state
+ * to an array of @get_checkpoint_size values, called by
+ * peaq_earmodel_state_save_checkpoint().
+ * @state_restore_checkpoint: Function to set the carried-over part of the
+ * state from values stored with @state_save_checkpoint, called by
+ * peaq_earmodel_state_restore_checkpoint().
+ * @state_set_excitation: Function to overwrite the current excitation and
+ * unsmeared excitation of the state, called by
+ * peaq_earmodel_state_set_excitation().
  *
  * Derived classes must provide values for all fields of #PeaqEarModelClass
  * (except for <structfield>parent</structfield>).
@@ -153,6 +171,16 @@ struct _PeaqEarModelClass
   gdouble const *(*get_excitation) (PeaqEarModel const *model, gpointer state);
   gdouble const *(*get_unsmeared_excitation) (PeaqEarModel const *model,
                                               gpointer state);
+  gsize (*get_state_size) (PeaqEarModel const *model);
+  gsize (*get_memory_size) (PeaqEarModel const *model);
+  gsize (*get_checkpoint_size) (PeaqEarModel const *model);
+  void (*state_save_checkpoint) (PeaqEarModel const *model, gpointer state,
+                                 gdouble *data);
+  void (*state_restore_checkpoint) (PeaqEarModel const *model, gpointer state,
+                                    gdouble const *data);
+  void (*state_set_excitation) (PeaqEarModel const *model, gpointer state,
+                                gdouble const *excitation,
+                                gdouble const *unsmeared_excitation);
 };
 
 GType peaq_earmodel_get_type ();
@@ -180,5 +208,17 @@ gdouble peaq_earmodel_calc_time_constant (PeaqEarModel const *model,
 gdouble peaq_earmodel_calc_ear_weight (gdouble frequency);
 gdouble peaq_earmodel_calc_loudness (PeaqEarModel const *model,
                                      gpointer state);
+gsize peaq_earmodel_get_state_size (PeaqEarModel const *model);
+gsize peaq_earmodel_get_memory_size (PeaqEarModel const *model);
+gsize peaq_earmodel_get_checkpoint_size (PeaqEarModel const *model);
+void peaq_earmodel_state_save_checkpoint (PeaqEarModel const *model,
+                                          gpointer state, gdouble *data);
+void peaq_earmodel_state_restore_checkpoint (PeaqEarModel const *model,
+                                             gpointer state,
+                                             gdouble const *data);
+void peaq_earmodel_state_set_excitation (PeaqEarModel const *model,
+                                         gpointer state,
+                                         gdouble const *excitation,
+                                         gdouble const *unsmeared_excitation);
 
 #endif
@@ -0,0 +1,187 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * exportpeaq.c: Export of frame trace columns to NumPy files.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Lists the tables and columns of a frame trace written by the peaq element
+ * (frame-trace-file property) with --list, or writes the given columns (all
+ * if none are given) to <column>.npy in --output-dir, each as a float64 array
+ * with one row per frame.
+ */
+
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frametrace.h"
+
+#define NPY_ALIGNMENT 64
+
+static gboolean list = FALSE;
+static gchar *output_dir = ".";
+static gchar **arguments;
+
+static GOptionEntry option_entries[] = {
+  {"list", 'l', 0, G_OPTION_ARG_NONE, &list,
+   "list the tables and columns of the trace", NULL},
+  {"output-dir", 'o', 0, G_OPTION_ARG_FILENAME, &output_dir,
+   "directory to write the .npy files to (default: .)", "DIR"},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &arguments, NULL,
+   "TRACEFILE [COLUMN...]"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+/*
+ * write_npy:
+ * @filename: Name of the file to write.
+ * @values: The values in row-major order.
+ * @rows: Number of rows.
+ * @columns: Number of columns.
+ *
+ * Writes @values as two-dimensional little endian float64 array in the NumPy
+ * format version 1.0.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+write_npy (gchar const *filename, gdouble const *values, guint64 rows,
+           guint columns)
+{
+  GString *header = g_string_new (NULL);
+  guint16 header_len;
+  gboolean ok;
+  guint64 i;
+  FILE *file = g_fopen (filename, "wb");
+  if (!file) {
+    g_printf ("Error: could not open %s\n", filename);
+    return FALSE;
+  }
+  g_string_printf (header,
+                   "{'descr': '<f8', 'fortran_order': False, "
+                   "'shape': (%" G_GUINT64_FORMAT ", %u), }", rows, columns);
+  /* magic, version and length take 10 bytes, the header ends with a newline */
+  while ((10 + header->len + 1) % NPY_ALIGNMENT != 0)
+    g_string_append_c (header, ' ');
+  g_string_append_c (header, '\n');
+  header_len = GUINT16_TO_LE (header->len);
+  fwrite ("\x93NUMPY\x01\x00", 1, 8, file);
+  fwrite (&header_len, 2, 1, file);
+  fwrite (header->str, 1, header->len, file);
+  g_string_free (header, TRUE);
+  for (i = 0; i < rows * columns; i++) {
+    guint64 bits;
+    memcpy (&bits, values + i, 8);
+    bits = GUINT64_TO_LE (bits);
+    fwrite (&bits, 8, 1, file);
+  }
+  ok = !ferror (file);
+  if (fclose (file) != 0 || !ok) {
+    g_printf ("Error: could not write %s\n", filename);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+export_column (PeaqFrameTraceReader *reader, guint column)
+{
+  guint table = peaq_frametrace_reader_get_column_table (reader, column);
+  guint width = peaq_frametrace_reader_get_column_width (reader, column);
+  guint64 frames = peaq_frametrace_reader_get_frame_count (reader, table);
+  gchar const *name = peaq_frametrace_reader_get_column_name (reader, column);
+  gdouble *values = g_new (gdouble, frames * width);
+  gchar *basename = g_strconcat (name, ".npy", NULL);
+  gchar *filename = g_build_filename (output_dir, basename, NULL);
+  gboolean ok =
+    peaq_frametrace_reader_read (reader, column, 0, frames, values) &&
+    write_npy (filename, values, frames, width);
+  g_free (filename);
+  g_free (basename);
+  g_free (values);
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  PeaqFrameTraceReader *reader;
+  gboolean ok = TRUE;
+  guint i;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_set_summary (context,
+                                "exportpeaq converts the columns of a frame trace written by the peaq\n"
+                                "element to NumPy .npy files.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (arguments == NULL || arguments[0] == NULL) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  reader = peaq_frametrace_reader_new (arguments[0], &error);
+  if (!reader) {
+    g_printf ("Error: %s\n", error->message);
+    g_error_free (error);
+    return 1;
+  }
+
+  if (list) {
+    for (i = 0; i < peaq_frametrace_reader_get_table_count (reader); i++)
+      g_printf ("table %-16s hop size %5u, %" G_GUINT64_FORMAT " frames\n",
+                peaq_frametrace_reader_get_table_name (reader, i),
+                peaq_frametrace_reader_get_hop_size (reader, i),
+                peaq_frametrace_reader_get_frame_count (reader, i));
+    for (i = 0; i < peaq_frametrace_reader_get_column_count (reader); i++)
+      g_printf ("column %-40s width %5u\n",
+                peaq_frametrace_reader_get_column_name (reader, i),
+                peaq_frametrace_reader_get_column_width (reader, i));
+  } else if (arguments[1] == NULL) {
+    for (i = 0; ok && i < peaq_frametrace_reader_get_column_count (reader); i++)
+      ok = export_column (reader, i);
+  } else {
+    for (i = 1; ok && arguments[i]; i++) {
+      gint column = peaq_frametrace_reader_find_column (reader, arguments[i]);
+      if (column < 0) {
+        g_printf ("Error: no column %s in %s\n", arguments[i], arguments[0]);
+        ok = FALSE;
+      } else {
+        ok = export_column (reader, column);
+      }
+    }
+  }
+
+  peaq_frametrace_reader_free (reader);
+
+  return ok ? 0 : 1;
+}
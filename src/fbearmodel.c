@@ -120,6 +120,16 @@ static gdouble const *get_excitation (PeaqEarModel const *model,
                                       gpointer state);
 static gdouble const *get_unsmeared_excitation (PeaqEarModel const *model,
                                                 gpointer state);
+static gsize get_state_size (PeaqEarModel const *model);
+static gsize get_memory_size (PeaqEarModel const *model);
+static gsize get_checkpoint_size (PeaqEarModel const *model);
+static void state_save_checkpoint (PeaqEarModel const *model, gpointer state,
+                                   gdouble *data);
+static void state_restore_checkpoint (PeaqEarModel const *model,
+                                      gpointer state, gdouble const *data);
+static void state_set_excitation (PeaqEarModel const *model, gpointer state,
+                                  gdouble const *excitation,
+                                  gdouble const *unsmeared_excitation);
 static void apply_filter_bank (PeaqFilterbankEarModel *model,
                                PeaqFilterbankEarModelState *fb_state,
                                gdouble *fb_out_re, gdouble *fb_out_im);
@@ -168,6 +178,12 @@ class_init (gpointer klass, gpointer class_data)
   ear_model_class->process_block = process_block;
   ear_model_class->get_excitation = get_excitation;
   ear_model_class->get_unsmeared_excitation = get_unsmeared_excitation;
+  ear_model_class->get_state_size = get_state_size;
+  ear_model_class->get_memory_size = get_memory_size;
+  ear_model_class->get_checkpoint_size = get_checkpoint_size;
+  ear_model_class->state_save_checkpoint = state_save_checkpoint;
+  ear_model_class->state_restore_checkpoint = state_restore_checkpoint;
+  ear_model_class->state_set_excitation = state_set_excitation;
   ear_model_class->frame_size = FB_FRAMESIZE;
   ear_model_class->step_size = FB_FRAMESIZE;
   /* see section 3.3 in [BS1387], section 4.3 in [Kabal03] */
@@ -263,6 +279,85 @@ gpointer state_alloc (PeaqEarModel const *model)
   return state;
 }
 
+static gsize
+get_state_size (PeaqEarModel const *model)
+{
+  /* backward masking buffers E0_buf */
+  return sizeof (PeaqFilterbankEarModelState) + 40 * 11 * sizeof (gdouble);
+}
+
+static gsize
+get_memory_size (PeaqEarModel const *model)
+{
+  guint band;
+  gsize size = sizeof (PeaqFilterbankEarModel);
+  /* filter bank impulse responses fbh_re and fbh_im */
+  for (band = 0; band < 40; band++)
+    size += 2 * (filter_length[band] / 2 + 1) * sizeof (gdouble);
+  return size;
+}
+
+/* DC rejection filter memories, buffer offset, filter bank input (stored only
+ * once), slope filter states, backward masking buffers and forward masking
+ * filter states; unsmeared_excitation is recomputed for every frame */
+#define CHECKPOINT_SIZE (6 + 1 + BUFFER_LENGTH + 40 + 40 * 11 + 40)
+
+static gsize
+get_checkpoint_size (PeaqEarModel const *model)
+{
+  return CHECKPOINT_SIZE;
+}
+
+static void
+state_save_checkpoint (PeaqEarModel const *model, gpointer state,
+                       gdouble *data)
+{
+  guint band;
+  PeaqFilterbankEarModelState *fb_state = (PeaqFilterbankEarModelState *) state;
+  *data++ = fb_state->hpfilter1_x1;
+  *data++ = fb_state->hpfilter1_x2;
+  *data++ = fb_state->hpfilter1_y1;
+  *data++ = fb_state->hpfilter1_y2;
+  *data++ = fb_state->hpfilter2_y1;
+  *data++ = fb_state->hpfilter2_y2;
+  *data++ = fb_state->fb_buf_offset;
+  memcpy (data, fb_state->fb_buf, BUFFER_LENGTH * sizeof (gdouble));
+  data += BUFFER_LENGTH;
+  memcpy (data, fb_state->cu, 40 * sizeof (gdouble));
+  data += 40;
+  for (band = 0; band < 40; band++) {
+    memcpy (data, fb_state->E0_buf[band], 11 * sizeof (gdouble));
+    data += 11;
+  }
+  memcpy (data, fb_state->excitation, 40 * sizeof (gdouble));
+}
+
+static void
+state_restore_checkpoint (PeaqEarModel const *model, gpointer state,
+                          gdouble const *data)
+{
+  guint band;
+  PeaqFilterbankEarModelState *fb_state = (PeaqFilterbankEarModelState *) state;
+  fb_state->hpfilter1_x1 = *data++;
+  fb_state->hpfilter1_x2 = *data++;
+  fb_state->hpfilter1_y1 = *data++;
+  fb_state->hpfilter1_y2 = *data++;
+  fb_state->hpfilter2_y1 = *data++;
+  fb_state->hpfilter2_y2 = *data++;
+  fb_state->fb_buf_offset = *data++;
+  memcpy (fb_state->fb_buf, data, BUFFER_LENGTH * sizeof (gdouble));
+  memcpy (fb_state->fb_buf + BUFFER_LENGTH, data,
+          BUFFER_LENGTH * sizeof (gdouble));
+  data += BUFFER_LENGTH;
+  memcpy (fb_state->cu, data, 40 * sizeof (gdouble));
+  data += 40;
+  for (band = 0; band < 40; band++) {
+    memcpy (fb_state->E0_buf[band], data, 11 * sizeof (gdouble));
+    data += 11;
+  }
+  memcpy (fb_state->excitation, data, 40 * sizeof (gdouble));
+}
+
 static
 void state_free (PeaqEarModel const *model, gpointer state)
 {
@@ -445,3 +540,16 @@ get_unsmeared_excitation (PeaqEarModel const *model, gpointer state)
 {
   return ((PeaqFilterbankEarModelState *) state)->unsmeared_excitation;
 }
+
+static void
+state_set_excitation (PeaqEarModel const *model, gpointer state,
+                      gdouble const *excitation,
+                      gdouble const *unsmeared_excitation)
+{
+  PeaqFilterbankEarModelState *fb_state = (PeaqFilterbankEarModelState *) state;
+  if (excitation)
+    memcpy (fb_state->excitation, excitation, 40 * sizeof (gdouble));
+  if (unsmeared_excitation)
+    memcpy (fb_state->unsmeared_excitation, unsmeared_excitation,
+            40 * sizeof (gdouble));
+}
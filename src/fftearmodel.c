@@ -46,6 +46,7 @@
 #include "gstpeaq.h"
 
 #include <math.h>
+#include <string.h>
 #include <gst/fft/gstfftf64.h>
 
 #define FFT_FRAMESIZE 2048
@@ -119,6 +120,16 @@ static gdouble const *get_excitation (PeaqEarModel const *model,
                                       gpointer state);
 static gdouble const *get_unsmeared_excitation (PeaqEarModel const *model,
                                                 gpointer state);
+static gsize get_state_size (PeaqEarModel const *model);
+static gsize get_memory_size (PeaqEarModel const *model);
+static gsize get_checkpoint_size (PeaqEarModel const *model);
+static void state_save_checkpoint (PeaqEarModel const *model, gpointer state,
+                                   gdouble *data);
+static void state_restore_checkpoint (PeaqEarModel const *model,
+                                      gpointer state, gdouble const *data);
+static void state_set_excitation (PeaqEarModel const *model, gpointer state,
+                                  gdouble const *excitation,
+                                  gdouble const *unsmeared_excitation);
 static void do_spreading (PeaqFFTEarModel const *model, gdouble const *Pp,
                           gdouble *E2);
 static void get_property (GObject *obj, guint id, GValue *value,
@@ -220,6 +231,12 @@ class_init (gpointer klass, gpointer class_data)
   ear_model_class->process_block = process_block;
   ear_model_class->get_excitation = get_excitation;
   ear_model_class->get_unsmeared_excitation = get_unsmeared_excitation;
+  ear_model_class->get_state_size = get_state_size;
+  ear_model_class->get_memory_size = get_memory_size;
+  ear_model_class->get_checkpoint_size = get_checkpoint_size;
+  ear_model_class->state_save_checkpoint = state_save_checkpoint;
+  ear_model_class->state_restore_checkpoint = state_restore_checkpoint;
+  ear_model_class->state_set_excitation = state_set_excitation;
 
   ear_model_class->loudness_scale = LOUDNESS_SCALE;
   ear_model_class->frame_size = FFT_FRAMESIZE;
@@ -323,6 +340,49 @@ gpointer state_alloc (PeaqEarModel const *model)
   return state;
 }
 
+static gsize
+get_state_size (PeaqEarModel const *model)
+{
+  /* filtered_excitation, unsmeared_excitation and excitation */
+  return sizeof (PeaqFFTEarModelState) +
+    3 * model->band_count * sizeof (gdouble);
+}
+
+static gsize
+get_memory_size (PeaqEarModel const *model)
+{
+  /* outer_middle_ear_weight, band_lower_end, band_upper_end,
+   * band_lower_weight, band_upper_weight, spreading_normalization, aUC, gIL
+   * and masking_difference; the FFT setup is not accounted for */
+  return sizeof (PeaqFFTEarModel) +
+    (FFT_FRAMESIZE / 2 + 1) * sizeof (gdouble) +
+    2 * model->band_count * sizeof (guint) +
+    6 * model->band_count * sizeof (gdouble);
+}
+
+static gsize
+get_checkpoint_size (PeaqEarModel const *model)
+{
+  /* only the time domain spreading carries over to the next frame */
+  return model->band_count;
+}
+
+static void
+state_save_checkpoint (PeaqEarModel const *model, gpointer state,
+                       gdouble *data)
+{
+  memcpy (data, ((PeaqFFTEarModelState *) state)->filtered_excitation,
+          model->band_count * sizeof (gdouble));
+}
+
+static void
+state_restore_checkpoint (PeaqEarModel const *model, gpointer state,
+                          gdouble const *data)
+{
+  memcpy (((PeaqFFTEarModelState *) state)->filtered_excitation, data,
+          model->band_count * sizeof (gdouble));
+}
+
 static
 void state_free (PeaqEarModel const *model, gpointer state)
 {
@@ -526,6 +586,19 @@ get_unsmeared_excitation (PeaqEarModel const *model, gpointer state)
   return ((PeaqFFTEarModelState *) state)->unsmeared_excitation;
 }
 
+static void
+state_set_excitation (PeaqEarModel const *model, gpointer state,
+                      gdouble const *excitation,
+                      gdouble const *unsmeared_excitation)
+{
+  PeaqFFTEarModelState *fft_state = (PeaqFFTEarModelState *) state;
+  if (excitation)
+    memcpy (fft_state->excitation, excitation, model->band_count * sizeof (gdouble));
+  if (unsmeared_excitation)
+    memcpy (fft_state->unsmeared_excitation, unsmeared_excitation,
+            model->band_count * sizeof (gdouble));
+}
+
 /**
  * peaq_fftearmodel_get_power_spectrum:
  * @state: The #PeaqFFTEarModel's state from which to obtain the current power
@@ -586,6 +659,37 @@ peaq_fftearmodel_is_energy_threshold_reached (gpointer state)
   return ((PeaqFFTEarModelState *) state)->energy_threshold_reached;
 }
 
+/**
+ * peaq_fftearmodel_state_set_spectra:
+ * @state: The #PeaqFFTEarModel's state to modify.
+ * @power_spectrum: The power spectrum to set or %NULL to leave it unchanged.
+ * @weighted_power_spectrum: The weighted power spectrum to set or %NULL to
+ * leave it unchanged.
+ * @energy_threshold_reached: Whether the energy threshold shall be reported
+ * as reached.
+ *
+ * Overwrites the quantities returned by peaq_fftearmodel_get_power_spectrum(),
+ * peaq_fftearmodel_get_weighted_power_spectrum() and
+ * peaq_fftearmodel_is_energy_threshold_reached() as if they had been computed
+ * by the last call to peaq_earmodel_process_block(), complementing
+ * peaq_earmodel_state_set_excitation().
+ */
+void
+peaq_fftearmodel_state_set_spectra (gpointer state,
+                                    gdouble const *power_spectrum,
+                                    gdouble const *weighted_power_spectrum,
+                                    gboolean energy_threshold_reached)
+{
+  PeaqFFTEarModelState *fft_state = (PeaqFFTEarModelState *) state;
+  if (power_spectrum)
+    memcpy (fft_state->power_spectrum, power_spectrum,
+            (FFT_FRAMESIZE / 2 + 1) * sizeof (gdouble));
+  if (weighted_power_spectrum)
+    memcpy (fft_state->weighted_power_spectrum, weighted_power_spectrum,
+            (FFT_FRAMESIZE / 2 + 1) * sizeof (gdouble));
+  fft_state->energy_threshold_reached = energy_threshold_reached;
+}
+
 /**
  * peaq_fftearmodel_group_into_bands:
  * @model: the #PeaqFFTEarModel instance structure.
@@ -47,5 +47,9 @@ gdouble const *peaq_fftearmodel_get_masking_difference (PeaqFFTEarModel const *m
 gdouble const *peaq_fftearmodel_get_power_spectrum (gpointer state);
 gdouble const *peaq_fftearmodel_get_weighted_power_spectrum (gpointer state);
 gboolean peaq_fftearmodel_is_energy_threshold_reached (gpointer state);
+void peaq_fftearmodel_state_set_spectra (gpointer state,
+                                         gdouble const *power_spectrum,
+                                         gdouble const *weighted_power_spectrum,
+                                         gboolean energy_threshold_reached);
 GType peaq_fftearmodel_get_type ();
 #endif
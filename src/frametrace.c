@@ -0,0 +1,731 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * frametrace.c: Columnar binary traces of per-frame quantities.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:frametrace
+ * @short_description: Columnar binary traces of per-frame quantities.
+ * @title: Frame traces
+ *
+ * A #PeaqFrameTrace stores per-frame quantities like excitation patterns,
+ * spectra or MOV contributions in a compact binary file. The quantities are
+ * organized in tables, one per frame rate (e.g. FFT and filter bank frames),
+ * each holding a number of columns with a fixed number of doubles per frame.
+ * The frames are collected in chunks of a fixed number of frames, which are
+ * written by a separate thread; at most a given number of chunks per table
+ * are buffered, if the writer falls behind, peaq_frametrace_next_frame()
+ * blocks until a chunk becomes available again.
+ *
+ * The file starts with the eight bytes "PEAQFTR1", followed by the header
+ * size in bytes, the number of tables, the number of columns and the number
+ * of frames per chunk as 32 bit values. Then follow 24 bytes per table (a
+ * zero-padded name of 16 bytes, the hop size in samples and the number of
+ * columns) and 48 bytes per column (a zero-padded name of 40 bytes, the table
+ * and the number of values per frame). After the header, the chunks follow in
+ * the order they were completed, each with a 16 byte header (table, number of
+ * frames and the index of the first frame as 32, 32 and 64 bit values) and the
+ * data of all columns of the table one after the other, i.e. the values of
+ * one column in one chunk are contiguous. All values are little endian and
+ * the doubles are 8 byte aligned relative to the start of the file, so the
+ * file can be used memory-mapped.
+ *
+ * A #PeaqFrameTraceReader maps a trace file and provides access to the
+ * columns. A chunk at the end of the file that has not been written
+ * completely is ignored.
+ */
+
+#include "frametrace.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FRAMETRACE_MAGIC "PEAQFTR1"
+#define HEADER_SIZE 24
+#define TABLE_NAME_SIZE 16
+#define TABLE_ENTRY_SIZE 24
+#define COLUMN_NAME_SIZE 40
+#define COLUMN_ENTRY_SIZE 48
+#define CHUNK_HEADER_SIZE 16
+
+typedef struct _Chunk Chunk;
+typedef struct _Table Table;
+typedef struct _Column Column;
+typedef struct _ChunkIndex ChunkIndex;
+
+struct _Chunk
+{
+  guint table;
+  guint frames;
+  guint64 first_frame;
+  gdouble *data;
+};
+
+struct _Table
+{
+  gchar name[TABLE_NAME_SIZE + 1];
+  guint hop_size;
+  guint column_count;
+  guint width;
+  guint64 frames;
+  Chunk *chunk;
+  GAsyncQueue *free_chunks;
+  GArray *chunk_index;
+};
+
+struct _Column
+{
+  gchar name[COLUMN_NAME_SIZE + 1];
+  guint table;
+  guint width;
+  guint offset;
+};
+
+struct _ChunkIndex
+{
+  guint64 first_frame;
+  guint frames;
+  gsize offset;
+};
+
+struct _PeaqFrameTrace
+{
+  FILE *file;
+  guint frames_per_chunk;
+  guint max_chunks;
+  GArray *tables;
+  GArray *columns;
+  GAsyncQueue *full_chunks;
+  GThread *thread;
+  Chunk stop;
+  gint failed;
+};
+
+struct _PeaqFrameTraceReader
+{
+  GMappedFile *mapped;
+  guint8 const *contents;
+  GArray *tables;
+  GArray *columns;
+};
+
+static void
+write_u32 (guint8 *dest, guint32 value)
+{
+  value = GUINT32_TO_LE (value);
+  memcpy (dest, &value, 4);
+}
+
+static void
+write_u64 (guint8 *dest, guint64 value)
+{
+  value = GUINT64_TO_LE (value);
+  memcpy (dest, &value, 8);
+}
+
+static guint32
+read_u32 (guint8 const *src)
+{
+  guint32 value;
+  memcpy (&value, src, 4);
+  return GUINT32_FROM_LE (value);
+}
+
+static guint64
+read_u64 (guint8 const *src)
+{
+  guint64 value;
+  memcpy (&value, src, 8);
+  return GUINT64_FROM_LE (value);
+}
+
+static gboolean
+write_doubles (FILE *out, gdouble const *values, gsize count)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  return fwrite (values, sizeof (gdouble), count, out) == count;
+#else
+  gsize i;
+  for (i = 0; i < count; i++) {
+    guint8 bytes[8];
+    guint64 bits;
+    memcpy (&bits, values + i, 8);
+    write_u64 (bytes, bits);
+    if (fwrite (bytes, 8, 1, out) != 1)
+      return FALSE;
+  }
+  return TRUE;
+#endif
+}
+
+static gboolean
+write_chunk (PeaqFrameTrace *trace, Chunk *chunk)
+{
+  guint i;
+  guint8 header[CHUNK_HEADER_SIZE];
+  gboolean ok;
+  write_u32 (header, chunk->table);
+  write_u32 (header + 4, chunk->frames);
+  write_u64 (header + 8, chunk->first_frame);
+  ok = fwrite (header, 1, sizeof (header), trace->file) == sizeof (header);
+  for (i = 0; ok && i < trace->columns->len; i++) {
+    Column *column = &g_array_index (trace->columns, Column, i);
+    if (column->table == chunk->table)
+      ok = write_doubles (trace->file,
+                          chunk->data + column->offset * trace->frames_per_chunk,
+                          chunk->frames * column->width);
+  }
+  return ok;
+}
+
+static gpointer
+writer_thread (gpointer data)
+{
+  PeaqFrameTrace *trace = data;
+  for (;;) {
+    Chunk *chunk = g_async_queue_pop (trace->full_chunks);
+    if (chunk == &trace->stop)
+      break;
+    if (!write_chunk (trace, chunk))
+      g_atomic_int_set (&trace->failed, 1);
+    g_async_queue_push (g_array_index (trace->tables, Table,
+                                       chunk->table).free_chunks, chunk);
+  }
+  return NULL;
+}
+
+/**
+ * peaq_frametrace_new:
+ * @filename: Name of the file to write the trace to.
+ * @frames_per_chunk: Number of frames per chunk.
+ * @max_chunks: Number of chunks buffered per table, at least two.
+ *
+ * Creates a new #PeaqFrameTrace. Before writing any frames, the tables and
+ * columns have to be added with peaq_frametrace_add_table() and
+ * peaq_frametrace_add_column() and the trace has to be started with
+ * peaq_frametrace_start().
+ *
+ * Returns: The new #PeaqFrameTrace or %NULL if @filename could not be opened.
+ */
+PeaqFrameTrace *
+peaq_frametrace_new (gchar const *filename, guint frames_per_chunk,
+                     guint max_chunks)
+{
+  PeaqFrameTrace *trace;
+  FILE *file = g_fopen (filename, "wb");
+  if (!file)
+    return NULL;
+  trace = g_new0 (PeaqFrameTrace, 1);
+  trace->file = file;
+  trace->frames_per_chunk = MAX (frames_per_chunk, 1);
+  trace->max_chunks = MAX (max_chunks, 2);
+  trace->tables = g_array_new (FALSE, TRUE, sizeof (Table));
+  trace->columns = g_array_new (FALSE, TRUE, sizeof (Column));
+  return trace;
+}
+
+/**
+ * peaq_frametrace_add_table:
+ * @trace: The #PeaqFrameTrace to add the table to.
+ * @name: Name of the table, at most 16 characters are stored.
+ * @hop_size: Number of samples between two frames.
+ *
+ * Returns: The index of the new table.
+ */
+guint
+peaq_frametrace_add_table (PeaqFrameTrace *trace, gchar const *name,
+                           guint hop_size)
+{
+  Table table;
+  memset (&table, 0, sizeof (table));
+  g_strlcpy (table.name, name, sizeof (table.name));
+  table.hop_size = hop_size;
+  g_array_append_val (trace->tables, table);
+  return trace->tables->len - 1;
+}
+
+/**
+ * peaq_frametrace_add_column:
+ * @trace: The #PeaqFrameTrace to add the column to.
+ * @table: Index of the table the column belongs to.
+ * @name: Name of the column, at most 40 characters are stored.
+ * @width: Number of values per frame.
+ *
+ * Returns: The index of the new column.
+ */
+guint
+peaq_frametrace_add_column (PeaqFrameTrace *trace, guint table,
+                            gchar const *name, guint width)
+{
+  Column column;
+  Table *t = &g_array_index (trace->tables, Table, table);
+  memset (&column, 0, sizeof (column));
+  g_strlcpy (column.name, name, sizeof (column.name));
+  column.table = table;
+  column.width = width;
+  column.offset = t->width;
+  t->width += width;
+  t->column_count++;
+  g_array_append_val (trace->columns, column);
+  return trace->columns->len - 1;
+}
+
+/**
+ * peaq_frametrace_start:
+ * @trace: The #PeaqFrameTrace to start.
+ *
+ * Writes the header, allocates the chunks and starts the writer thread.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+peaq_frametrace_start (PeaqFrameTrace *trace)
+{
+  guint i, j;
+  gsize header_size = HEADER_SIZE + TABLE_ENTRY_SIZE * trace->tables->len +
+    COLUMN_ENTRY_SIZE * trace->columns->len;
+  guint8 *header = g_malloc0 (header_size);
+  guint8 *entry;
+  gboolean ok;
+
+  memcpy (header, FRAMETRACE_MAGIC, 8);
+  write_u32 (header + 8, header_size);
+  write_u32 (header + 12, trace->tables->len);
+  write_u32 (header + 16, trace->columns->len);
+  write_u32 (header + 20, trace->frames_per_chunk);
+  entry = header + HEADER_SIZE;
+  for (i = 0; i < trace->tables->len; i++) {
+    Table *table = &g_array_index (trace->tables, Table, i);
+    memcpy (entry, table->name, strlen (table->name));
+    write_u32 (entry + TABLE_NAME_SIZE, table->hop_size);
+    write_u32 (entry + TABLE_NAME_SIZE + 4, table->column_count);
+    entry += TABLE_ENTRY_SIZE;
+  }
+  for (i = 0; i < trace->columns->len; i++) {
+    Column *column = &g_array_index (trace->columns, Column, i);
+    memcpy (entry, column->name, strlen (column->name));
+    write_u32 (entry + COLUMN_NAME_SIZE, column->table);
+    write_u32 (entry + COLUMN_NAME_SIZE + 4, column->width);
+    entry += COLUMN_ENTRY_SIZE;
+  }
+  ok = fwrite (header, 1, header_size, trace->file) == header_size;
+  g_free (header);
+
+  for (i = 0; i < trace->tables->len; i++) {
+    Table *table = &g_array_index (trace->tables, Table, i);
+    table->free_chunks = g_async_queue_new ();
+    for (j = 0; j < trace->max_chunks; j++) {
+      Chunk *chunk = g_new0 (Chunk, 1);
+      chunk->table = i;
+      chunk->data = g_new0 (gdouble,
+                            (gsize) table->width * trace->frames_per_chunk);
+      g_async_queue_push (table->free_chunks, chunk);
+    }
+    table->chunk = g_async_queue_pop (table->free_chunks);
+  }
+  trace->full_chunks = g_async_queue_new ();
+  trace->thread = g_thread_new ("peaq-frametrace", writer_thread, trace);
+  return ok;
+}
+
+/**
+ * peaq_frametrace_get_row:
+ * @trace: The #PeaqFrameTrace to write to.
+ * @column: Index of the column.
+ *
+ * Returns: The location to store the values of @column for the current frame
+ * of its table. It stays valid until peaq_frametrace_next_frame() is called
+ * for the table.
+ */
+gdouble *
+peaq_frametrace_get_row (PeaqFrameTrace *trace, guint column)
+{
+  Column *c = &g_array_index (trace->columns, Column, column);
+  Chunk *chunk = g_array_index (trace->tables, Table, c->table).chunk;
+  return chunk->data + c->offset * trace->frames_per_chunk +
+    chunk->frames * c->width;
+}
+
+static void
+submit_chunk (PeaqFrameTrace *trace, Table *table)
+{
+  g_async_queue_push (trace->full_chunks, table->chunk);
+  table->chunk = NULL;
+}
+
+/**
+ * peaq_frametrace_next_frame:
+ * @trace: The #PeaqFrameTrace to write to.
+ * @table: Index of the table.
+ *
+ * Completes the current frame of @table after all its columns have been
+ * written. If the chunk is full, it is passed to the writer thread, waiting
+ * for a free chunk if necessary.
+ */
+void
+peaq_frametrace_next_frame (PeaqFrameTrace *trace, guint table)
+{
+  Table *t = &g_array_index (trace->tables, Table, table);
+  t->frames++;
+  if (++t->chunk->frames == trace->frames_per_chunk) {
+    submit_chunk (trace, t);
+    t->chunk = g_async_queue_pop (t->free_chunks);
+    t->chunk->frames = 0;
+    t->chunk->first_frame = t->frames;
+  }
+}
+
+/**
+ * peaq_frametrace_free:
+ * @trace: The #PeaqFrameTrace to close.
+ *
+ * Writes the partially filled chunks, waits for the writer thread to finish,
+ * closes the file and frees @trace.
+ *
+ * Returns: %TRUE if all data has been written successfully.
+ */
+gboolean
+peaq_frametrace_free (PeaqFrameTrace *trace)
+{
+  guint i, j;
+  gboolean ok;
+  if (trace->thread) {
+    for (i = 0; i < trace->tables->len; i++) {
+      Table *table = &g_array_index (trace->tables, Table, i);
+      if (table->chunk->frames > 0)
+        submit_chunk (trace, table);
+    }
+    g_async_queue_push (trace->full_chunks, &trace->stop);
+    g_thread_join (trace->thread);
+    g_async_queue_unref (trace->full_chunks);
+    for (i = 0; i < trace->tables->len; i++) {
+      Table *table = &g_array_index (trace->tables, Table, i);
+      if (table->chunk)
+        g_async_queue_push (table->free_chunks, table->chunk);
+      for (j = 0; j < trace->max_chunks; j++) {
+        Chunk *chunk = g_async_queue_pop (table->free_chunks);
+        g_free (chunk->data);
+        g_free (chunk);
+      }
+      g_async_queue_unref (table->free_chunks);
+    }
+  }
+  ok = !g_atomic_int_get (&trace->failed) && !ferror (trace->file);
+  if (fclose (trace->file) != 0)
+    ok = FALSE;
+  g_array_free (trace->tables, TRUE);
+  g_array_free (trace->columns, TRUE);
+  g_free (trace);
+  return ok;
+}
+
+/**
+ * peaq_frametrace_reader_new:
+ * @filename: Name of a file written by a #PeaqFrameTrace.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Maps @filename into memory and indexes its chunks.
+ *
+ * Returns: The new #PeaqFrameTraceReader or %NULL on error.
+ */
+PeaqFrameTraceReader *
+peaq_frametrace_reader_new (gchar const *filename, GError **error)
+{
+  PeaqFrameTraceReader *reader = NULL;
+  GMappedFile *mapped = g_mapped_file_new (filename, FALSE, error);
+  guint8 const *contents;
+  gsize length, header_size, offset;
+  guint table_count, column_count, i;
+
+  if (!mapped)
+    return NULL;
+  contents = (guint8 const *) g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  if (length < HEADER_SIZE ||
+      memcmp (contents, FRAMETRACE_MAGIC, 8) != 0)
+    goto invalid;
+  header_size = read_u32 (contents + 8);
+  table_count = read_u32 (contents + 12);
+  column_count = read_u32 (contents + 16);
+  if (header_size != HEADER_SIZE + (gsize) TABLE_ENTRY_SIZE * table_count +
+      (gsize) COLUMN_ENTRY_SIZE * column_count || header_size > length)
+    goto invalid;
+
+  reader = g_new (PeaqFrameTraceReader, 1);
+  reader->mapped = mapped;
+  reader->contents = contents;
+  reader->tables = g_array_new (FALSE, TRUE, sizeof (Table));
+  reader->columns = g_array_new (FALSE, TRUE, sizeof (Column));
+  offset = HEADER_SIZE;
+  for (i = 0; i < table_count; i++) {
+    Table table;
+    memset (&table, 0, sizeof (table));
+    memcpy (table.name, contents + offset, TABLE_NAME_SIZE);
+    table.hop_size = read_u32 (contents + offset + TABLE_NAME_SIZE);
+    table.chunk_index = g_array_new (FALSE, FALSE, sizeof (ChunkIndex));
+    g_array_append_val (reader->tables, table);
+    offset += TABLE_ENTRY_SIZE;
+  }
+  for (i = 0; i < column_count; i++) {
+    Column column;
+    Table *table;
+    memset (&column, 0, sizeof (column));
+    memcpy (column.name, contents + offset, COLUMN_NAME_SIZE);
+    column.table = read_u32 (contents + offset + COLUMN_NAME_SIZE);
+    column.width = read_u32 (contents + offset + COLUMN_NAME_SIZE + 4);
+    if (column.table >= table_count)
+      goto invalid;
+    table = &g_array_index (reader->tables, Table, column.table);
+    column.offset = table->width;
+    table->width += column.width;
+    table->column_count++;
+    g_array_append_val (reader->columns, column);
+    offset += COLUMN_ENTRY_SIZE;
+  }
+
+  while (offset + CHUNK_HEADER_SIZE <= length) {
+    ChunkIndex index;
+    Table *table;
+    guint t = read_u32 (contents + offset);
+    index.frames = read_u32 (contents + offset + 4);
+    index.first_frame = read_u64 (contents + offset + 8);
+    index.offset = offset + CHUNK_HEADER_SIZE;
+    if (t >= table_count)
+      goto invalid;
+    table = &g_array_index (reader->tables, Table, t);
+    if (index.first_frame != table->frames)
+      goto invalid;
+    offset = index.offset + (gsize) index.frames * table->width * 8;
+    if (offset > length)
+      break;
+    g_array_append_val (table->chunk_index, index);
+    table->frames += index.frames;
+  }
+  return reader;
+
+invalid:
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+               "%s is not a valid frame trace", filename);
+  if (reader)
+    peaq_frametrace_reader_free (reader);
+  else
+    g_mapped_file_unref (mapped);
+  return NULL;
+}
+
+/**
+ * peaq_frametrace_reader_free:
+ * @reader: The #PeaqFrameTraceReader to free.
+ */
+void
+peaq_frametrace_reader_free (PeaqFrameTraceReader *reader)
+{
+  guint i;
+  for (i = 0; i < reader->tables->len; i++)
+    g_array_free (g_array_index (reader->tables, Table, i).chunk_index, TRUE);
+  g_array_free (reader->tables, TRUE);
+  g_array_free (reader->columns, TRUE);
+  g_mapped_file_unref (reader->mapped);
+  g_free (reader);
+}
+
+/**
+ * peaq_frametrace_reader_get_table_count:
+ * @reader: The #PeaqFrameTraceReader to query.
+ *
+ * Returns: The number of tables.
+ */
+guint
+peaq_frametrace_reader_get_table_count (PeaqFrameTraceReader const *reader)
+{
+  return reader->tables->len;
+}
+
+/**
+ * peaq_frametrace_reader_get_table_name:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @table: Index of the table.
+ *
+ * Returns: The name of @table.
+ */
+gchar const *
+peaq_frametrace_reader_get_table_name (PeaqFrameTraceReader const *reader,
+                                       guint table)
+{
+  return g_array_index (reader->tables, Table, table).name;
+}
+
+/**
+ * peaq_frametrace_reader_get_hop_size:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @table: Index of the table.
+ *
+ * Returns: The number of samples between two frames of @table.
+ */
+guint
+peaq_frametrace_reader_get_hop_size (PeaqFrameTraceReader const *reader,
+                                     guint table)
+{
+  return g_array_index (reader->tables, Table, table).hop_size;
+}
+
+/**
+ * peaq_frametrace_reader_get_frame_count:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @table: Index of the table.
+ *
+ * Returns: The number of frames stored for @table.
+ */
+guint64
+peaq_frametrace_reader_get_frame_count (PeaqFrameTraceReader const *reader,
+                                        guint table)
+{
+  return g_array_index (reader->tables, Table, table).frames;
+}
+
+/**
+ * peaq_frametrace_reader_get_column_count:
+ * @reader: The #PeaqFrameTraceReader to query.
+ *
+ * Returns: The number of columns of all tables.
+ */
+guint
+peaq_frametrace_reader_get_column_count (PeaqFrameTraceReader const *reader)
+{
+  return reader->columns->len;
+}
+
+/**
+ * peaq_frametrace_reader_get_column_name:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @column: Index of the column.
+ *
+ * Returns: The name of @column.
+ */
+gchar const *
+peaq_frametrace_reader_get_column_name (PeaqFrameTraceReader const *reader,
+                                        guint column)
+{
+  return g_array_index (reader->columns, Column, column).name;
+}
+
+/**
+ * peaq_frametrace_reader_get_column_table:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @column: Index of the column.
+ *
+ * Returns: The index of the table @column belongs to.
+ */
+guint
+peaq_frametrace_reader_get_column_table (PeaqFrameTraceReader const *reader,
+                                         guint column)
+{
+  return g_array_index (reader->columns, Column, column).table;
+}
+
+/**
+ * peaq_frametrace_reader_get_column_width:
+ * @reader: The #PeaqFrameTraceReader to query.
+ * @column: Index of the column.
+ *
+ * Returns: The number of values per frame of @column.
+ */
+guint
+peaq_frametrace_reader_get_column_width (PeaqFrameTraceReader const *reader,
+                                         guint column)
+{
+  return g_array_index (reader->columns, Column, column).width;
+}
+
+/**
+ * peaq_frametrace_reader_find_column:
+ * @reader: The #PeaqFrameTraceReader to search.
+ * @name: Name of the column.
+ *
+ * Returns: The index of the column named @name or -1 if there is none.
+ */
+gint
+peaq_frametrace_reader_find_column (PeaqFrameTraceReader const *reader,
+                                    gchar const *name)
+{
+  guint i;
+  for (i = 0; i < reader->columns->len; i++)
+    if (strcmp (g_array_index (reader->columns, Column, i).name, name) == 0)
+      return i;
+  return -1;
+}
+
+/**
+ * peaq_frametrace_reader_read:
+ * @reader: The #PeaqFrameTraceReader to read from.
+ * @column: Index of the column.
+ * @first_frame: Index of the first frame to read.
+ * @frames: Number of frames to read.
+ * @values: Location to store @frames times the column width values.
+ *
+ * Copies the values of @column for the given frames to @values.
+ *
+ * Returns: %TRUE on success, %FALSE if the frames are not all present.
+ */
+gboolean
+peaq_frametrace_reader_read (PeaqFrameTraceReader const *reader, guint column,
+                             guint64 first_frame, guint64 frames,
+                             gdouble *values)
+{
+  Column const *c = &g_array_index (reader->columns, Column, column);
+  Table const *table = &g_array_index (reader->tables, Table, c->table);
+  guint lo = 0, hi = table->chunk_index->len;
+
+  if (first_frame + frames > table->frames)
+    return FALSE;
+
+  /* binary search for the chunk containing first_frame */
+  while (hi - lo > 1) {
+    guint mid = (lo + hi) / 2;
+    if (g_array_index (table->chunk_index, ChunkIndex, mid).first_frame >
+        first_frame)
+      hi = mid;
+    else
+      lo = mid;
+  }
+
+  while (frames > 0) {
+    ChunkIndex const *index =
+      &g_array_index (table->chunk_index, ChunkIndex, lo);
+    guint64 start = first_frame - index->first_frame;
+    guint64 count = MIN (frames, index->frames - start);
+    guint8 const *src = reader->contents + index->offset +
+      ((gsize) c->offset * index->frames + start * c->width) * 8;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    memcpy (values, src, count * c->width * 8);
+#else
+    gsize i;
+    for (i = 0; i < count * c->width; i++) {
+      guint64 bits = read_u64 (src + 8 * i);
+      memcpy (values + i, &bits, 8);
+    }
+#endif
+    values += count * c->width;
+    first_frame += count;
+    frames -= count;
+    lo++;
+  }
+  return TRUE;
+}
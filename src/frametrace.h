@@ -0,0 +1,65 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * frametrace.h: Columnar binary traces of per-frame quantities.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __FRAMETRACE_H__
+#define __FRAMETRACE_H__ 1
+
+#include <glib.h>
+
+typedef struct _PeaqFrameTrace PeaqFrameTrace;
+typedef struct _PeaqFrameTraceReader PeaqFrameTraceReader;
+
+PeaqFrameTrace *peaq_frametrace_new (gchar const *filename,
+                                     guint frames_per_chunk,
+                                     guint max_chunks);
+guint peaq_frametrace_add_table (PeaqFrameTrace *trace, gchar const *name,
+                                 guint hop_size);
+guint peaq_frametrace_add_column (PeaqFrameTrace *trace, guint table,
+                                  gchar const *name, guint width);
+gboolean peaq_frametrace_start (PeaqFrameTrace *trace);
+gdouble *peaq_frametrace_get_row (PeaqFrameTrace *trace, guint column);
+void peaq_frametrace_next_frame (PeaqFrameTrace *trace, guint table);
+gboolean peaq_frametrace_free (PeaqFrameTrace *trace);
+
+PeaqFrameTraceReader *peaq_frametrace_reader_new (gchar const *filename,
+                                                  GError **error);
+void peaq_frametrace_reader_free (PeaqFrameTraceReader *reader);
+guint peaq_frametrace_reader_get_table_count (PeaqFrameTraceReader const *reader);
+gchar const *peaq_frametrace_reader_get_table_name (PeaqFrameTraceReader const *reader,
+                                                    guint table);
+guint peaq_frametrace_reader_get_hop_size (PeaqFrameTraceReader const *reader,
+                                           guint table);
+guint64 peaq_frametrace_reader_get_frame_count (PeaqFrameTraceReader const *reader,
+                                                guint table);
+guint peaq_frametrace_reader_get_column_count (PeaqFrameTraceReader const *reader);
+gchar const *peaq_frametrace_reader_get_column_name (PeaqFrameTraceReader const *reader,
+                                                     guint column);
+guint peaq_frametrace_reader_get_column_table (PeaqFrameTraceReader const *reader,
+                                               guint column);
+guint peaq_frametrace_reader_get_column_width (PeaqFrameTraceReader const *reader,
+                                               guint column);
+gint peaq_frametrace_reader_find_column (PeaqFrameTraceReader const *reader,
+                                         gchar const *name);
+gboolean peaq_frametrace_reader_read (PeaqFrameTraceReader const *reader,
+                                      guint column, guint64 first_frame,
+                                      guint64 frames, gdouble *values);
+
+#endif
@@ -0,0 +1,378 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * genpeaq.c: Generate a synthetic corpus of reference and test signals.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Writes a reference signal (decaying harmonic notes on a pentatonic scale
+ * plus percussive noise bursts) of --duration seconds with --channels
+ * channels to ref.wav in --output-dir and one degraded version per entry of
+ * degradations[] to <name>.wav, all as 32 bit float at 48 kHz. The list of
+ * reference/test pairs is written to corpus.txt. All randomness is derived
+ * from --seed with a fixed linear congruential generator, so the corpus is
+ * bit-identical on every platform for the same options. Run with
+ * "make corpus".
+ */
+
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define SAMPLING_RATE 48000
+#define LOWPASS_TAPS 255
+
+typedef struct _Degradation Degradation;
+typedef void (*DegradeFunc) (gfloat const *ref, gfloat *test, gsize frames,
+                             gdouble param, guint32 *seed);
+
+struct _Degradation
+{
+  gchar const *name;
+  DegradeFunc func;
+  gdouble param;
+};
+
+static gint channels = 2;
+static gdouble duration = 30.;
+static gint seed = 1;
+static gchar *output_dir = NULL;
+
+static GOptionEntry option_entries[] = {
+  {"channels", 'c', 0, G_OPTION_ARG_INT, &channels,
+   "number of channels (default: 2)", "N"},
+  {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+   "length of the signals in seconds (default: 30)", "SECONDS"},
+  {"seed", 's', 0, G_OPTION_ARG_INT, &seed,
+   "seed of the random number generator (default: 1)", "N"},
+  {"output-dir", 'o', 0, G_OPTION_ARG_FILENAME, &output_dir,
+   "directory to write the corpus to (default: corpus)", "DIR"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static inline gdouble
+next_random (guint32 *state)
+{
+  *state = *state * 1664525 + 1013904223;
+  return (gint32) *state / 2147483648.;
+}
+
+static void
+generate_reference (gfloat *ref, gsize frames, guint32 *state)
+{
+  static const gdouble scale[] = {
+    220., 246.94, 277.18, 329.63, 369.99, 440., 493.88, 554.37, 659.26,
+    739.99
+  };
+  gsize note_frames = SAMPLING_RATE / 4;
+  gsize burst_frames = SAMPLING_RATE / 2;
+  gint c;
+  for (c = 0; c < channels; c++) {
+    gdouble phase = 0.;
+    gdouble frequency = scale[0];
+    gsize n;
+    for (n = 0; n < frames; n++) {
+      gdouble t_note = (gdouble) (n % note_frames) / SAMPLING_RATE;
+      gdouble t_burst = (gdouble) (n % burst_frames) / SAMPLING_RATE;
+      gdouble x;
+      if (n % note_frames == 0)
+        frequency = scale[(guint) ((next_random (state) + 1.) * 5.) % 10];
+      phase = fmod (phase + 2 * M_PI * frequency / SAMPLING_RATE, 2 * M_PI);
+      x = 0.3 * exp (-t_note / 0.15) *
+        (sin (phase) + 0.5 * sin (2 * phase) + 0.25 * sin (3 * phase));
+      x += 0.2 * exp (-t_burst / 0.01) * next_random (state);
+      ref[n * channels + c] = x;
+    }
+  }
+}
+
+static void
+degrade_none (gfloat const *ref, gfloat *test, gsize frames, gdouble param,
+              guint32 *state)
+{
+  memcpy (test, ref, frames * channels * sizeof (gfloat));
+}
+
+/* additive white noise at an SNR of param dB */
+static void
+degrade_noise (gfloat const *ref, gfloat *test, gsize frames, gdouble param,
+               guint32 *state)
+{
+  gsize i;
+  gdouble power = 0.;
+  gdouble amplitude;
+  for (i = 0; i < frames * channels; i++)
+    power += ref[i] * ref[i];
+  power /= frames * channels;
+  /* uniform noise in [-a, a] has a power of a^2/3 */
+  amplitude = sqrt (3. * power * pow (10., -param / 10.));
+  for (i = 0; i < frames * channels; i++)
+    test[i] = ref[i] + amplitude * next_random (state);
+}
+
+/* linear-phase low-pass with a cut-off frequency of param Hz */
+static void
+degrade_lowpass (gfloat const *ref, gfloat *test, gsize frames,
+                 gdouble param, guint32 *state)
+{
+  gdouble h[LOWPASS_TAPS];
+  gdouble fc = param / SAMPLING_RATE;
+  gint k;
+  gsize n;
+  gint c;
+  for (k = 0; k < LOWPASS_TAPS; k++) {
+    gint m = k - LOWPASS_TAPS / 2;
+    gdouble window = 0.5 - 0.5 * cos (2 * M_PI * k / (LOWPASS_TAPS - 1));
+    h[k] = window * (m == 0 ? 2 * fc : sin (2 * M_PI * fc * m) / (M_PI * m));
+  }
+  for (c = 0; c < channels; c++) {
+    for (n = 0; n < frames; n++) {
+      gdouble y = 0.;
+      for (k = 0; k < LOWPASS_TAPS; k++) {
+        gint64 i = (gint64) n + LOWPASS_TAPS / 2 - k;
+        if (i >= 0 && i < (gint64) frames)
+          y += h[k] * ref[i * channels + c];
+      }
+      test[n * channels + c] = y;
+    }
+  }
+}
+
+/* quantization to param bits without dither */
+static void
+degrade_quantize (gfloat const *ref, gfloat *test, gsize frames,
+                  gdouble param, guint32 *state)
+{
+  gdouble step = pow (2., 1. - param);
+  gsize i;
+  for (i = 0; i < frames * channels; i++)
+    test[i] = step * floor (ref[i] / step + 0.5);
+}
+
+/* noise spread uniformly over blocks of param frames at a level relative to
+ * the block's peak, like the quantization noise of a transform codec that
+ * precedes a transient within the same block */
+static void
+degrade_pre_echo (gfloat const *ref, gfloat *test, gsize frames,
+                  gdouble param, guint32 *state)
+{
+  gsize block_frames = param;
+  gsize start;
+  gint c;
+  for (c = 0; c < channels; c++) {
+    for (start = 0; start < frames; start += block_frames) {
+      gsize end = MIN (start + block_frames, frames);
+      gdouble peak = 0.;
+      gsize n;
+      for (n = start; n < end; n++)
+        peak = MAX (peak, fabs (ref[n * channels + c]));
+      for (n = start; n < end; n++)
+        test[n * channels + c] =
+          ref[n * channels + c] + 0.05 * peak * next_random (state);
+    }
+  }
+}
+
+/* delay by param seconds */
+static void
+degrade_delay (gfloat const *ref, gfloat *test, gsize frames, gdouble param,
+               guint32 *state)
+{
+  gsize delay = MIN ((gsize) (param * SAMPLING_RATE), frames);
+  memset (test, 0, delay * channels * sizeof (gfloat));
+  memcpy (test + delay * channels, ref,
+          (frames - delay) * channels * sizeof (gfloat));
+}
+
+/* dropouts of param seconds every two seconds */
+static void
+degrade_gaps (gfloat const *ref, gfloat *test, gsize frames, gdouble param,
+              guint32 *state)
+{
+  gsize period = 2 * SAMPLING_RATE;
+  gsize gap = param * SAMPLING_RATE;
+  gsize n;
+  gint c;
+  for (n = 0; n < frames; n++)
+    for (c = 0; c < channels; c++)
+      test[n * channels + c] =
+        n % period >= period - gap ? 0.f : ref[n * channels + c];
+}
+
+static const Degradation degradations[] = {
+  {"identical", degrade_none, 0.},
+  {"noise-10db", degrade_noise, 10.},
+  {"noise-20db", degrade_noise, 20.},
+  {"noise-30db", degrade_noise, 30.},
+  {"noise-40db", degrade_noise, 40.},
+  {"lowpass-3500hz", degrade_lowpass, 3500.},
+  {"lowpass-7000hz", degrade_lowpass, 7000.},
+  {"lowpass-11000hz", degrade_lowpass, 11000.},
+  {"quantize-8bit", degrade_quantize, 8.},
+  {"quantize-12bit", degrade_quantize, 12.},
+  {"pre-echo-1024", degrade_pre_echo, 1024.},
+  {"pre-echo-2048", degrade_pre_echo, 2048.},
+  {"delay-1ms", degrade_delay, 0.001},
+  {"delay-20ms", degrade_delay, 0.02},
+  {"gaps-20ms", degrade_gaps, 0.02},
+  {"gaps-100ms", degrade_gaps, 0.1}
+};
+
+static void
+write_le (FILE *file, guint32 value, guint bytes)
+{
+  guint i;
+  for (i = 0; i < bytes; i++)
+    fputc ((value >> (8 * i)) & 0xff, file);
+}
+
+/*
+ * write_wav:
+ * @filename: Name of the file to write.
+ * @data: Interleaved samples.
+ * @frames: Number of frames in @data.
+ *
+ * Writes @data as WAVE_FORMAT_IEEE_FLOAT file with 32 bit samples.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+write_wav (gchar const *filename, gfloat const *data, gsize frames)
+{
+  guint32 data_size = frames * channels * sizeof (gfloat);
+  gsize i;
+  FILE *file = g_fopen (filename, "wb");
+  if (!file) {
+    g_printf ("Error: could not open %s\n", filename);
+    return FALSE;
+  }
+  fputs ("RIFF", file);
+  write_le (file, 4 + 8 + 18 + 8 + 4 + 8 + data_size, 4);
+  fputs ("WAVEfmt ", file);
+  write_le (file, 18, 4);
+  write_le (file, 3, 2);          /* WAVE_FORMAT_IEEE_FLOAT */
+  write_le (file, channels, 2);
+  write_le (file, SAMPLING_RATE, 4);
+  write_le (file, SAMPLING_RATE * channels * sizeof (gfloat), 4);
+  write_le (file, channels * sizeof (gfloat), 2);
+  write_le (file, 32, 2);
+  write_le (file, 0, 2);
+  fputs ("fact", file);
+  write_le (file, 4, 4);
+  write_le (file, frames, 4);
+  fputs ("data", file);
+  write_le (file, data_size, 4);
+  for (i = 0; i < frames * channels; i++) {
+    union { gfloat f; guint32 u; } sample;
+    sample.f = data[i];
+    write_le (file, sample.u, 4);
+  }
+  if (fclose (file) != 0) {
+    g_printf ("Error: could not write %s\n", filename);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  GString *list;
+  gsize frames;
+  gfloat *ref;
+  gfloat *test;
+  gchar *filename;
+  guint32 state;
+  guint i;
+  gboolean ok;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_set_summary (context,
+                                "genpeaq generates reproducible pairs of reference and degraded test\n"
+                                "signals for benchmarking.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (channels < 1 || duration <= 0.) {
+    g_printf ("Error: invalid channel count or duration\n");
+    return 1;
+  }
+  if (!output_dir)
+    output_dir = g_strdup ("corpus");
+  if (g_mkdir_with_parents (output_dir, 0755) != 0) {
+    g_printf ("Error: could not create %s\n", output_dir);
+    return 1;
+  }
+
+  frames = duration * SAMPLING_RATE;
+  ref = g_new (gfloat, frames * channels);
+  test = g_new (gfloat, frames * channels);
+
+  state = seed;
+  generate_reference (ref, frames, &state);
+  filename = g_build_filename (output_dir, "ref.wav", NULL);
+  ok = write_wav (filename, ref, frames);
+  g_free (filename);
+
+  list = g_string_new (NULL);
+  for (i = 0; ok && i < G_N_ELEMENTS (degradations); i++) {
+    gchar *basename = g_strconcat (degradations[i].name, ".wav", NULL);
+    /* every degradation gets its own reproducible random sequence */
+    state = seed + 7919 * (i + 1);
+    degradations[i].func (ref, test, frames, degradations[i].param, &state);
+    filename = g_build_filename (output_dir, basename, NULL);
+    ok = write_wav (filename, test, frames);
+    g_string_append_printf (list, "ref.wav %s\n", basename);
+    g_printf ("%s\n", filename);
+    g_free (filename);
+    g_free (basename);
+  }
+
+  if (ok) {
+    filename = g_build_filename (output_dir, "corpus.txt", NULL);
+    ok = g_file_set_contents (filename, list->str, list->len, &error);
+    if (!ok) {
+      g_printf ("Error: %s\n", error->message);
+      g_error_free (error);
+    }
+    g_free (filename);
+  }
+
+  g_string_free (list, TRUE);
+  g_free (ref);
+  g_free (test);
+  g_free (output_dir);
+
+  return ok ? 0 : 1;
+}
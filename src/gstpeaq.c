@@ -32,6 +32,9 @@
  * the requirements of conformance specified therein.) Both pads require the
  * input to be "audio/x-raw-float" sampled at 48 kHz. Both mono and stereo
  * signals are supported.
+ * Buffer lists are accepted, too, and handled as a whole, processing the
+ * frames completed by all buffers of the list at once, which lowers the
+ * overhead for the small buffers of live sources.
  *
  * GstPeaq supports both the basic and the advanced version of <xref
  * linkend="BS1387" />, as controlled with #GstPeaq:advanced.
@@ -39,7 +42,128 @@
  * The resulting objective difference grade can be acquired at any time using
  * the #GstPeaq:odg property. If #GstPeaq:console-output is set to TRUE, the
  * final objective difference grade (and some additional data) is also printed
- * to stdout when the playback is stopped.
+ * to stdout when the playback is stopped. The values returned by #GstPeaq:odg,
+ * #GstPeaq:di, #GstPeaq:totalsnr and #GstPeaq:results (which additionally
+ * holds the model output variables and the number of frames) are taken from a
+ * snapshot updated after every buffer that completed at least one frame, so
+ * they can be polled from another thread without waiting for or disturbing
+ * the processing.
+ *
+ * For profiling, #GstPeaq:collect-stats enables accumulation of the time
+ * spent in the individual processing stages (ear models, pre-processing, the
+ * groups of model output variables and the framing overhead). The totals can
+ * be read from #GstPeaq:stats and are also posted as "peaq-stats" element
+ * messages every #GstPeaq:stats-interval frames. If disabled (the default), no
+ * timestamps are taken.
+ *
+ * With #GstPeaq:collect-stats enabled, the time needed for every hop (i.e.
+ * every iteration of the FFT or filter bank processing) is also recorded in a
+ * logarithmically bucketed histogram. The 50th, 99th and 99.9th percentiles
+ * and the number of hops exceeding their deadline, i.e. taking longer than the
+ * 1024 (FFT) or 192 (filter bank) samples they advance the signal by, can be
+ * read from #GstPeaq:latency and are posted as "peaq-latency" element messages
+ * along with the "peaq-stats" ones.
+ *
+ * Setting #GstPeaq:trace-file (or the environment variable PEAQ_TRACE)
+ * writes a timeline of pad_chain(), adapter mapping, the ear model calls,
+ * pre-processing, the MOV calculations and their accumulation to the given
+ * file in the Chrome trace event format between starting and stopping
+ * playback, e.g. for inspection with Perfetto.
+ *
+ * To reproduce problems depending on the upstream buffering, setting
+ * #GstPeaq:record-file records the sizes, timestamps and flags of all buffers
+ * and the caps, gap and end-of-stream events in the order they arrive at the
+ * two pads, optionally including the sample data (#GstPeaq:record-data). The
+ * replaypeaq tool drives the element with a recorded pattern.
+ *
+ * To quickly re-evaluate an item of which only a part has been changed,
+ * #GstPeaq:checkpoint-file stores the processing state (ear models, level
+ * adapters, modulation processors and accumulators) every
+ * #GstPeaq:checkpoint-interval seconds together with the per-frame
+ * contributions to the accumulators. When evaluating the changed item with
+ * #GstPeaq:resume-file set to that file and the changed time range given by
+ * #GstPeaq:changed-start and #GstPeaq:changed-end, processing restarts from
+ * the last checkpoint before the change (skipping the incoming data up to
+ * there). At every stored checkpoint after the change, the recomputed state
+ * is compared to the stored one; once all values agree within
+ * #GstPeaq:convergence-tolerance, the stored contributions for the rest of
+ * the item are spliced in, the remaining input is discarded and a
+ * "peaq-splice" element message is posted. This assumes the item has the
+ * same length and is unchanged outside the given range. Checkpoints taken in
+ * a different mode, with a different number of channels or at a different
+ * #GstPeaq:playback_level are ignored with a warning. No new checkpoints are
+ * written while resuming.
+ *
+ * For triage of large numbers of items, #GstPeaq:screening (basic version
+ * only) restricts the processing to the ear model and the noise-to-mask ratio
+ * and detection probability MOVs, skipping the pre-processing and all other
+ * MOVs. Every frame whose NMR (in dB, maximum over the channels) exceeds
+ * #GstPeaq:screen-nmr-threshold or whose probability of detection exceeds
+ * #GstPeaq:screen-pd-threshold is flagged, and each run of overlapping flagged
+ * frames is posted as "peaq-flagged-region" element message with its start
+ * and end position in samples and the maximum NMR and detection probability.
+ * The objective difference grade is meaningless in this mode, and as the
+ * screening uses the accumulator logs itself, #GstPeaq:checkpoint-file and
+ * #GstPeaq:resume-file are ignored with a warning. The screenpeaq tool uses
+ * this to select the regions for a full analysis.
+ *
+ * For research and debugging, #GstPeaq:frame-trace-file writes per-frame
+ * intermediate quantities, as selected with #GstPeaq:frame-trace-quantities,
+ * to a columnar binary file (see #PeaqFrameTrace) from a separate thread:
+ * excitation patterns, power spectra, modulation patterns, the contribution
+ * of each frame to each MOV (NaN if none), the energy threshold flags and the
+ * signal and noise energy. The exportpeaq tool converts the columns to .npy
+ * files.
+ *
+ * To experiment with the MOV calculation and the neural network without
+ * re-running the ear models, a frame trace written with the quantity "replay"
+ * (excitation patterns, power spectra, flags and energy) can be evaluated
+ * again by setting #GstPeaq:replay-file on an element with unlinked pads in the
+ * same mode: when the element goes to PAUSED, the ear model states are set
+ * from the stored values and the pre-processing, the MOVs and the result are
+ * computed as for the original input, after which #GstPeaq:odg, #GstPeaq:di
+ * and #GstPeaq:totalsnr can be read once it is back in READY. The rescorepeaq
+ * tool does this from the command line.
+ *
+ * For live monitoring from other processes, #GstPeaq:results-ring publishes
+ * one entry per frame to a named shared-memory ring (see #PeaqResultsRing)
+ * without going through the bus: the running distortion index and objective
+ * difference grade, the objective difference grade of the last completed
+ * window of #GstPeaq:results-ring-window seconds, and the contribution of the
+ * frame to each MOV per channel (NaN if none). In advanced mode, FFT and
+ * filter bank frames are published as separate tables (0 and 1), each
+ * carrying only its own MOVs. Readers never block the processing; the
+ * watchpeaq tool is an example reader.
+ *
+ * Until the first frame above the energy threshold, no frame contributes to
+ * the MOVs, so with #GstPeaq:skip-warm-up (the default) only the
+ * pre-processing is performed for such leading frames, e.g. silence, with
+ * identical results. Their contributions are reported as NaN in the frame
+ * trace and the results ring.
+ *
+ * To evaluate an excerpt with the ear model settled, it can be preceded by
+ * some input of warm-up and #GstPeaq:score-start set to its length in
+ * samples: frames starting before it only run through the ear models and the
+ * pre-processing and neither contribute to the MOVs nor to the total SNR.
+ *
+ * The memory currently allocated by the instance and the peak usage since the
+ * last start of processing can be read from #GstPeaq:memory, broken down into
+ * ear models, ear model states, pre-processing, accumulators and the data
+ * buffered in the adapters.
+ *
+ * To monitor a signal within a production pipeline, the element is also
+ * available as "peaqpass" (#GstPeaqPass), which behaves identically but
+ * additionally provides a "test_src" and a "ref_src" pad. Every buffer
+ * arriving at the test (ref) pad is pushed on from the test_src (ref_src) pad
+ * unchanged, by reference, before it is analysed, as are the events, so the
+ * element can be placed directly in the delivery chain without a tee, queues
+ * or copies. Linking the ref_src pad is optional. Downstream elements
+ * modifying the data in place have to copy it, as the element keeps a
+ * reference until the frame has been processed.
+ *
+ * To evaluate an encoder and decoder without intermediate files, the
+ * peaqcodec bin (#GstPeaqCodec) passes the reference through them and feeds
+ * both signals to a peaq element, compensating the codec delay.
  *
  * Assuming the reference and test signal are stored in "ref.wav" and
  * "test.wav", the following will calculate the basic version objective
@@ -51,6 +175,15 @@
  *   peaq name=peaq \
  *   refsrc.src\!peaq.ref testsrc.src\!peaq.test
  * ]|
+ * Likewise, the following plays back the test signal while analysing it:
+ * |[
+ * gst-launch \
+ *   filesrc location="ref.wav" \! wavparse \! audioconvert name=refsrc \
+ *   filesrc location="test.wav" \! wavparse \! audioconvert name=testsrc \
+ *   peaqpass name=peaq \
+ *   refsrc.src\!peaq.ref testsrc.src\!peaq.test \
+ *   peaq.test_src\!audioconvert\!autoaudiosink
+ * ]|
  */
 
 #ifdef HAVE_CONFIG_H
@@ -64,13 +197,18 @@
 #include <string.h>
 
 #include "gstpeaq.h"
+#include "checkpoint.h"
 #include "fbearmodel.h"
 #include "fftearmodel.h"
+#include "frametrace.h"
 #include "leveladapter.h"
 #include "modpatt.h"
 #include "movaccum.h"
 #include "movs.h"
 #include "nn.h"
+#include "recorder.h"
+#include "resultsring.h"
+#include "tracer.h"
 
 enum
 {
@@ -80,7 +218,33 @@ enum
   PROP_DI,
   PROP_ODG,
   PROP_TOTALSNR,
-  PROP_CONSOLE_OUTPUT
+  PROP_CONSOLE_OUTPUT,
+  PROP_COLLECT_STATS,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
+  PROP_MEMORY,
+  PROP_LATENCY,
+  PROP_TRACE_FILE,
+  PROP_RECORD_FILE,
+  PROP_RECORD_DATA,
+  PROP_CHECKPOINT_FILE,
+  PROP_CHECKPOINT_INTERVAL,
+  PROP_RESUME_FILE,
+  PROP_CHANGED_START,
+  PROP_CHANGED_END,
+  PROP_CONVERGENCE_TOLERANCE,
+  PROP_SCREENING,
+  PROP_SCREEN_NMR_THRESHOLD,
+  PROP_SCREEN_PD_THRESHOLD,
+  PROP_FRAME_TRACE_FILE,
+  PROP_FRAME_TRACE_QUANTITIES,
+  PROP_REPLAY_FILE,
+  PROP_RESULTS,
+  PROP_RESULTS_RING,
+  PROP_RESULTS_RING_SLOTS,
+  PROP_RESULTS_RING_WINDOW,
+  PROP_SKIP_WARM_UP,
+  PROP_SCORE_START
 };
 
 enum _MovAdvanced {
@@ -107,11 +271,180 @@ enum _MovBasic {
   COUNT_MOV_BASIC
 };
 
+static const gchar *mov_names_advanced[COUNT_MOV_ADVANCED] = {
+  "rms-mod-diff",
+  "rms-noise-loud-asym",
+  "segmental-nmr",
+  "ehs",
+  "avg-lin-dist"
+};
+
+static const gchar *mov_names_basic[COUNT_MOV_BASIC] = {
+  "bandwidth-ref",
+  "bandwidth-test",
+  "total-nmr",
+  "win-mod-diff",
+  "adb",
+  "ehs",
+  "avg-mod-diff-1",
+  "avg-mod-diff-2",
+  "rms-noise-loud",
+  "mfpd",
+  "rel-dist-frames"
+};
+
+enum _Stage {
+  STAGE_FFT_EAR_MODEL,
+  STAGE_FB_EAR_MODEL,
+  STAGE_PREPROCESSING,
+  STAGE_MOV_MODULATION_DIFFERENCE,
+  STAGE_MOV_NOISE_LOUDNESS,
+  STAGE_MOV_BANDWIDTH,
+  STAGE_MOV_NMR,
+  STAGE_MOV_PROB_DETECT,
+  STAGE_MOV_EHS,
+  STAGE_FRAMING,
+  COUNT_STAGES
+};
+
+static const gchar *stage_names[COUNT_STAGES] = {
+  "fft-ear-model",
+  "fb-ear-model",
+  "preprocessing",
+  "mov-modulation-difference",
+  "mov-noise-loudness",
+  "mov-bandwidth",
+  "mov-nmr",
+  "mov-prob-detect",
+  "mov-ehs",
+  "framing"
+};
+
+enum _LatencyPath {
+  LATENCY_FFT,
+  LATENCY_FB,
+  COUNT_LATENCY_PATHS
+};
+
+static const gchar *latency_path_names[COUNT_LATENCY_PATHS] = {
+  "fft",
+  "fb"
+};
+
+/* latencies are bucketed with 2^LATENCY_SUB_BUCKET_BITS buckets per octave;
+ * the bucket count covers 32 bit nanosecond values, larger ones are clipped */
+#define LATENCY_SUB_BUCKET_BITS 2
+#define LATENCY_BUCKETS (32 << LATENCY_SUB_BUCKET_BITS)
+
+enum _TraceQuantity {
+  TRACE_EXCITATION,
+  TRACE_UNSMEARED_EXCITATION,
+  TRACE_POWER_SPECTRUM,
+  TRACE_WEIGHTED_POWER_SPECTRUM,
+  TRACE_MODULATION,
+  TRACE_MOVS,
+  TRACE_FLAGS,
+  TRACE_ENERGY,
+  COUNT_TRACE_QUANTITIES
+};
+
+static const gchar *trace_quantity_names[COUNT_TRACE_QUANTITIES] = {
+  "excitation",
+  "unsmeared-excitation",
+  "power-spectrum",
+  "weighted-power-spectrum",
+  "modulation",
+  "movs",
+  "flags",
+  "energy"
+};
+
+/* the frame trace is written in chunks of FRAME_TRACE_CHUNK_FRAMES frames, of
+ * which at most FRAME_TRACE_MAX_CHUNKS per table are buffered */
+#define FRAME_TRACE_CHUNK_FRAMES 256
+#define FRAME_TRACE_MAX_CHUNKS 8
+
+/* checkpoints are placed at multiples of the least common multiple of the FFT
+ * and filter bank step sizes, so both are at a frame boundary */
+#define CHECKPOINT_GRANULARITY 3072
+
+enum _Memory {
+  MEMORY_ELEMENT,
+  MEMORY_EAR_MODELS,
+  MEMORY_EAR_MODEL_STATES,
+  MEMORY_PREPROCESSING,
+  MEMORY_ACCUMULATORS,
+  MEMORY_ADAPTERS,
+  COUNT_MEMORY
+};
+
+static const gchar *memory_names[COUNT_MEMORY] = {
+  "element",
+  "ear-models",
+  "ear-model-states",
+  "preprocessing",
+  "accumulators",
+  "adapters"
+};
+
+struct _StageStats
+{
+  GstClockTime time;
+  guint64 calls;
+  guint64 frames;
+};
+
+/*
+ * TraceColumn:
+ * @column: Index of the column in the #PeaqFrameTrace.
+ * @quantity: The quantity stored.
+ * @signal: 0 for the reference, 1 for the test signal.
+ * @channel: The channel.
+ * @index: Index of the accumulator for #TRACE_MOVS; for #TRACE_FLAGS 0 for
+ * whether the frame exceeds the energy threshold controlling the tentative
+ * accumulation, 1 for the energy threshold of the error harmonic structure.
+ *
+ * Describes how to fill one column of the frame trace.
+ */
+struct _TraceColumn
+{
+  guint column;
+  enum _TraceQuantity quantity;
+  guint signal;
+  guint channel;
+  guint index;
+};
+
+/*
+ * _Results:
+ *
+ * Snapshot of the running results, published by the processing thread and
+ * read by get_property() without taking the object lock.
+ */
+struct _Results
+{
+  guint frames;
+  gdouble movs[COUNT_MOV_BASIC];
+  gdouble di;
+  gdouble odg;
+  gdouble total_snr;
+};
+
+/* the counters are pointer-sized to be updated with g_atomic_pointer_add(),
+ * i.e. 64 bit on 64 bit hosts; the number of hops is the sum of the buckets */
+struct _LatencyHistogram
+{
+  gsize deadline_misses;
+  gsize buckets[LATENCY_BUCKETS];
+};
+
 struct _GstPeaq
 {
   GstElement element;
   GstPad *refpad;
   GstPad *testpad;
+  GstPad *refsrcpad;
+  GstPad *testsrcpad;
   gboolean ref_eos;
   gboolean test_eos;
   GstAdapter *ref_adapter_fft;
@@ -136,6 +469,65 @@ struct _GstPeaq
   PeaqMovAccum *mov_accum[COUNT_MOV_BASIC];
   gdouble total_signal_energy;
   gdouble total_noise_energy;
+  gboolean collect_stats;
+  guint stats_interval;
+  guint stats_posted_frame;
+  struct _StageStats stats[COUNT_STAGES];
+  struct _LatencyHistogram latency[COUNT_LATENCY_PATHS];
+  gchar *trace_file;
+  gboolean tracing;
+  gchar *record_file;
+  gboolean record_data;
+  PeaqRecorder *recorder;
+  gchar *checkpoint_file;
+  gdouble checkpoint_interval;
+  gchar *resume_file;
+  gdouble changed_start;
+  gdouble changed_end;
+  gdouble convergence_tolerance;
+  gboolean checkpoints_pending;
+  PeaqCheckpointFile *checkpoints;
+  gboolean resuming;
+  guint checkpoint_index;
+  guint64 checkpoint_step;
+  guint64 next_checkpoint;
+  guint64 skip_bytes[2];
+  gboolean spliced;
+  gboolean screening;
+  gdouble screen_nmr_threshold;
+  gdouble screen_pd_threshold;
+  GArray *screen_log[2];
+  guint64 screen_region_start;
+  guint64 screen_region_end;
+  gdouble screen_max_nmr;
+  gdouble screen_max_pd;
+  GQueue screen_regions;
+  gchar *frame_trace_file;
+  gchar *frame_trace_quantities;
+  gboolean frame_trace_pending;
+  PeaqFrameTrace *frame_trace;
+  GArray *trace_columns[COUNT_LATENCY_PATHS];
+  gchar *replay_file;
+  gint results_seq;
+  struct _Results results;
+  gchar *results_ring_name;
+  guint results_ring_slots;
+  gdouble results_ring_window;
+  gboolean results_ring_pending;
+  PeaqResultsRing *results_ring;
+  PeaqMovAccum *window_accum[COUNT_MOV_BASIC];
+  guint ring_offsets[COUNT_MOV_BASIC];
+  gdouble *ring_values;
+  guint64 window_length;
+  guint64 window_frames;
+  gdouble window_odg;
+  gboolean skip_warm_up;
+  guint64 score_start;
+  guint64 mov_onset[COUNT_LATENCY_PATHS];
+  gint mov_tentative[COUNT_LATENCY_PATHS];
+  gsize memory_static;
+  gsize memory_peak;
+  gsize memory_adapters_peak;
 };
 
 struct _GstPeaqClass
@@ -164,9 +556,24 @@ GST_STATIC_PAD_TEMPLATE ("test",
 			 GST_PAD_ALWAYS,
 			 STATIC_CAPS);
 
+static GstStaticPadTemplate gst_peaq_ref_src_template =
+GST_STATIC_PAD_TEMPLATE ("ref_src",
+			 GST_PAD_SRC,
+			 GST_PAD_ALWAYS,
+			 STATIC_CAPS);
+
+static GstStaticPadTemplate gst_peaq_test_src_template =
+GST_STATIC_PAD_TEMPLATE ("test_src",
+			 GST_PAD_SRC,
+			 GST_PAD_ALWAYS,
+			 STATIC_CAPS);
+
 static void base_init (gpointer g_class);
 static void class_init (gpointer g_class, gpointer class_data);
 static void init (GTypeInstance *obj, gpointer g_class);
+static void pass_base_init (gpointer g_class);
+static void pass_class_init (gpointer g_class, gpointer class_data);
+static void pass_init (GTypeInstance *obj, gpointer g_class);
 static void finalize (GObject * object);
 static void free_per_channel_data(GstPeaq *peaq);
 static void alloc_per_channel_data(GstPeaq *peaq);
@@ -176,8 +583,11 @@ static void set_property (GObject *obj, guint id, const GValue *value,
                           GParamSpec *pspec);
 static gboolean set_caps (GstPad *pad, GstCaps *caps);
 static GstFlowReturn pad_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer);
+static GstFlowReturn pad_chain_list (GstPad *pad, GstObject *parent,
+                                     GstBufferList *list);
 static gboolean pad_event (GstPad *pad, GstObject *parent, GstEvent *event);
 static gboolean pad_query (GstPad *pad, GstObject *parent, GstQuery *query);
+static GstIterator *iterate_internal_links (GstPad *pad, GstObject *parent);
 static GstStateChangeReturn change_state (GstElement * element,
                                           GstStateChange transition);
 static void process_fft_block_basic (GstPeaq *peaq, gfloat *refdata,
@@ -185,11 +595,50 @@ static void process_fft_block_basic (GstPeaq *peaq, gfloat *refdata,
 static void process_fft_block_advanced (GstPeaq *peaq, gfloat *refdata,
                                         gfloat *testdata);
 static void process_fb_block (GstPeaq *peaq, gfloat *refdata, gfloat *testdata);
+static void process_fft_block_screening (GstPeaq *peaq, gfloat *refdata,
+                                         gfloat *testdata);
 static double calculate_di_basic (GstPeaq * peaq);
 static double calculate_di_advanced (GstPeaq *peaq);
 static double calculate_odg (GstPeaq * peaq);
 static gboolean is_frame_above_threshold (gfloat *framedata, guint framesize,
                                           guint channels);
+static void reset_stats (GstPeaq *peaq);
+static GstStructure *get_stats (GstPeaq *peaq);
+static GstStructure *get_latency (GstPeaq *peaq);
+static void calc_memory_usage (GstPeaq *peaq, gsize *usage);
+static void update_memory_peak (GstPeaq *peaq);
+static GstStructure *get_memory (GstPeaq *peaq);
+static void start_checkpoints (GstPeaq *peaq);
+static void stop_checkpoints (GstPeaq *peaq);
+static GstStructure *checkpoint_reached (GstPeaq *peaq);
+static void start_screening (GstPeaq *peaq);
+static void stop_screening (GstPeaq *peaq);
+static void post_screen_regions (GstPeaq *peaq);
+static void start_frame_trace (GstPeaq *peaq);
+static void stop_frame_trace (GstPeaq *peaq);
+static void trace_frame (GstPeaq *peaq, enum _LatencyPath path,
+                         gboolean above_thres, gdouble const *energy);
+static void replay_frame_trace (GstPeaq *peaq);
+static void reset_results (GstPeaq *peaq);
+static void calc_movs_fft_basic (GstPeaq *peaq, gboolean above_thres);
+static void calc_movs_fft_advanced (GstPeaq *peaq, gboolean above_thres);
+static void calc_movs_fb (GstPeaq *peaq, gboolean above_thres);
+static void publish_results (GstPeaq *peaq);
+static void read_results (GstPeaq *peaq, struct _Results *results);
+static GstStructure *get_results (GstPeaq *peaq);
+static void finish_frame (GstPeaq *peaq, enum _LatencyPath path,
+                          gboolean above_thres, gdouble const *energy);
+static gboolean is_mov_on_path (GstPeaq *peaq, guint mov,
+                                enum _LatencyPath path);
+static gdouble calculate_di_from (GstPeaq *peaq, PeaqMovAccum *const *accums);
+static void start_results_ring (GstPeaq *peaq);
+static void stop_results_ring (GstPeaq *peaq);
+static void publish_ring_entry (GstPeaq *peaq, enum _LatencyPath path);
+static void advance_window (GstPeaq *peaq);
+static void reset_mov_tracking (GstPeaq *peaq, gboolean onset);
+static gboolean is_frame_scored (GstPeaq *peaq, enum _LatencyPath path);
+static gboolean begin_mov_frame (GstPeaq *peaq, enum _LatencyPath path,
+                                 gboolean above_thres);
 
 GType
 gst_peaq_get_type (void)
@@ -212,6 +661,27 @@ gst_peaq_get_type (void)
   return type;
 }
 
+GType
+gst_peaq_pass_get_type (void)
+{
+  static GType type = 0;
+  if (type == 0) {
+    static const GTypeInfo info = {
+      sizeof (GstPeaqClass),
+      pass_base_init,
+      NULL,                     /* base_finalize */
+      pass_class_init,
+      NULL,                     /* class_finalize */
+      NULL,                     /* class_data */
+      sizeof (GstPeaq),
+      0,                        /* n_preallocs */
+      pass_init
+    };
+    type = g_type_register_static (GST_TYPE_PEAQ, "GstPeaqPass", &info, 0);
+  }
+  return type;
+}
+
 static gboolean
 pad_query (GstPad *pad, GstObject *parent, GstQuery *query)
 {
@@ -222,17 +692,26 @@ pad_query (GstPad *pad, GstObject *parent, GstQuery *query)
         GstCaps *caps;
         GstCaps *mycaps;
         GstCaps *filt;
+        GstPad *srcpad;
         gst_query_parse_caps (query, &filt);
         if (pad == peaq->refpad) {
           mycaps = gst_static_pad_template_get_caps (&gst_peaq_ref_template);
           filt = gst_pad_peer_query_caps (peaq->testpad, filt);
+          srcpad = peaq->refsrcpad;
         } else {
           mycaps = gst_static_pad_template_get_caps (&gst_peaq_test_template);
           filt = gst_pad_peer_query_caps (peaq->refpad, filt);
+          srcpad = peaq->testsrcpad;
         }
         caps = gst_caps_intersect (mycaps, filt);
         gst_caps_unref (filt);
         gst_caps_unref (mycaps);
+        /* when passing the data on, downstream has to accept it, too */
+        if (srcpad) {
+          filt = caps;
+          caps = gst_pad_peer_query_caps (srcpad, filt);
+          gst_caps_unref (filt);
+        }
 
         gst_query_set_caps_result (query, caps);
         gst_caps_unref (caps);
@@ -243,6 +722,41 @@ pad_query (GstPad *pad, GstObject *parent, GstQuery *query)
   }
 }
 
+/*
+ * iterate_internal_links:
+ * @pad: One of the pads of a #GstPeaqPass.
+ * @parent: The #GstPeaqPass.
+ *
+ * Links each sink pad only to the corresponding src pad (and vice versa), so
+ * that the default event and query handling forwards e.g. the segment and
+ * allocation of the test signal to the test_src pad only.
+ *
+ * Returns: An iterator over the linked pad.
+ */
+static GstIterator *
+iterate_internal_links (GstPad *pad, GstObject *parent)
+{
+  GstPeaq *peaq = GST_PEAQ (parent);
+  GValue value = G_VALUE_INIT;
+  GstIterator *it;
+  GstPad *other;
+
+  if (pad == peaq->refpad)
+    other = peaq->refsrcpad;
+  else if (pad == peaq->testpad)
+    other = peaq->testsrcpad;
+  else if (pad == peaq->refsrcpad)
+    other = peaq->refpad;
+  else
+    other = peaq->testpad;
+
+  g_value_init (&value, GST_TYPE_PAD);
+  g_value_set_object (&value, other);
+  it = gst_iterator_new_single (GST_TYPE_PAD, &value);
+  g_value_unset (&value);
+  return it;
+}
+
 
 static void
 base_init (gpointer g_class)
@@ -315,6 +829,204 @@ class_init (gpointer g_class, gpointer class_data)
 							 TRUE,
 							 G_PARAM_READWRITE |
 							 G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_COLLECT_STATS,
+				   g_param_spec_boolean ("collect-stats",
+							 "collect statistics",
+							 "Measure the time spent in the processing stages and per hop",
+							 FALSE,
+							 G_PARAM_READWRITE |
+							 G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_STATS,
+				   g_param_spec_boxed ("stats",
+						       "statistics",
+						       "Time, calls and frames per processing stage",
+						       GST_TYPE_STRUCTURE,
+						       G_PARAM_READABLE));
+  g_object_class_install_property (object_class,
+				   PROP_RESULTS_RING,
+				   g_param_spec_string ("results-ring",
+							"results ring",
+							"Publish per-frame results to the shared-memory ring of this name",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_RESULTS_RING_SLOTS,
+				   g_param_spec_uint ("results-ring-slots",
+						      "results ring slots",
+						      "Number of frames the results ring holds (rounded up to a power of two)",
+						      1, 1 << 24, 1024,
+						      G_PARAM_READWRITE |
+						      G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_RESULTS_RING_WINDOW,
+				   g_param_spec_double ("results-ring-window",
+							"results ring window",
+							"Length in seconds of the windows for which the objective difference grade is published",
+							0.01, G_MAXDOUBLE, 3.,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_SKIP_WARM_UP,
+				   g_param_spec_boolean ("skip-warm-up",
+							 "skip warm-up",
+							 "Skip the MOV calculation for the frames before the first one above the energy threshold, which do not contribute to the results",
+							 TRUE,
+							 G_PARAM_READWRITE |
+							 G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_SCORE_START,
+				   g_param_spec_uint64 ("score-start",
+							"score start",
+							"Sample offset of the first frame contributing to the results; earlier frames only let the ear model settle",
+							0, G_MAXUINT64, 0,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_STATS_INTERVAL,
+				   g_param_spec_uint ("stats-interval",
+						      "statistics interval",
+						      "Number of frames between statistics messages (0 = none)",
+						      0, G_MAXUINT, 100,
+						      G_PARAM_READWRITE |
+						      G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_MEMORY,
+				   g_param_spec_boxed ("memory",
+						       "memory usage",
+						       "Current and peak memory usage in bytes",
+						       GST_TYPE_STRUCTURE,
+						       G_PARAM_READABLE));
+  g_object_class_install_property (object_class,
+				   PROP_LATENCY,
+				   g_param_spec_boxed ("latency",
+						       "processing latency",
+						       "Latency percentiles and deadline misses per hop",
+						       GST_TYPE_STRUCTURE,
+						       G_PARAM_READABLE));
+  g_object_class_install_property (object_class,
+				   PROP_TRACE_FILE,
+				   g_param_spec_string ("trace-file",
+							"trace file",
+							"Write a timeline of the processing stages to this file (defaults to $PEAQ_TRACE)",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_RECORD_FILE,
+				   g_param_spec_string ("record-file",
+							"record file",
+							"Record the pattern of the incoming buffers and events to this file",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_RECORD_DATA,
+				   g_param_spec_boolean ("record-data",
+							 "record data",
+							 "Include the sample data in the recording",
+							 FALSE,
+							 G_PARAM_READWRITE |
+							 G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_CHECKPOINT_FILE,
+				   g_param_spec_string ("checkpoint-file",
+							"checkpoint file",
+							"Store periodic checkpoints of the processing state to this file",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_CHECKPOINT_INTERVAL,
+				   g_param_spec_double ("checkpoint-interval",
+							"checkpoint interval",
+							"Time between checkpoints in seconds",
+							(gdouble) CHECKPOINT_GRANULARITY / 48000,
+							G_MAXDOUBLE, 10.,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_RESUME_FILE,
+				   g_param_spec_string ("resume-file",
+							"resume file",
+							"Re-evaluate only the changed range using the checkpoints in this file",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_CHANGED_START,
+				   g_param_spec_double ("changed-start",
+							"changed range start",
+							"Start of the changed range in seconds",
+							0., G_MAXDOUBLE, 0.,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_CHANGED_END,
+				   g_param_spec_double ("changed-end",
+							"changed range end",
+							"End of the changed range in seconds",
+							0., G_MAXDOUBLE, 0.,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_CONVERGENCE_TOLERANCE,
+				   g_param_spec_double ("convergence-tolerance",
+							"convergence tolerance",
+							"Relative difference up to which the state is considered converged to a checkpoint",
+							0., 1., 1e-6,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_SCREENING,
+				   g_param_spec_boolean ("screening",
+							 "screening mode",
+							 "Only compute NMR and detection probability to flag suspicious regions (basic version only)",
+							 FALSE,
+							 G_PARAM_READWRITE |
+							 G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_SCREEN_NMR_THRESHOLD,
+				   g_param_spec_double ("screen-nmr-threshold",
+							"screening NMR threshold",
+							"Per-frame noise-to-mask ratio in dB above which a frame is flagged",
+							-G_MAXDOUBLE, G_MAXDOUBLE, 0.,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_SCREEN_PD_THRESHOLD,
+				   g_param_spec_double ("screen-pd-threshold",
+							"screening detection probability threshold",
+							"Per-frame probability of detection above which a frame is flagged",
+							0., 1., 0.5,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_FRAME_TRACE_FILE,
+				   g_param_spec_string ("frame-trace-file",
+							"frame trace file",
+							"Write per-frame intermediate quantities to this file",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_FRAME_TRACE_QUANTITIES,
+				   g_param_spec_string ("frame-trace-quantities",
+							"frame trace quantities",
+							"Comma-separated list of the quantities to trace (excitation, unsmeared-excitation, power-spectrum, weighted-power-spectrum, modulation, movs, flags, energy, or replay for all needed by replay-file)",
+							"excitation,movs",
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_REPLAY_FILE,
+				   g_param_spec_string ("replay-file",
+							"replay file",
+							"Compute the result from the intermediate quantities stored in this frame trace instead of the input",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_RESULTS,
+				   g_param_spec_boxed ("results",
+						       "results",
+						       "Model output variables, distortion index, objective difference grade, frame count and total SNR as of the last processed buffer",
+						       GST_TYPE_STRUCTURE,
+						       G_PARAM_READABLE));
 
   gst_element_class_set_static_metadata (element_class,
                                         "Perceptual evaluation of audio quality",
@@ -331,6 +1043,8 @@ init (GTypeInstance *obj, gpointer g_class)
 
   GstPeaq *peaq = GST_PEAQ (obj);
 
+  peaq->refsrcpad = NULL;
+  peaq->testsrcpad = NULL;
   peaq->ref_adapter_fft = gst_adapter_new ();
   peaq->test_adapter_fft = gst_adapter_new ();
   peaq->ref_adapter_fb = gst_adapter_new ();
@@ -340,6 +1054,7 @@ init (GTypeInstance *obj, gpointer g_class)
   peaq->refpad = gst_pad_new_from_template (template, "ref");
   gst_object_unref (template);
   gst_pad_set_chain_function (peaq->refpad, pad_chain);
+  gst_pad_set_chain_list_function (peaq->refpad, pad_chain_list);
   gst_pad_set_event_function (peaq->refpad, pad_event);
   gst_pad_set_query_function (peaq->refpad, pad_query);
   gst_element_add_pad (GST_ELEMENT (peaq), peaq->refpad);
@@ -348,6 +1063,7 @@ init (GTypeInstance *obj, gpointer g_class)
   peaq->testpad = gst_pad_new_from_template (template, "test");
   gst_object_unref (template);
   gst_pad_set_chain_function (peaq->testpad, pad_chain);
+  gst_pad_set_chain_list_function (peaq->testpad, pad_chain_list);
   gst_pad_set_event_function (peaq->testpad, pad_event);
   gst_pad_set_query_function (peaq->testpad, pad_query);
   gst_element_add_pad (GST_ELEMENT (peaq), peaq->testpad);
@@ -359,6 +1075,42 @@ init (GTypeInstance *obj, gpointer g_class)
   peaq->loudness_reached_frame = G_MAXUINT;
   peaq->total_signal_energy = 0.;
   peaq->total_noise_energy = 0.;
+  reset_stats (peaq);
+  peaq->trace_file = g_strdup (g_getenv ("PEAQ_TRACE"));
+  peaq->tracing = FALSE;
+  peaq->record_file = NULL;
+  peaq->recorder = NULL;
+  peaq->checkpoint_file = NULL;
+  peaq->resume_file = NULL;
+  peaq->checkpoints_pending = FALSE;
+  peaq->checkpoints = NULL;
+  peaq->next_checkpoint = G_MAXUINT64;
+  peaq->skip_bytes[0] = 0;
+  peaq->skip_bytes[1] = 0;
+  peaq->spliced = FALSE;
+  peaq->screen_log[0] = NULL;
+  peaq->screen_log[1] = NULL;
+  peaq->screen_region_end = G_MAXUINT64;
+  g_queue_init (&peaq->screen_regions);
+  peaq->frame_trace_file = NULL;
+  peaq->frame_trace_quantities = NULL;
+  peaq->frame_trace_pending = FALSE;
+  peaq->frame_trace = NULL;
+  peaq->replay_file = NULL;
+  peaq->results_seq = 0;
+  memset (&peaq->results, 0, sizeof (peaq->results));
+  peaq->results_ring_name = NULL;
+  peaq->results_ring_pending = FALSE;
+  peaq->results_ring = NULL;
+  memset (peaq->window_accum, 0, sizeof (peaq->window_accum));
+  peaq->ring_values = NULL;
+  reset_mov_tracking (peaq, TRUE);
+  for (i = 0; i < COUNT_LATENCY_PATHS; i++)
+    peaq->trace_columns[i] = g_array_new (FALSE, FALSE,
+                                          sizeof (struct _TraceColumn));
+  peaq->memory_static = 0;
+  peaq->memory_peak = 0;
+  peaq->memory_adapters_peak = 0;
 
   peaq->channels = 0;
   peaq->fft_ear_model = g_object_new (PEAQ_TYPE_FFTEARMODEL, NULL);
@@ -376,6 +1128,64 @@ init (GTypeInstance *obj, gpointer g_class)
     peaq->mov_accum[i] = peaq_movaccum_new ();
 }
 
+static void
+pass_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  GstPadTemplate *pad_template =
+    gst_static_pad_template_get (&gst_peaq_ref_src_template);
+  gst_element_class_add_pad_template (element_class, pad_template);
+
+  pad_template = gst_static_pad_template_get (&gst_peaq_test_src_template);
+  gst_element_class_add_pad_template (element_class, pad_template);
+}
+
+static void
+pass_class_init (gpointer g_class, gpointer class_data)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_set_static_metadata (element_class,
+                                        "Perceptual evaluation of audio quality (passthrough)",
+                                        "Filter/Analyzer/Audio",
+                                        "Compute objective audio quality measures while passing the signals on",
+                                        "Martin Holters <" PACKAGE_BUGREPORT ">");
+}
+
+static void
+pass_init (GTypeInstance *obj, gpointer g_class)
+{
+  GstPadTemplate *template;
+
+  GstPeaq *peaq = GST_PEAQ (obj);
+
+  template = gst_static_pad_template_get (&gst_peaq_ref_src_template);
+  peaq->refsrcpad = gst_pad_new_from_template (template, "ref_src");
+  gst_object_unref (template);
+  gst_pad_set_iterate_internal_links_function (peaq->refsrcpad,
+                                               iterate_internal_links);
+  gst_pad_use_fixed_caps (peaq->refsrcpad);
+  gst_element_add_pad (GST_ELEMENT (peaq), peaq->refsrcpad);
+
+  template = gst_static_pad_template_get (&gst_peaq_test_src_template);
+  peaq->testsrcpad = gst_pad_new_from_template (template, "test_src");
+  gst_object_unref (template);
+  gst_pad_set_iterate_internal_links_function (peaq->testsrcpad,
+                                               iterate_internal_links);
+  gst_pad_use_fixed_caps (peaq->testsrcpad);
+  gst_element_add_pad (GST_ELEMENT (peaq), peaq->testsrcpad);
+
+  gst_pad_set_iterate_internal_links_function (peaq->refpad,
+                                               iterate_internal_links);
+  gst_pad_set_iterate_internal_links_function (peaq->testpad,
+                                               iterate_internal_links);
+  GST_PAD_SET_PROXY_ALLOCATION (peaq->refpad);
+  GST_PAD_SET_PROXY_ALLOCATION (peaq->testpad);
+
+  GST_OBJECT_FLAG_UNSET (peaq, GST_ELEMENT_FLAG_SINK);
+}
+
 static void
 finalize (GObject * object)
 {
@@ -391,8 +1201,25 @@ finalize (GObject * object)
   g_object_unref (peaq->test_adapter_fb);
   g_object_unref (peaq->fft_ear_model);
   g_object_unref (peaq->fb_ear_model);
+  stop_results_ring (peaq);
   for (i = 0; i < COUNT_MOV_BASIC; i++)
     g_object_unref (peaq->mov_accum[i]);
+  g_free (peaq->trace_file);
+  g_free (peaq->record_file);
+  g_free (peaq->checkpoint_file);
+  g_free (peaq->resume_file);
+  if (peaq->checkpoints)
+    peaq_checkpoint_file_free (peaq->checkpoints);
+  stop_screening (peaq);
+  g_queue_foreach (&peaq->screen_regions, (GFunc) gst_structure_free, NULL);
+  g_queue_clear (&peaq->screen_regions);
+  stop_frame_trace (peaq);
+  for (i = 0; i < COUNT_LATENCY_PATHS; i++)
+    g_array_free (peaq->trace_columns[i], TRUE);
+  g_free (peaq->frame_trace_file);
+  g_free (peaq->frame_trace_quantities);
+  g_free (peaq->replay_file);
+  g_free (peaq->results_ring_name);
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -470,6 +1297,8 @@ alloc_per_channel_data (GstPeaq *peaq)
                                               peaq->fb_ear_model);
     }
   }
+
+  update_memory_peak (peaq);
 }
 
 static void
@@ -482,23 +1311,111 @@ get_property (GObject *obj, guint id, GValue *value, GParamSpec *pspec)
 			     "playback-level", value);
       break;
     case PROP_DI:
-      if (peaq->advanced)
-        g_value_set_double (value, calculate_di_advanced (peaq));
-      else
-        g_value_set_double (value, calculate_di_basic (peaq));
+      {
+        struct _Results results;
+        read_results (peaq, &results);
+        g_value_set_double (value, results.di);
+      }
       break;
     case PROP_ODG:
-      g_value_set_double (value, calculate_odg (peaq));
+      {
+        struct _Results results;
+        read_results (peaq, &results);
+        g_value_set_double (value, results.odg);
+      }
       break;
     case PROP_TOTALSNR:
       {
-        gdouble snr = peaq->total_signal_energy / peaq->total_noise_energy;
-        g_value_set_double (value, 10 * log10 (snr));
+        struct _Results results;
+        read_results (peaq, &results);
+        g_value_set_double (value, results.total_snr);
       }
       break;
+    case PROP_RESULTS:
+      g_value_take_boxed (value, get_results (peaq));
+      break;
     case PROP_CONSOLE_OUTPUT:
       g_value_set_boolean (value, peaq->console_output);
       break;
+    case PROP_COLLECT_STATS:
+      g_value_set_boolean (value, peaq->collect_stats);
+      break;
+    case PROP_STATS:
+      GST_OBJECT_LOCK (peaq);
+      g_value_take_boxed (value, get_stats (peaq));
+      GST_OBJECT_UNLOCK (peaq);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, peaq->stats_interval);
+      break;
+    case PROP_MEMORY:
+      GST_OBJECT_LOCK (peaq);
+      g_value_take_boxed (value, get_memory (peaq));
+      GST_OBJECT_UNLOCK (peaq);
+      break;
+    case PROP_LATENCY:
+      g_value_take_boxed (value, get_latency (peaq));
+      break;
+    case PROP_TRACE_FILE:
+      g_value_set_string (value, peaq->trace_file);
+      break;
+    case PROP_RECORD_FILE:
+      g_value_set_string (value, peaq->record_file);
+      break;
+    case PROP_RECORD_DATA:
+      g_value_set_boolean (value, peaq->record_data);
+      break;
+    case PROP_CHECKPOINT_FILE:
+      g_value_set_string (value, peaq->checkpoint_file);
+      break;
+    case PROP_CHECKPOINT_INTERVAL:
+      g_value_set_double (value, peaq->checkpoint_interval);
+      break;
+    case PROP_RESUME_FILE:
+      g_value_set_string (value, peaq->resume_file);
+      break;
+    case PROP_CHANGED_START:
+      g_value_set_double (value, peaq->changed_start);
+      break;
+    case PROP_CHANGED_END:
+      g_value_set_double (value, peaq->changed_end);
+      break;
+    case PROP_CONVERGENCE_TOLERANCE:
+      g_value_set_double (value, peaq->convergence_tolerance);
+      break;
+    case PROP_SCREENING:
+      g_value_set_boolean (value, peaq->screening);
+      break;
+    case PROP_SCREEN_NMR_THRESHOLD:
+      g_value_set_double (value, peaq->screen_nmr_threshold);
+      break;
+    case PROP_SCREEN_PD_THRESHOLD:
+      g_value_set_double (value, peaq->screen_pd_threshold);
+      break;
+    case PROP_FRAME_TRACE_FILE:
+      g_value_set_string (value, peaq->frame_trace_file);
+      break;
+    case PROP_FRAME_TRACE_QUANTITIES:
+      g_value_set_string (value, peaq->frame_trace_quantities);
+      break;
+    case PROP_REPLAY_FILE:
+      g_value_set_string (value, peaq->replay_file);
+      break;
+    case PROP_RESULTS_RING:
+      g_value_set_string (value, peaq->results_ring_name);
+      break;
+    case PROP_RESULTS_RING_SLOTS:
+      g_value_set_uint (value, peaq->results_ring_slots);
+      break;
+    case PROP_RESULTS_RING_WINDOW:
+      g_value_set_double (value, peaq->results_ring_window);
+      break;
+    case PROP_SKIP_WARM_UP:
+      g_value_set_boolean (value, peaq->skip_warm_up);
+      break;
+    case PROP_SCORE_START:
+      g_value_set_uint64 (value, peaq->score_start);
+      break;
   }
 }
 
@@ -562,21 +1479,91 @@ set_property (GObject *obj, guint id, const GValue *value, GParamSpec *pspec)
     case PROP_CONSOLE_OUTPUT:
       peaq->console_output = g_value_get_boolean (value);
       break;
+    case PROP_COLLECT_STATS:
+      peaq->collect_stats = g_value_get_boolean (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      peaq->stats_interval = g_value_get_uint (value);
+      break;
+    case PROP_TRACE_FILE:
+      g_free (peaq->trace_file);
+      peaq->trace_file = g_value_dup_string (value);
+      break;
+    case PROP_RECORD_FILE:
+      g_free (peaq->record_file);
+      peaq->record_file = g_value_dup_string (value);
+      break;
+    case PROP_RECORD_DATA:
+      peaq->record_data = g_value_get_boolean (value);
+      break;
+    case PROP_CHECKPOINT_FILE:
+      g_free (peaq->checkpoint_file);
+      peaq->checkpoint_file = g_value_dup_string (value);
+      break;
+    case PROP_CHECKPOINT_INTERVAL:
+      peaq->checkpoint_interval = g_value_get_double (value);
+      break;
+    case PROP_RESUME_FILE:
+      g_free (peaq->resume_file);
+      peaq->resume_file = g_value_dup_string (value);
+      break;
+    case PROP_CHANGED_START:
+      peaq->changed_start = g_value_get_double (value);
+      break;
+    case PROP_CHANGED_END:
+      peaq->changed_end = g_value_get_double (value);
+      break;
+    case PROP_CONVERGENCE_TOLERANCE:
+      peaq->convergence_tolerance = g_value_get_double (value);
+      break;
+    case PROP_SCREENING:
+      peaq->screening = g_value_get_boolean (value);
+      break;
+    case PROP_SCREEN_NMR_THRESHOLD:
+      peaq->screen_nmr_threshold = g_value_get_double (value);
+      break;
+    case PROP_SCREEN_PD_THRESHOLD:
+      peaq->screen_pd_threshold = g_value_get_double (value);
+      break;
+    case PROP_FRAME_TRACE_FILE:
+      g_free (peaq->frame_trace_file);
+      peaq->frame_trace_file = g_value_dup_string (value);
+      break;
+    case PROP_FRAME_TRACE_QUANTITIES:
+      g_free (peaq->frame_trace_quantities);
+      peaq->frame_trace_quantities = g_value_dup_string (value);
+      break;
+    case PROP_REPLAY_FILE:
+      g_free (peaq->replay_file);
+      peaq->replay_file = g_value_dup_string (value);
+      break;
+    case PROP_RESULTS_RING:
+      g_free (peaq->results_ring_name);
+      peaq->results_ring_name = g_value_dup_string (value);
+      break;
+    case PROP_RESULTS_RING_SLOTS:
+      peaq->results_ring_slots = g_value_get_uint (value);
+      break;
+    case PROP_RESULTS_RING_WINDOW:
+      peaq->results_ring_window = g_value_get_double (value);
+      break;
+    case PROP_SKIP_WARM_UP:
+      peaq->skip_warm_up = g_value_get_boolean (value);
+      break;
+    case PROP_SCORE_START:
+      peaq->score_start = g_value_get_uint64 (value);
+      break;
   }
 }
 
-static gboolean
-set_caps (GstPad *pad, GstCaps *caps)
+static void
+set_channels (GstPeaq *peaq, gint channels)
 {
-  GstPeaq *peaq = GST_PEAQ (gst_pad_get_parent_element (pad));
-
-  GST_OBJECT_LOCK (peaq);
+  guint i;
 
   free_per_channel_data (peaq);
 
-  guint i;
-  gst_structure_get_int (gst_caps_get_structure (caps, 0),
-                         "channels", &(peaq->channels));
+  peaq->channels = channels;
   for (i = 0; i < COUNT_MOV_BASIC; i++)
     if (!peaq->advanced && (i == MOVBASIC_ADB || i == MOVBASIC_MFPD))
       peaq_movaccum_set_channels (peaq->mov_accum[i], 1);
@@ -584,7 +1571,19 @@ set_caps (GstPad *pad, GstCaps *caps)
       peaq_movaccum_set_channels (peaq->mov_accum[i], peaq->channels);
 
   alloc_per_channel_data (peaq);
+}
+
+static gboolean
+set_caps (GstPad *pad, GstCaps *caps)
+{
+  gint channels;
+  GstPeaq *peaq = GST_PEAQ (gst_pad_get_parent_element (pad));
 
+  GST_OBJECT_LOCK (peaq);
+  channels = peaq->channels;
+  gst_structure_get_int (gst_caps_get_structure (caps, 0),
+                         "channels", &channels);
+  set_channels (peaq, channels);
   GST_OBJECT_UNLOCK (peaq);
 
   gst_object_unref (peaq);
@@ -592,83 +1591,1583 @@ set_caps (GstPad *pad, GstCaps *caps)
   return TRUE;
 }
 
-static void
-do_processing (GstPeaq *peaq, GstAdapter *ref_adapter, GstAdapter *test_adapter,
-               void (*process_block)(GstPeaq *, gfloat*, gfloat *),
-               guint frame_size_bytes, guint step_size_bytes)
+/*
+ * stats_start:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Returns: The current time if #GstPeaq:collect-stats is enabled or tracing
+ * is active, 0 otherwise.
+ */
+static inline GstClockTime
+stats_start (GstPeaq *peaq)
 {
-  while (gst_adapter_available (ref_adapter) >= frame_size_bytes &&
-         gst_adapter_available (test_adapter) >= frame_size_bytes)
-  {
-    gfloat *refframe = (gfloat *) gst_adapter_map (ref_adapter, frame_size_bytes);
-    gfloat *testframe = (gfloat *) gst_adapter_map (test_adapter, frame_size_bytes);
-    process_block (peaq, refframe, testframe);
+  return G_UNLIKELY (peaq->collect_stats || peaq_tracer_active) ?
+    gst_util_get_timestamp () : 0;
+}
+
+/*
+ * stats_stop:
+ * @peaq: The #GstPeaq instance.
+ * @stage: The processing stage to account the elapsed time to.
+ * @start: The time as returned by stats_start() or a previous stats_stop().
+ * @calls: Number of calls to add to the statistics of @stage.
+ * @frames: Number of frames to add to the statistics of @stage.
+ *
+ * Accumulates the time elapsed since @start to the statistics of @stage if
+ * #GstPeaq:collect-stats is enabled and records it as a section named after
+ * @stage if tracing is active.
+ *
+ * Returns: The current time to be used as @start for the next stage.
+ */
+static inline GstClockTime
+stats_stop (GstPeaq *peaq, enum _Stage stage, GstClockTime start, guint calls,
+            guint frames)
+{
+  if (G_UNLIKELY (peaq->collect_stats || peaq_tracer_active)) {
+    GstClockTime now = gst_util_get_timestamp ();
+    if (peaq->collect_stats) {
+      peaq->stats[stage].time += now - start;
+      peaq->stats[stage].calls += calls;
+      peaq->stats[stage].frames += frames;
+    }
+    if (peaq_tracer_active && stage != STAGE_FRAMING)
+      peaq_tracer_record (stage_names[stage], start, now);
+    return now;
+  }
+  return 0;
+}
+
+static GstClockTime
+stats_processing_time (GstPeaq *peaq)
+{
+  guint i;
+  GstClockTime time = 0;
+  for (i = 0; i < COUNT_STAGES; i++)
+    if (i != STAGE_FRAMING)
+      time += peaq->stats[i].time;
+  return time;
+}
+
+static void
+reset_stats (GstPeaq *peaq)
+{
+  memset (peaq->stats, 0, sizeof (peaq->stats));
+  memset (peaq->latency, 0, sizeof (peaq->latency));
+  peaq->stats_posted_frame = 0;
+}
+
+/*
+ * latency_bucket:
+ * @latency: A latency in nanoseconds.
+ *
+ * Maps @latency to a histogram bucket such that every octave is split into
+ * 2^LATENCY_SUB_BUCKET_BITS buckets, giving a relative resolution of 25%
+ * irrespective of the magnitude. Small values map to themselves.
+ *
+ * Returns: The bucket index, less than %LATENCY_BUCKETS.
+ */
+static inline guint
+latency_bucket (GstClockTime latency)
+{
+  guint msb;
+  if (latency > G_MAXUINT32)
+    latency = G_MAXUINT32;
+  if (latency < (1 << LATENCY_SUB_BUCKET_BITS))
+    return latency;
+  msb = g_bit_storage ((gulong) latency) - 1;
+  return ((msb - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS) +
+    ((latency >> (msb - LATENCY_SUB_BUCKET_BITS)) &
+     ((1 << LATENCY_SUB_BUCKET_BITS) - 1));
+}
+
+/*
+ * latency_bucket_upper:
+ * @bucket: A bucket index as returned by latency_bucket().
+ *
+ * Returns: The smallest latency in nanoseconds above the ones mapped to
+ * @bucket.
+ */
+static GstClockTime
+latency_bucket_upper (guint bucket)
+{
+  guint shift;
+  if (bucket < (2 << LATENCY_SUB_BUCKET_BITS))
+    return bucket + 1;
+  shift = (bucket >> LATENCY_SUB_BUCKET_BITS) - 1;
+  return (GstClockTime) ((bucket & ((1 << LATENCY_SUB_BUCKET_BITS) - 1)) +
+                         (1 << LATENCY_SUB_BUCKET_BITS) + 1) << shift;
+}
+
+/*
+ * latency_record:
+ * @histogram: The #_LatencyHistogram to update.
+ * @latency: The time needed to process one hop in nanoseconds.
+ * @deadline: The time corresponding to the hop size in nanoseconds.
+ *
+ * Adds @latency to @histogram. Only atomic operations are used, such that
+ * get_latency() may read the histogram concurrently without taking the object
+ * lock. On 32 bit hosts, the counters wrap around after 2^32 hops of one path
+ * (about three years of FFT hops or six months of filter bank hops in real
+ * time).
+ */
+static inline void
+latency_record (struct _LatencyHistogram *histogram, GstClockTime latency,
+                GstClockTime deadline)
+{
+  g_atomic_pointer_add (&histogram->buckets[latency_bucket (latency)], 1);
+  if (latency > deadline)
+    g_atomic_pointer_add (&histogram->deadline_misses, 1);
+}
+
+static GstClockTime
+latency_percentile (gsize const *buckets, guint64 hops, gdouble p)
+{
+  guint i;
+  guint64 count = 0;
+  guint64 target = ceil (p * hops);
+  if (hops == 0)
+    return 0;
+  for (i = 0; i < LATENCY_BUCKETS; i++) {
+    count += buckets[i];
+    if (count >= target)
+      return latency_bucket_upper (i);
+  }
+  return latency_bucket_upper (LATENCY_BUCKETS - 1);
+}
+
+/*
+ * get_latency:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Summarizes the per-hop latency histograms. May be called without holding the
+ * object lock; as the buckets are read one by one while processing continues,
+ * the percentiles may be off by the hops recorded during the call.
+ *
+ * Returns: A "peaq-latency" #GstStructure with the number of hops, the 50th,
+ * 99th and 99.9th percentile of the latency (upper bucket bound) in
+ * nanoseconds, the deadline and the number of deadline misses per path.
+ */
+static GstStructure *
+get_latency (GstPeaq *peaq)
+{
+  guint path, i;
+  GstStructure *latency = gst_structure_new_empty ("peaq-latency");
+  for (path = 0; path < COUNT_LATENCY_PATHS; path++) {
+    struct _LatencyHistogram *histogram = &peaq->latency[path];
+    PeaqEarModel *model =
+      path == LATENCY_FB ? peaq->fb_ear_model : peaq->fft_ear_model;
+    gsize buckets[LATENCY_BUCKETS];
+    guint64 hops = 0;
+    gchar *name;
+
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+      buckets[i] = (gsize) g_atomic_pointer_get (&histogram->buckets[i]);
+      hops += buckets[i];
+    }
+
+#define SET_FIELD(suffix, value) \
+    name = g_strconcat (latency_path_names[path], suffix, NULL); \
+    gst_structure_set (latency, name, G_TYPE_UINT64, (guint64) (value), NULL); \
+    g_free (name)
+    SET_FIELD ("-hops", hops);
+    SET_FIELD ("-p50", latency_percentile (buckets, hops, 0.5));
+    SET_FIELD ("-p99", latency_percentile (buckets, hops, 0.99));
+    SET_FIELD ("-p999", latency_percentile (buckets, hops, 0.999));
+    SET_FIELD ("-deadline",
+               gst_util_uint64_scale (peaq_earmodel_get_step_size (model),
+                                      GST_SECOND, 48000));
+    SET_FIELD ("-deadline-misses",
+               (gsize) g_atomic_pointer_get (&histogram->deadline_misses));
+#undef SET_FIELD
+  }
+  return latency;
+}
+
+static GstStructure *
+get_stats (GstPeaq *peaq)
+{
+  guint i;
+  GstStructure *stats = gst_structure_new ("peaq-stats",
+                                           "enabled", G_TYPE_BOOLEAN,
+                                           peaq->collect_stats,
+                                           "frames", G_TYPE_UINT,
+                                           peaq->frame_counter,
+                                           "fb-frames", G_TYPE_UINT,
+                                           peaq->frame_counter_fb,
+                                           NULL);
+  for (i = 0; i < COUNT_STAGES; i++) {
+    gchar *time_name = g_strconcat (stage_names[i], "-time", NULL);
+    gchar *calls_name = g_strconcat (stage_names[i], "-calls", NULL);
+    gchar *frames_name = g_strconcat (stage_names[i], "-frames", NULL);
+    gst_structure_set (stats,
+                       time_name, G_TYPE_UINT64, peaq->stats[i].time,
+                       calls_name, G_TYPE_UINT64, peaq->stats[i].calls,
+                       frames_name, G_TYPE_UINT64, peaq->stats[i].frames,
+                       NULL);
+    g_free (time_name);
+    g_free (calls_name);
+    g_free (frames_name);
+  }
+  return stats;
+}
+
+/*
+ * calc_memory_usage:
+ * @peaq: The #GstPeaq instance.
+ * @usage: Array of %COUNT_MEMORY elements to store the number of bytes per
+ * category in.
+ *
+ * Determines the memory currently allocated by @peaq, where the size of the
+ * GstAdapter bookkeeping is neglected and only the data buffered in the
+ * adapters is taken into account.
+ */
+static void
+calc_memory_usage (GstPeaq *peaq, gsize *usage)
+{
+  guint c, i;
+
+  memset (usage, 0, COUNT_MEMORY * sizeof (gsize));
+
+  usage[MEMORY_ELEMENT] = sizeof (GstPeaq);
+
+  usage[MEMORY_EAR_MODELS] =
+    peaq_earmodel_get_memory_size (peaq->fft_ear_model) +
+    peaq_earmodel_get_memory_size (peaq->fb_ear_model);
+
+  if (peaq->ref_fft_ear_state)
+    usage[MEMORY_EAR_MODEL_STATES] += 2 * peaq->channels *
+      (sizeof (gpointer) + peaq_earmodel_get_state_size (peaq->fft_ear_model));
+  if (peaq->advanced && peaq->ref_fb_ear_state)
+    usage[MEMORY_EAR_MODEL_STATES] += 2 * peaq->channels *
+      (sizeof (gpointer) + peaq_earmodel_get_state_size (peaq->fb_ear_model));
+
+  if (peaq->level_adapter)
+    for (c = 0; c < peaq->channels; c++)
+      usage[MEMORY_PREPROCESSING] += sizeof (gpointer) +
+        peaq_leveladapter_get_memory_size (peaq->level_adapter[c]);
+  if (peaq->ref_modulation_processor)
+    for (c = 0; c < peaq->channels; c++)
+      usage[MEMORY_PREPROCESSING] += 2 * sizeof (gpointer) +
+        peaq_modulationprocessor_get_memory_size (peaq->ref_modulation_processor[c]) +
+        peaq_modulationprocessor_get_memory_size (peaq->test_modulation_processor[c]);
+
+  for (i = 0; i < COUNT_MOV_BASIC; i++)
+    usage[MEMORY_ACCUMULATORS] +=
+      peaq_movaccum_get_memory_size (peaq->mov_accum[i]);
+
+  usage[MEMORY_ADAPTERS] =
+    gst_adapter_available (peaq->ref_adapter_fft) +
+    gst_adapter_available (peaq->test_adapter_fft) +
+    gst_adapter_available (peaq->ref_adapter_fb) +
+    gst_adapter_available (peaq->test_adapter_fb);
+}
+
+/*
+ * update_memory_peak:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Re-determines the memory allocated for everything but the adapters, which
+ * changes only when (re-)allocating the per-channel data, and updates the peak
+ * usage.
+ */
+static void
+update_memory_peak (GstPeaq *peaq)
+{
+  gsize usage[COUNT_MEMORY];
+  guint i;
+
+  calc_memory_usage (peaq, usage);
+  peaq->memory_static = 0;
+  for (i = 0; i < COUNT_MEMORY; i++)
+    if (i != MEMORY_ADAPTERS)
+      peaq->memory_static += usage[i];
+  if (usage[MEMORY_ADAPTERS] > peaq->memory_adapters_peak)
+    peaq->memory_adapters_peak = usage[MEMORY_ADAPTERS];
+  if (peaq->memory_static + usage[MEMORY_ADAPTERS] > peaq->memory_peak)
+    peaq->memory_peak = peaq->memory_static + usage[MEMORY_ADAPTERS];
+}
+
+static GstStructure *
+get_memory (GstPeaq *peaq)
+{
+  guint i;
+  gsize usage[COUNT_MEMORY];
+  guint64 total = 0;
+  GstStructure *memory = gst_structure_new_empty ("peaq-memory");
+
+  calc_memory_usage (peaq, usage);
+  for (i = 0; i < COUNT_MEMORY; i++) {
+    gst_structure_set (memory, memory_names[i], G_TYPE_UINT64,
+                       (guint64) usage[i], NULL);
+    total += usage[i];
+  }
+  gst_structure_set (memory,
+                     "total", G_TYPE_UINT64, total,
+                     "peak-adapters", G_TYPE_UINT64,
+                     (guint64) peaq->memory_adapters_peak,
+                     "peak-total", G_TYPE_UINT64,
+                     (guint64) MAX (peaq->memory_peak, total),
+                     NULL);
+  return memory;
+}
+
+/*
+ * checkpoint_state:
+ * @peaq: The #GstPeaq instance.
+ * @data: Array to save the state to or restore it from, or %NULL.
+ * @restore: Whether to restore the state from @data instead of saving it.
+ *
+ * Saves or restores the processing state, i.e. the ear model states, level
+ * adapters and modulation processors of all channels.
+ *
+ * Returns: The number of values in the state.
+ */
+static gsize
+checkpoint_state (GstPeaq *peaq, gdouble *data, gboolean restore)
+{
+  guint c;
+  gsize size = 0;
+  gsize fft_size = peaq_earmodel_get_checkpoint_size (peaq->fft_ear_model);
+  gsize fb_size = peaq_earmodel_get_checkpoint_size (peaq->fb_ear_model);
+  for (c = 0; c < peaq->channels; c++) {
+    gsize level_size =
+      peaq_leveladapter_get_checkpoint_size (peaq->level_adapter[c]);
+    gsize modproc_size =
+      peaq_modulationprocessor_get_checkpoint_size (peaq->ref_modulation_processor[c]);
+    if (data && restore) {
+      peaq_earmodel_state_restore_checkpoint (peaq->fft_ear_model,
+                                              peaq->ref_fft_ear_state[c],
+                                              data + size);
+      peaq_earmodel_state_restore_checkpoint (peaq->fft_ear_model,
+                                              peaq->test_fft_ear_state[c],
+                                              data + size + fft_size);
+      peaq_leveladapter_restore_checkpoint (peaq->level_adapter[c],
+                                            data + size + 2 * fft_size);
+      peaq_modulationprocessor_restore_checkpoint (peaq->ref_modulation_processor[c],
+                                                   data + size + 2 * fft_size +
+                                                   level_size);
+      peaq_modulationprocessor_restore_checkpoint (peaq->test_modulation_processor[c],
+                                                   data + size + 2 * fft_size +
+                                                   level_size + modproc_size);
+    } else if (data) {
+      peaq_earmodel_state_save_checkpoint (peaq->fft_ear_model,
+                                           peaq->ref_fft_ear_state[c],
+                                           data + size);
+      peaq_earmodel_state_save_checkpoint (peaq->fft_ear_model,
+                                           peaq->test_fft_ear_state[c],
+                                           data + size + fft_size);
+      peaq_leveladapter_save_checkpoint (peaq->level_adapter[c],
+                                         data + size + 2 * fft_size);
+      peaq_modulationprocessor_save_checkpoint (peaq->ref_modulation_processor[c],
+                                                data + size + 2 * fft_size +
+                                                level_size);
+      peaq_modulationprocessor_save_checkpoint (peaq->test_modulation_processor[c],
+                                                data + size + 2 * fft_size +
+                                                level_size + modproc_size);
+    }
+    size += 2 * fft_size + level_size + 2 * modproc_size;
+    if (peaq->advanced) {
+      if (data && restore) {
+        peaq_earmodel_state_restore_checkpoint (peaq->fb_ear_model,
+                                                peaq->ref_fb_ear_state[c],
+                                                data + size);
+        peaq_earmodel_state_restore_checkpoint (peaq->fb_ear_model,
+                                                peaq->test_fb_ear_state[c],
+                                                data + size + fb_size);
+      } else if (data) {
+        peaq_earmodel_state_save_checkpoint (peaq->fb_ear_model,
+                                             peaq->ref_fb_ear_state[c],
+                                             data + size);
+        peaq_earmodel_state_save_checkpoint (peaq->fb_ear_model,
+                                             peaq->test_fb_ear_state[c],
+                                             data + size + fb_size);
+      }
+      size += 2 * fb_size;
+    }
+  }
+  return size;
+}
+
+/*
+ * checkpoint_accum:
+ * @peaq: The #GstPeaq instance.
+ * @data: Array to save the accumulator states to or restore them from, or
+ * %NULL.
+ * @restore: Whether to restore the states from @data instead of saving them.
+ *
+ * Returns: The number of values in the accumulator states.
+ */
+static gsize
+checkpoint_accum (GstPeaq *peaq, gdouble *data, gboolean restore)
+{
+  guint i;
+  gsize size = 0;
+  for (i = 0; i < COUNT_MOV_BASIC; i++) {
+    if (data && restore)
+      peaq_movaccum_restore_checkpoint (peaq->mov_accum[i], data + size);
+    else if (data)
+      peaq_movaccum_save_checkpoint (peaq->mov_accum[i], data + size);
+    size += peaq_movaccum_get_checkpoint_size (peaq->mov_accum[i]);
+  }
+  return size;
+}
+
+static void
+save_checkpoint (GstPeaq *peaq, PeaqCheckpoint *checkpoint)
+{
+  checkpoint->frame_counter = peaq->frame_counter;
+  checkpoint->frame_counter_fb = peaq->frame_counter_fb;
+  checkpoint->loudness_reached_frame = peaq->loudness_reached_frame;
+  checkpoint->total_signal_energy = peaq->total_signal_energy;
+  checkpoint->total_noise_energy = peaq->total_noise_energy;
+  checkpoint_state (peaq, checkpoint->state, FALSE);
+  checkpoint_accum (peaq, checkpoint->accum, FALSE);
+  /* start the log following the checkpoint with explicit tentative states,
+   * it may be replayed on accumulators in a different one */
+  reset_mov_tracking (peaq, FALSE);
+}
+
+static void
+restore_checkpoint (GstPeaq *peaq, PeaqCheckpoint *checkpoint)
+{
+  peaq->frame_counter = checkpoint->frame_counter;
+  peaq->frame_counter_fb = checkpoint->frame_counter_fb;
+  peaq->loudness_reached_frame = checkpoint->loudness_reached_frame;
+  peaq->total_signal_energy = checkpoint->total_signal_energy;
+  peaq->total_noise_energy = checkpoint->total_noise_energy;
+  checkpoint_state (peaq, checkpoint->state, TRUE);
+  checkpoint_accum (peaq, checkpoint->accum, TRUE);
+  reset_mov_tracking (peaq, TRUE);
+}
+
+/*
+ * start_checkpoints:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Called with the first buffer (when the number of channels is known) to
+ * either start recording checkpoints to #GstPeaq:checkpoint-file or to
+ * restore the state from the last checkpoint in #GstPeaq:resume-file before
+ * the changed range.
+ */
+static void
+start_checkpoints (GstPeaq *peaq)
+{
+  guint i;
+  gsize state_size = checkpoint_state (peaq, NULL, FALSE);
+  gsize accum_size = checkpoint_accum (peaq, NULL, FALSE);
+  gdouble playback_level;
+
+  g_object_get (peaq->fft_ear_model, "playback-level", &playback_level, NULL);
+  peaq->checkpoints_pending = FALSE;
+  peaq->next_checkpoint = G_MAXUINT64;
+
+  if (peaq->resume_file) {
+    GError *error = NULL;
+    PeaqCheckpointFile *file;
+    PeaqCheckpoint *restart = NULL;
+    guint64 changed_start = peaq->changed_start * 48000;
+    guint64 changed_end = ceil (peaq->changed_end * 48000);
+    /* the FFT frame preceding a checkpoint overlaps the next step_size
+     * samples, which therefore must not have changed */
+    guint step_size = peaq_earmodel_get_step_size (peaq->fft_ear_model);
+
+    file = peaq_checkpoint_file_read (peaq->resume_file, &error);
+    if (!file) {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+    /* the stored contributions were computed at the stored playback level */
+    if (file->advanced != peaq->advanced || file->channels != peaq->channels ||
+        file->playback_level != playback_level ||
+        file->accum_count != COUNT_MOV_BASIC ||
+        file->state_size != state_size || file->accum_size != accum_size ||
+        !file->final) {
+      g_warning ("checkpoints in %s do not match the current configuration",
+                 peaq->resume_file);
+      peaq_checkpoint_file_free (file);
+      return;
+    }
+
+    if (changed_start >= step_size)
+      restart = peaq_checkpoint_file_find_before (file,
+                                                  changed_start - step_size);
+    if (restart) {
+      restore_checkpoint (peaq, restart);
+      peaq->skip_bytes[0] = peaq->skip_bytes[1] =
+        restart->position * peaq->channels * sizeof (gfloat);
+    }
+
+    /* convergence can only be reached once all frames overlapping the changed
+     * range have been processed */
+    for (i = 0; i < file->checkpoints->len; i++) {
+      PeaqCheckpoint *checkpoint = g_ptr_array_index (file->checkpoints, i);
+      if (checkpoint->position >= changed_end &&
+          (!restart || checkpoint->position > restart->position))
+        break;
+    }
+    peaq->checkpoint_index = i;
+    if (i < file->checkpoints->len)
+      peaq->next_checkpoint =
+        ((PeaqCheckpoint *) g_ptr_array_index (file->checkpoints, i))->position;
+    peaq->checkpoints = file;
+    peaq->resuming = TRUE;
+  } else {
+    peaq->checkpoints =
+      peaq_checkpoint_file_new (peaq->advanced, peaq->channels,
+                                playback_level, COUNT_MOV_BASIC, state_size,
+                                accum_size);
+    for (i = 0; i < COUNT_MOV_BASIC; i++)
+      peaq_movaccum_set_log (peaq->mov_accum[i], peaq->checkpoints->logs[i]);
+    peaq->checkpoint_step = CHECKPOINT_GRANULARITY *
+      MAX (1, (guint64) (peaq->checkpoint_interval * 48000 /
+                         CHECKPOINT_GRANULARITY + 0.5));
+    peaq->next_checkpoint = peaq->checkpoint_step;
+    peaq->resuming = FALSE;
+  }
+}
+
+/*
+ * stop_checkpoints:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Called after the final flush to write the recorded checkpoints, including
+ * the final state, to #GstPeaq:checkpoint-file.
+ */
+static void
+stop_checkpoints (GstPeaq *peaq)
+{
+  guint i;
+  if (!peaq->resuming) {
+    PeaqCheckpoint *final =
+      peaq_checkpoint_file_set_final (peaq->checkpoints,
+                                      (guint64) peaq->frame_counter *
+                                      peaq_earmodel_get_step_size (peaq->fft_ear_model));
+    save_checkpoint (peaq, final);
+    for (i = 0; i < COUNT_MOV_BASIC; i++)
+      peaq_movaccum_set_log (peaq->mov_accum[i], NULL);
+    if (!peaq_checkpoint_file_write (peaq->checkpoints, peaq->checkpoint_file))
+      g_warning ("could not write checkpoint file %s", peaq->checkpoint_file);
+  }
+  peaq_checkpoint_file_free (peaq->checkpoints);
+  peaq->checkpoints = NULL;
+  peaq->next_checkpoint = G_MAXUINT64;
+}
+
+/*
+ * splice:
+ * @peaq: The #GstPeaq instance.
+ * @checkpoint: The stored checkpoint the state has converged to.
+ *
+ * Replays the contributions logged after @checkpoint to the accumulators and
+ * takes over the frame counters and energies from the end of the stored run.
+ *
+ * Returns: A "peaq-splice" structure to post.
+ */
+static GstStructure *
+splice (GstPeaq *peaq, PeaqCheckpoint *checkpoint)
+{
+  guint i;
+  PeaqCheckpoint *final = peaq->checkpoints->final;
+  for (i = 0; i < COUNT_MOV_BASIC; i++) {
+    GArray *log = peaq->checkpoints->logs[i];
+    guint64 start = checkpoint->log_positions[i];
+    peaq_movaccum_replay (peaq->mov_accum[i],
+                          &g_array_index (log, gdouble, start),
+                          final->log_positions[i] - start);
+  }
+  peaq->total_signal_energy +=
+    final->total_signal_energy - checkpoint->total_signal_energy;
+  peaq->total_noise_energy +=
+    final->total_noise_energy - checkpoint->total_noise_energy;
+  peaq->frame_counter = final->frame_counter;
+  peaq->frame_counter_fb = final->frame_counter_fb;
+  reset_mov_tracking (peaq, TRUE);
+  if (peaq->loudness_reached_frame == G_MAXUINT)
+    peaq->loudness_reached_frame = final->loudness_reached_frame;
+
+  gst_adapter_clear (peaq->ref_adapter_fft);
+  gst_adapter_clear (peaq->test_adapter_fft);
+  gst_adapter_clear (peaq->ref_adapter_fb);
+  gst_adapter_clear (peaq->test_adapter_fb);
+  peaq->spliced = TRUE;
+  peaq->next_checkpoint = G_MAXUINT64;
+
+  return gst_structure_new ("peaq-splice",
+                            "position", G_TYPE_UINT64, checkpoint->position,
+                            "end", G_TYPE_UINT64, final->position,
+                            NULL);
+}
+
+/*
+ * checkpoint_reached:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Called when all frames before #GstPeaq.next_checkpoint have been processed
+ * to either store a new checkpoint or to compare the state to the stored one
+ * and splice in the stored contributions if it has converged.
+ *
+ * Returns: A "peaq-splice" structure to post if the stored contributions have
+ * been spliced in, %NULL otherwise.
+ */
+static GstStructure *
+checkpoint_reached (GstPeaq *peaq)
+{
+  PeaqCheckpointFile *file = peaq->checkpoints;
+  PeaqCheckpoint *checkpoint;
+  gdouble *state;
+  gboolean converged;
+  guint frames, lag;
+
+  if (!peaq->resuming) {
+    checkpoint = peaq_checkpoint_file_add (file, peaq->next_checkpoint);
+    save_checkpoint (peaq, checkpoint);
+    peaq->next_checkpoint += peaq->checkpoint_step;
+    return NULL;
+  }
+
+  checkpoint = g_ptr_array_index (file->checkpoints, peaq->checkpoint_index);
+  state = g_new (gdouble, file->state_size);
+  checkpoint_state (peaq, state, FALSE);
+  converged = peaq_checkpoint_converged (checkpoint->state, state,
+                                         file->state_size,
+                                         peaq->convergence_tolerance);
+  g_free (state);
+
+  /* the loudness threshold delays the accumulation of some MOVs; the
+   * contributions can only be used if that happens in the same frames */
+  frames = peaq->advanced ? peaq->frame_counter_fb : peaq->frame_counter;
+  lag = peaq->advanced ? 13 : 3;
+  if (peaq->loudness_reached_frame != checkpoint->loudness_reached_frame &&
+      (peaq->loudness_reached_frame == G_MAXUINT ||
+       checkpoint->loudness_reached_frame == G_MAXUINT ||
+       peaq->loudness_reached_frame + lag > frames ||
+       checkpoint->loudness_reached_frame + lag > frames))
+    converged = FALSE;
+
+  if (converged)
+    return splice (peaq, checkpoint);
+
+  peaq->checkpoint_index++;
+  if (peaq->checkpoint_index < file->checkpoints->len)
+    peaq->next_checkpoint =
+      ((PeaqCheckpoint *) g_ptr_array_index (file->checkpoints,
+                                             peaq->checkpoint_index))->position;
+  else
+    peaq->next_checkpoint = G_MAXUINT64;
+  return NULL;
+}
+
+/*
+ * start_screening:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Taps the per-frame contributions to the Total NMRB and MFPDB accumulators by
+ * means of their logs if #GstPeaq:screening is enabled in basic mode.
+ */
+static void
+start_screening (GstPeaq *peaq)
+{
+  guint i;
+  if (!peaq->screening || peaq->advanced)
+    return;
+  for (i = 0; i < 2; i++)
+    peaq->screen_log[i] = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  peaq_movaccum_set_log (peaq->mov_accum[MOVBASIC_TOTAL_NMR],
+                         peaq->screen_log[0]);
+  peaq_movaccum_set_log (peaq->mov_accum[MOVBASIC_MFPD], peaq->screen_log[1]);
+  peaq->screen_region_end = G_MAXUINT64;
+}
+
+/*
+ * close_screen_region:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Queues a "peaq-flagged-region" structure for the currently open region of
+ * flagged frames, if any, to be posted by post_screen_regions().
+ */
+static void
+close_screen_region (GstPeaq *peaq)
+{
+  if (peaq->screen_region_end == G_MAXUINT64)
+    return;
+  g_queue_push_tail (&peaq->screen_regions,
+                     gst_structure_new ("peaq-flagged-region",
+                                        "start", G_TYPE_UINT64,
+                                        peaq->screen_region_start,
+                                        "end", G_TYPE_UINT64,
+                                        peaq->screen_region_end,
+                                        "max-nmr", G_TYPE_DOUBLE,
+                                        peaq->screen_max_nmr,
+                                        "max-pd", G_TYPE_DOUBLE,
+                                        peaq->screen_max_pd,
+                                        NULL));
+  peaq->screen_region_end = G_MAXUINT64;
+}
+
+static void
+stop_screening (GstPeaq *peaq)
+{
+  guint i;
+  if (!peaq->screen_log[0])
+    return;
+  close_screen_region (peaq);
+  peaq_movaccum_set_log (peaq->mov_accum[MOVBASIC_TOTAL_NMR], NULL);
+  peaq_movaccum_set_log (peaq->mov_accum[MOVBASIC_MFPD], NULL);
+  for (i = 0; i < 2; i++) {
+    g_array_unref (peaq->screen_log[i]);
+    peaq->screen_log[i] = NULL;
+  }
+}
+
+/*
+ * screen_frame:
+ * @peaq: The #GstPeaq instance.
+ * @start: Position of the first sample of the frame.
+ * @end: Position after the last sample of the frame.
+ *
+ * Evaluates the contributions logged for the current frame, i.e. the maximum
+ * NMR over the channels in dB and the binaural probability of detection, and
+ * extends the open region of flagged frames or starts a new one if either
+ * exceeds its threshold. Regions are closed at the first frame not overlapping
+ * them.
+ */
+static void
+screen_frame (GstPeaq *peaq, guint64 start, guint64 end)
+{
+  guint i;
+  GArray *nmr_log = peaq->screen_log[0];
+  GArray *pd_log = peaq->screen_log[1];
+  gdouble nmr = -G_MAXDOUBLE;
+  gdouble pd = 0.;
+
+  for (i = 0; i + 2 < nmr_log->len; i += 3) {
+    gdouble nmr_c = 10. * log10 (g_array_index (nmr_log, gdouble, i + 1));
+    if (nmr_c > nmr)
+      nmr = nmr_c;
+  }
+  for (i = 0; i + 2 < pd_log->len; i += 3)
+    pd = g_array_index (pd_log, gdouble, i + 1);
+  g_array_set_size (nmr_log, 0);
+  g_array_set_size (pd_log, 0);
+
+  if (peaq->screen_region_end != G_MAXUINT64 &&
+      start >= peaq->screen_region_end)
+    close_screen_region (peaq);
+  if (nmr > peaq->screen_nmr_threshold || pd > peaq->screen_pd_threshold) {
+    if (peaq->screen_region_end == G_MAXUINT64) {
+      peaq->screen_region_start = start;
+      peaq->screen_max_nmr = nmr;
+      peaq->screen_max_pd = pd;
+    } else {
+      peaq->screen_max_nmr = MAX (peaq->screen_max_nmr, nmr);
+      peaq->screen_max_pd = MAX (peaq->screen_max_pd, pd);
+    }
+    peaq->screen_region_end = end;
+  }
+}
+
+/*
+ * post_screen_regions:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Posts the queued "peaq-flagged-region" structures as element messages. Must
+ * be called without holding the object lock.
+ */
+static void
+post_screen_regions (GstPeaq *peaq)
+{
+  GstStructure *region;
+  GST_OBJECT_LOCK (peaq);
+  while ((region = g_queue_pop_head (&peaq->screen_regions))) {
+    GST_OBJECT_UNLOCK (peaq);
+    gst_element_post_message (GST_ELEMENT (peaq),
+                              gst_message_new_element (GST_OBJECT (peaq),
+                                                       region));
+    GST_OBJECT_LOCK (peaq);
+  }
+  GST_OBJECT_UNLOCK (peaq);
+}
+
+static gchar *
+trace_column_name (enum _LatencyPath path, enum _TraceQuantity quantity,
+                   guint signal, guint channel)
+{
+  return g_strdup_printf ("%s.%s.%s.%u", latency_path_names[path],
+                          signal == 0 ? "ref" : "test",
+                          quantity == TRACE_FLAGS ? "energy-threshold" :
+                          trace_quantity_names[quantity], channel);
+}
+
+static void
+add_trace_column (GstPeaq *peaq, enum _LatencyPath path,
+                  enum _TraceQuantity quantity, guint signal, guint channel,
+                  guint index, gchar const *name, guint width)
+{
+  struct _TraceColumn column;
+  column.column = peaq_frametrace_add_column (peaq->frame_trace, path, name,
+                                              width);
+  column.quantity = quantity;
+  column.signal = signal;
+  column.channel = channel;
+  column.index = index;
+  g_array_append_val (peaq->trace_columns[path], column);
+}
+
+/*
+ * start_frame_trace:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Opens #GstPeaq:frame-trace-file and sets up one table for the FFT frames
+ * and, in advanced mode, one for the filter bank frames, with the columns
+ * for the quantities listed in #GstPeaq:frame-trace-quantities. Called on the
+ * first buffer, when the number of channels is known.
+ */
+static void
+start_frame_trace (GstPeaq *peaq)
+{
+  gboolean selected[COUNT_TRACE_QUANTITIES] = { FALSE };
+  gchar **names;
+  guint i, c, s;
+  enum _LatencyPath path;
+  guint path_count = peaq->advanced ? COUNT_LATENCY_PATHS : 1;
+  guint mov_count = peaq->advanced ? COUNT_MOV_ADVANCED : COUNT_MOV_BASIC;
+
+  peaq->frame_trace_pending = FALSE;
+  peaq->frame_trace = peaq_frametrace_new (peaq->frame_trace_file,
+                                           FRAME_TRACE_CHUNK_FRAMES,
+                                           FRAME_TRACE_MAX_CHUNKS);
+  if (!peaq->frame_trace) {
+    g_warning ("could not open frame trace file %s", peaq->frame_trace_file);
+    return;
+  }
+
+  names = g_strsplit (peaq->frame_trace_quantities ?
+                      peaq->frame_trace_quantities : "", ",", -1);
+  for (i = 0; names[i]; i++) {
+    enum _TraceQuantity q;
+    g_strstrip (names[i]);
+    for (q = 0; q < COUNT_TRACE_QUANTITIES; q++)
+      if (strcmp (names[i], trace_quantity_names[q]) == 0)
+        break;
+    if (q < COUNT_TRACE_QUANTITIES) {
+      selected[q] = TRUE;
+    } else if (strcmp (names[i], "replay") == 0) {
+      /* everything needed by replay_frame_trace() */
+      selected[TRACE_EXCITATION] = TRUE;
+      selected[TRACE_UNSMEARED_EXCITATION] = TRUE;
+      selected[TRACE_POWER_SPECTRUM] = TRUE;
+      selected[TRACE_WEIGHTED_POWER_SPECTRUM] = TRUE;
+      selected[TRACE_FLAGS] = TRUE;
+      selected[TRACE_ENERGY] = TRUE;
+    } else if (names[i][0] != '\0')
+      g_warning ("unknown frame trace quantity %s", names[i]);
+  }
+  g_strfreev (names);
+
+  for (path = 0; path < path_count; path++) {
+    PeaqEarModel *model =
+      path == LATENCY_FB ? peaq->fb_ear_model : peaq->fft_ear_model;
+    guint band_count = peaq_earmodel_get_band_count (model);
+    guint spectrum_size = peaq_earmodel_get_frame_size (model) / 2 + 1;
+    /* the modulation processors are fed from the filter bank in advanced
+     * mode and are not used at all when screening */
+    gboolean has_modulation = peaq->advanced ? path == LATENCY_FB :
+      !peaq->screen_log[0];
+    gchar const *table = latency_path_names[path];
+    g_array_set_size (peaq->trace_columns[path], 0);
+    peaq_frametrace_add_table (peaq->frame_trace, table,
+                               peaq_earmodel_get_step_size (model));
+    if (selected[TRACE_FLAGS]) {
+      gchar *name = g_strdup_printf ("%s.above-threshold", table);
+      add_trace_column (peaq, path, TRACE_FLAGS, 0, 0, 0, name, 1);
+      g_free (name);
+    }
+    /* the signal and noise energy (of the first half of each frame, as for
+     * the total SNR) are only computed from the FFT frames */
+    if (selected[TRACE_ENERGY] && path == LATENCY_FFT) {
+      gchar *name = g_strdup_printf ("%s.energy", table);
+      add_trace_column (peaq, path, TRACE_ENERGY, 0, 0, 0, name, 2);
+      g_free (name);
+    }
+    for (s = 0; s < 2; s++) {
+      for (c = 0; c < peaq->channels; c++) {
+        for (i = 0; i < COUNT_TRACE_QUANTITIES; i++) {
+          guint width;
+          gchar *name;
+          if (!selected[i])
+            continue;
+          switch (i) {
+            case TRACE_EXCITATION:
+            case TRACE_UNSMEARED_EXCITATION:
+              width = band_count;
+              break;
+            case TRACE_POWER_SPECTRUM:
+            case TRACE_WEIGHTED_POWER_SPECTRUM:
+              if (path != LATENCY_FFT)
+                continue;
+              width = spectrum_size;
+              break;
+            case TRACE_MODULATION:
+              if (!has_modulation)
+                continue;
+              width = band_count;
+              break;
+            case TRACE_FLAGS:
+              if (path != LATENCY_FFT)
+                continue;
+              width = 1;
+              break;
+            default:
+              continue;
+          }
+          name = trace_column_name (path, i, s, c);
+          add_trace_column (peaq, path, i, s, c, i == TRACE_FLAGS, name,
+                            width);
+          g_free (name);
+        }
+      }
+    }
+    if (selected[TRACE_MOVS]) {
+      for (i = 0; i < mov_count; i++) {
+        gchar *name;
+        if (!is_mov_on_path (peaq, i, path))
+          continue;
+        name = g_strdup_printf ("%s.mov.%s", table, peaq->advanced ?
+                                mov_names_advanced[i] : mov_names_basic[i]);
+        add_trace_column (peaq, path, TRACE_MOVS, 0, 0, i, name,
+                          peaq_movaccum_get_channels (peaq->mov_accum[i]));
+        g_free (name);
+        peaq_movaccum_clear_frame_values (peaq->mov_accum[i]);
+      }
+    }
+  }
+
+  if (!peaq_frametrace_start (peaq->frame_trace))
+    g_warning ("could not write frame trace file %s", peaq->frame_trace_file);
+}
+
+static void
+stop_frame_trace (GstPeaq *peaq)
+{
+  guint i;
+  peaq->frame_trace_pending = FALSE;
+  if (!peaq->frame_trace)
+    return;
+  if (!peaq_frametrace_free (peaq->frame_trace))
+    g_warning ("could not write frame trace file %s", peaq->frame_trace_file);
+  peaq->frame_trace = NULL;
+  for (i = 0; i < COUNT_LATENCY_PATHS; i++)
+    g_array_set_size (peaq->trace_columns[i], 0);
+}
+
+/*
+ * trace_frame:
+ * @peaq: The #GstPeaq instance.
+ * @path: The table to write to.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ * @energy: Signal and noise energy of the frame (FFT frames only).
+ *
+ * Writes the traced quantities of the frame just processed and resets the
+ * frame values of the traced accumulators. May block if the writer thread
+ * falls behind.
+ */
+static void
+trace_frame (GstPeaq *peaq, enum _LatencyPath path, gboolean above_thres,
+             gdouble const *energy)
+{
+  guint i, j;
+  PeaqEarModel *model =
+    path == LATENCY_FB ? peaq->fb_ear_model : peaq->fft_ear_model;
+  gpointer *states[2];
+  PeaqModulationProcessor **mod_procs[2] = {
+    peaq->ref_modulation_processor, peaq->test_modulation_processor
+  };
+  guint frame_size = peaq_earmodel_get_frame_size (model);
+  guint band_count = peaq_earmodel_get_band_count (model);
+  GArray *columns = peaq->trace_columns[path];
+  GstClockTime t = peaq_tracer_begin ();
+
+  if (path == LATENCY_FB) {
+    states[0] = peaq->ref_fb_ear_state;
+    states[1] = peaq->test_fb_ear_state;
+  } else {
+    states[0] = peaq->ref_fft_ear_state;
+    states[1] = peaq->test_fft_ear_state;
+  }
+
+  for (i = 0; i < columns->len; i++) {
+    struct _TraceColumn *column =
+      &g_array_index (columns, struct _TraceColumn, i);
+    gdouble *row = peaq_frametrace_get_row (peaq->frame_trace, column->column);
+    gpointer state = states[column->signal][column->channel];
+    gdouble const *values = NULL;
+    guint width = 0;
+    switch (column->quantity) {
+      case TRACE_EXCITATION:
+        values = peaq_earmodel_get_excitation (model, state);
+        width = band_count;
+        break;
+      case TRACE_UNSMEARED_EXCITATION:
+        values = peaq_earmodel_get_unsmeared_excitation (model, state);
+        width = band_count;
+        break;
+      case TRACE_POWER_SPECTRUM:
+        values = peaq_fftearmodel_get_power_spectrum (state);
+        width = frame_size / 2 + 1;
+        break;
+      case TRACE_WEIGHTED_POWER_SPECTRUM:
+        values = peaq_fftearmodel_get_weighted_power_spectrum (state);
+        width = frame_size / 2 + 1;
+        break;
+      case TRACE_MODULATION:
+        values = peaq_modulationprocessor_get_modulation
+          (mod_procs[column->signal][column->channel]);
+        width = band_count;
+        break;
+      case TRACE_MOVS:
+        {
+          PeaqMovAccum *acc = peaq->mov_accum[column->index];
+          for (j = 0; j < peaq_movaccum_get_channels (acc); j++)
+            row[j] = peaq_movaccum_get_frame_value (acc, j);
+          peaq_movaccum_clear_frame_values (acc);
+        }
+        break;
+      case TRACE_FLAGS:
+        if (column->index == 0)
+          row[0] = above_thres;
+        else
+          row[0] = peaq_fftearmodel_is_energy_threshold_reached (state);
+        break;
+      case TRACE_ENERGY:
+        row[0] = energy[0];
+        row[1] = energy[1];
+        break;
+      default:
+        break;
+    }
+    if (values)
+      memcpy (row, values, width * sizeof (gdouble));
+  }
+  peaq_frametrace_next_frame (peaq->frame_trace, path);
+  peaq_tracer_end ("frame-trace", t);
+}
+
+/*
+ * replay_table:
+ * @peaq: The #GstPeaq instance.
+ * @reader: The frame trace to replay.
+ * @path: The table to replay.
+ *
+ * Sets the ear model states from the excitation patterns, power spectra and
+ * energy threshold flags stored for each frame of the table and runs the
+ * remaining processing of process_fft_block_basic(),
+ * process_fft_block_advanced() or process_fb_block() on them.
+ *
+ * Returns: %TRUE on success, %FALSE if a needed column is missing or could
+ * not be read.
+ */
+static gboolean
+replay_table (GstPeaq *peaq, PeaqFrameTraceReader *reader,
+              enum _LatencyPath path)
+{
+  gboolean needed[COUNT_TRACE_QUANTITIES] = { FALSE };
+  guint channels = peaq->channels;
+  /* one column per signal, channel and quantity, followed by the
+   * above-threshold flag and the energy */
+  guint above_index = 2 * channels * COUNT_TRACE_QUANTITIES;
+  guint energy_index = above_index + 1;
+  guint column_count = above_index + 2;
+  gint *columns = g_new (gint, column_count);
+  gdouble **values = g_new0 (gdouble *, column_count);
+  guint *widths = g_new0 (guint, column_count);
+  PeaqEarModel *model =
+    path == LATENCY_FB ? peaq->fb_ear_model : peaq->fft_ear_model;
+  gpointer *states[2];
+  gchar const *table = latency_path_names[path];
+  guint64 frames, first, n, i;
+  guint s, c, q;
+  gboolean ok = TRUE;
+
+  if (path == LATENCY_FB) {
+    states[0] = peaq->ref_fb_ear_state;
+    states[1] = peaq->test_fb_ear_state;
+  } else {
+    states[0] = peaq->ref_fft_ear_state;
+    states[1] = peaq->test_fft_ear_state;
+  }
+  needed[TRACE_EXCITATION] = TRUE;
+  needed[TRACE_UNSMEARED_EXCITATION] = path == LATENCY_FB || !peaq->advanced;
+  needed[TRACE_POWER_SPECTRUM] = path == LATENCY_FFT && !peaq->advanced;
+  needed[TRACE_WEIGHTED_POWER_SPECTRUM] = path == LATENCY_FFT;
+  needed[TRACE_FLAGS] = path == LATENCY_FFT;
+
+  for (i = 0; i < column_count; i++) {
+    gchar *name;
+    columns[i] = -1;
+    if (i == above_index) {
+      name = g_strdup_printf ("%s.above-threshold", table);
+    } else if (i == energy_index) {
+      if (path != LATENCY_FFT)
+        continue;
+      name = g_strdup_printf ("%s.energy", table);
+    } else {
+      q = i % COUNT_TRACE_QUANTITIES;
+      c = i / COUNT_TRACE_QUANTITIES % channels;
+      s = i / COUNT_TRACE_QUANTITIES / channels;
+      if (!needed[q])
+        continue;
+      name = trace_column_name (path, q, s, c);
+    }
+    columns[i] = peaq_frametrace_reader_find_column (reader, name);
+    if (columns[i] < 0) {
+      g_warning ("frame trace file %s lacks column %s", peaq->replay_file,
+                 name);
+      ok = FALSE;
+    } else {
+      widths[i] = peaq_frametrace_reader_get_column_width (reader,
+                                                           columns[i]);
+      values[i] = g_new (gdouble, FRAME_TRACE_CHUNK_FRAMES * widths[i]);
+    }
+    g_free (name);
+  }
+
+  frames = ok ? peaq_frametrace_reader_get_frame_count
+    (reader, peaq_frametrace_reader_get_column_table (reader,
+                                                      columns[above_index]))
+    : 0;
+  for (first = 0; ok && first < frames; first += n) {
+    n = MIN (FRAME_TRACE_CHUNK_FRAMES, frames - first);
+    for (i = 0; ok && i < column_count; i++)
+      if (columns[i] >= 0)
+        ok = peaq_frametrace_reader_read (reader, columns[i], first, n,
+                                          values[i]);
+    for (i = 0; ok && i < n; i++) {
+      gboolean above_thres = values[above_index][i] != 0.;
+      for (s = 0; s < 2; s++) {
+        for (c = 0; c < channels; c++) {
+          gdouble const *frame[COUNT_TRACE_QUANTITIES];
+          for (q = 0; q < COUNT_TRACE_QUANTITIES; q++) {
+            guint k = (s * channels + c) * COUNT_TRACE_QUANTITIES + q;
+            frame[q] = values[k] ? values[k] + i * widths[k] : NULL;
+          }
+          peaq_earmodel_state_set_excitation (model, states[s][c],
+                                              frame[TRACE_EXCITATION],
+                                              frame[TRACE_UNSMEARED_EXCITATION]);
+          if (path == LATENCY_FFT)
+            peaq_fftearmodel_state_set_spectra
+              (states[s][c], frame[TRACE_POWER_SPECTRUM],
+               frame[TRACE_WEIGHTED_POWER_SPECTRUM],
+               frame[TRACE_FLAGS][0] != 0.);
+        }
+      }
+      if (path == LATENCY_FB)
+        calc_movs_fb (peaq, above_thres);
+      else if (peaq->advanced)
+        calc_movs_fft_advanced (peaq, above_thres);
+      else
+        calc_movs_fft_basic (peaq, above_thres);
+      finish_frame (peaq, path, above_thres, path == LATENCY_FFT ?
+                    values[energy_index] + 2 * i : NULL);
+    }
+  }
+  if (!ok && frames > 0)
+    g_warning ("could not read frame trace file %s", peaq->replay_file);
+
+  for (i = 0; i < column_count; i++)
+    g_free (values[i]);
+  g_free (values);
+  g_free (widths);
+  g_free (columns);
+  return ok;
+}
+
+/*
+ * replay_frame_trace:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Computes the MOVs from the intermediate quantities stored in
+ * #GstPeaq:replay-file instead of the input signals. The number of channels
+ * is derived from the stored excitation patterns; the mode has to match the
+ * one the trace was written with. Called on the transition to PAUSED, the
+ * results are published as for any other input on the transition back to
+ * READY.
+ */
+static void
+replay_frame_trace (GstPeaq *peaq)
+{
+  GError *error = NULL;
+  PeaqFrameTraceReader *reader;
+  enum _LatencyPath path;
+  gboolean has_fb = FALSE;
+  gint channels;
+  guint i;
+
+  reader = peaq_frametrace_reader_new (peaq->replay_file, &error);
+  if (!reader) {
+    g_warning ("could not open frame trace file %s: %s", peaq->replay_file,
+               error->message);
+    g_error_free (error);
+    return;
+  }
+
+  for (i = 0; i < peaq_frametrace_reader_get_table_count (reader); i++)
+    if (strcmp (peaq_frametrace_reader_get_table_name (reader, i),
+                latency_path_names[LATENCY_FB]) == 0)
+      has_fb = TRUE;
+  for (channels = 0; ; channels++) {
+    gchar *name = trace_column_name (LATENCY_FFT, TRACE_EXCITATION, 0,
+                                     channels);
+    gint column = peaq_frametrace_reader_find_column (reader, name);
+    g_free (name);
+    if (column < 0)
+      break;
+  }
+
+  if (has_fb != peaq->advanced) {
+    g_warning ("frame trace file %s was written in %s mode",
+               peaq->replay_file, has_fb ? "advanced" : "basic");
+  } else if (channels == 0) {
+    g_warning ("frame trace file %s lacks the excitation patterns",
+               peaq->replay_file);
+  } else {
+    GST_OBJECT_LOCK (peaq);
+    set_channels (peaq, channels);
+    for (path = 0; path < (peaq->advanced ? COUNT_LATENCY_PATHS : 1); path++)
+      if (!replay_table (peaq, reader, path))
+        break;
+    GST_OBJECT_UNLOCK (peaq);
+  }
+
+  peaq_frametrace_reader_free (reader);
+}
+
+/*
+ * reset_results:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Discards everything accumulated towards the result so far, so that a
+ * replayed frame trace is evaluated on its own even if the element has
+ * processed input or replayed a trace before. Called with the object lock
+ * held.
+ */
+static void
+reset_results (GstPeaq *peaq)
+{
+  guint i;
+
+  peaq->frame_counter = 0;
+  peaq->frame_counter_fb = 0;
+  peaq->loudness_reached_frame = G_MAXUINT;
+  peaq->total_signal_energy = 0.;
+  peaq->total_noise_energy = 0.;
+  for (i = 0; i < COUNT_MOV_BASIC; i++)
+    peaq_movaccum_reset (peaq->mov_accum[i]);
+  reset_mov_tracking (peaq, TRUE);
+}
+
+static void
+do_processing (GstPeaq *peaq, GstAdapter *ref_adapter, GstAdapter *test_adapter,
+               void (*process_block)(GstPeaq *, gfloat*, gfloat *),
+               guint frame_size_bytes, guint step_size_bytes,
+               guint max_frames, enum _LatencyPath path)
+{
+  /* a hop has to be processed within the time it corresponds to */
+  GstClockTime deadline = 0;
+  if (G_UNLIKELY (peaq->collect_stats))
+    deadline =
+      gst_util_uint64_scale (step_size_bytes / (peaq->channels * sizeof (gfloat)),
+                             GST_SECOND, 48000);
+  while (max_frames > 0 &&
+         gst_adapter_available (ref_adapter) >= frame_size_bytes &&
+         gst_adapter_available (test_adapter) >= frame_size_bytes)
+  {
+    GstClockTime start = stats_start (peaq);
+    GstClockTime map_start = peaq_tracer_begin ();
+    gfloat *refframe = (gfloat *) gst_adapter_map (ref_adapter, frame_size_bytes);
+    gfloat *testframe = (gfloat *) gst_adapter_map (test_adapter, frame_size_bytes);
+    peaq_tracer_end ("adapter-map", map_start);
+    process_block (peaq, refframe, testframe);
     gst_adapter_unmap (ref_adapter);
     gst_adapter_unmap (test_adapter);
     gst_adapter_flush (ref_adapter, step_size_bytes);
     gst_adapter_flush (test_adapter, step_size_bytes);
+    if (G_UNLIKELY (peaq->collect_stats))
+      latency_record (&peaq->latency[path], gst_util_get_timestamp () - start,
+                      deadline);
+    max_frames--;
+  }
+}
+
+/*
+ * process_frames:
+ * @peaq: The #GstPeaq instance.
+ * @position: Sample position at which to stop processing, i.e. only frames
+ * starting before it are processed, or G_MAXUINT64 to process all complete
+ * frames available.
+ *
+ * Returns: Whether all frames starting before @position have been processed.
+ */
+static gboolean
+process_frames (GstPeaq *peaq, guint64 position)
+{
+  guint bytes_per_sample = peaq->channels * sizeof (gfloat);
+  guint fft_frame_size = peaq_earmodel_get_frame_size (peaq->fft_ear_model);
+  guint fft_step_size = peaq_earmodel_get_step_size (peaq->fft_ear_model);
+  guint fb_frame_size = peaq_earmodel_get_frame_size (peaq->fb_ear_model);
+  guint max_frames = G_MAXUINT;
+  gboolean reached;
+
+  if (position != G_MAXUINT64)
+    max_frames = position / fft_step_size - peaq->frame_counter;
+  if (peaq->advanced) {
+    do_processing (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
+                   process_fft_block_advanced,
+                   fft_frame_size * bytes_per_sample,
+                   fft_step_size * bytes_per_sample, max_frames, LATENCY_FFT);
+    if (position != G_MAXUINT64)
+      max_frames = position / fb_frame_size - peaq->frame_counter_fb;
+    do_processing (peaq, peaq->ref_adapter_fb, peaq->test_adapter_fb,
+                   process_fb_block, fb_frame_size * bytes_per_sample,
+                   fb_frame_size * bytes_per_sample, max_frames, LATENCY_FB);
+  } else {
+    do_processing (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
+                   peaq->screen_log[0] ? process_fft_block_screening :
+                   process_fft_block_basic, fft_frame_size * bytes_per_sample,
+                   fft_step_size * bytes_per_sample, max_frames, LATENCY_FFT);
+  }
+
+  reached = (guint64) peaq->frame_counter * fft_step_size >= position;
+  if (peaq->advanced)
+    reached &= (guint64) peaq->frame_counter_fb * fb_frame_size >= position;
+  return reached;
+}
+
+/*
+ * ingest_buffer:
+ * @peaq: The #GstPeaq.
+ * @pad: The pad the buffer arrived at.
+ * @buffer: The buffer, whose reference is taken over.
+ *
+ * Pushes the buffer into the adapters of @pad, skipping the data not needed
+ * when resuming from a checkpoint or after splicing. Must be called with the
+ * object lock held.
+ */
+static void
+ingest_buffer (GstPeaq *peaq, GstPad *pad, GstBuffer *buffer)
+{
+  /* when resuming from a checkpoint or after splicing in the stored
+   * contributions, the corresponding input is not needed */
+  if (G_UNLIKELY (peaq->skip_bytes[pad == peaq->testpad] > 0 ||
+                  peaq->spliced)) {
+    guint64 *skip_bytes = &peaq->skip_bytes[pad == peaq->testpad];
+    gsize size = gst_buffer_get_size (buffer);
+    if (peaq->spliced || size <= *skip_bytes) {
+      *skip_bytes -= MIN (size, *skip_bytes);
+      gst_buffer_unref (buffer);
+      return;
+    } else {
+      GstBuffer *rest = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+                                                *skip_bytes,
+                                                size - *skip_bytes);
+      gst_buffer_unref (buffer);
+      buffer = rest;
+      *skip_bytes = 0;
+    }
+  }
+
+  if (pad == peaq->refpad) {
+    if (peaq->advanced)
+      gst_adapter_push (peaq->ref_adapter_fb, gst_buffer_copy (buffer));
+    gst_adapter_push (peaq->ref_adapter_fft, buffer);
+  } else {
+    if (peaq->advanced)
+      gst_adapter_push (peaq->test_adapter_fb, gst_buffer_copy (buffer));
+    gst_adapter_push (peaq->test_adapter_fft, buffer);
   }
 }
 
+/*
+ * chain:
+ * @pad: The pad the data arrived at.
+ * @parent: The #GstPeaq.
+ * @buffer: A single buffer, or %NULL if @list is given.
+ * @list: A list of buffers, or %NULL if @buffer is given.
+ *
+ * Common implementation of pad_chain() and pad_chain_list(): passes the data
+ * on (for #GstPeaqPass), takes the object lock once, pushes all buffers into
+ * the adapters and then processes all complete frames.
+ *
+ * Returns: The flow return of passing the data on, %GST_FLOW_OK otherwise.
+ */
 static GstFlowReturn
-pad_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer)
+chain (GstPad *pad, GstObject *parent, GstBuffer *buffer, GstBufferList *list)
 {
   GstElement *element = GST_ELEMENT (parent);
   GstPeaq *peaq = GST_PEAQ (element);
+  GstStructure *stats = NULL;
+  GstStructure *latency = NULL;
+  GstStructure *splice = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean regions;
+  guint i;
+
+  GstClockTime trace_start = peaq_tracer_begin ();
+
+  /* pass the data on first, so the analysis does not delay it; the buffers
+   * are shared with downstream by reference, the adapters only read them */
+  if (peaq->testsrcpad) {
+    GstPad *srcpad =
+      pad == peaq->testpad ? peaq->testsrcpad : peaq->refsrcpad;
+    if (buffer)
+      ret = gst_pad_push (srcpad, gst_buffer_ref (buffer));
+    else
+      ret = gst_pad_push_list (srcpad, gst_buffer_list_ref (list));
+    /* passing on the reference signal is optional */
+    if (ret == GST_FLOW_NOT_LINKED && srcpad == peaq->refsrcpad)
+      ret = GST_FLOW_OK;
+  }
 
   GST_OBJECT_LOCK (peaq);
 
+  /* everything not accounted to one of the processing stages is considered
+   * framing overhead */
+  GstClockTime chain_start = stats_start (peaq);
+  GstClockTime processing_time = 0;
+  guint frame_counter = peaq->frame_counter + peaq->frame_counter_fb;
+  if (G_UNLIKELY (peaq->collect_stats))
+    processing_time = stats_processing_time (peaq);
+
   if (element->pending_state != GST_STATE_VOID_PENDING) {
     element->current_state = element->pending_state;
     element->pending_state = GST_STATE_VOID_PENDING;
   }
 
-  if (pad == peaq->refpad) {
+  if (G_UNLIKELY (peaq->checkpoints_pending))
+    start_checkpoints (peaq);
+  if (G_UNLIKELY (peaq->frame_trace_pending))
+    start_frame_trace (peaq);
+  if (G_UNLIKELY (peaq->results_ring_pending))
+    start_results_ring (peaq);
+
+  if (pad == peaq->refpad)
     peaq->ref_eos = FALSE;
-    if (peaq->advanced)
-      gst_adapter_push (peaq->ref_adapter_fb, gst_buffer_copy (buffer));
-    gst_adapter_push (peaq->ref_adapter_fft, buffer);
-  } else if (pad == peaq->testpad) {
+  else
     peaq->test_eos = FALSE;
-    if (peaq->advanced)
-      gst_adapter_push (peaq->test_adapter_fb, gst_buffer_copy (buffer));
-    gst_adapter_push (peaq->test_adapter_fft, buffer);
+  if (buffer) {
+    if (peaq->recorder)
+      peaq_recorder_buffer (peaq->recorder, pad == peaq->testpad, buffer);
+    ingest_buffer (peaq, pad, buffer);
+  } else {
+    /* lists are recorded as such to be replayed with the same boundaries */
+    if (peaq->recorder)
+      peaq_recorder_list (peaq->recorder, pad == peaq->testpad, list);
+    for (i = 0; i < gst_buffer_list_length (list); i++)
+      ingest_buffer (peaq, pad,
+                     gst_buffer_ref (gst_buffer_list_get (list, i)));
+    gst_buffer_list_unref (list);
+  }
+
+  /* the adapters are fullest right before processing */
+  {
+    gsize adapters =
+      gst_adapter_available (peaq->ref_adapter_fft) +
+      gst_adapter_available (peaq->test_adapter_fft) +
+      gst_adapter_available (peaq->ref_adapter_fb) +
+      gst_adapter_available (peaq->test_adapter_fb);
+    if (adapters > peaq->memory_adapters_peak)
+      peaq->memory_adapters_peak = adapters;
+    if (peaq->memory_static + adapters > peaq->memory_peak)
+      peaq->memory_peak = peaq->memory_static + adapters;
   }
- 
-  guint frame_size_bytes =
-    peaq->channels * sizeof (gfloat) *
-    peaq_earmodel_get_frame_size (peaq->fft_ear_model);
-  guint step_size_bytes =
-    peaq->channels * sizeof (gfloat) *
-    peaq_earmodel_get_step_size (peaq->fft_ear_model);
 
-  if (peaq->advanced) {
-    do_processing (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
-                   process_fft_block_advanced, frame_size_bytes, step_size_bytes);
-    frame_size_bytes =
-      peaq->channels * sizeof (gfloat) *
-      peaq_earmodel_get_frame_size (peaq->fb_ear_model);
-    do_processing (peaq, peaq->ref_adapter_fb, peaq->test_adapter_fb,
-                   process_fb_block, frame_size_bytes, frame_size_bytes);
-  } else {
-    do_processing (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
-                   process_fft_block_basic, frame_size_bytes, step_size_bytes);
+  /* stop at every checkpoint position to store or compare the state */
+  while (!peaq->spliced &&
+         process_frames (peaq, peaq->next_checkpoint) &&
+         peaq->next_checkpoint != G_MAXUINT64) {
+    splice = checkpoint_reached (peaq);
+  }
+
+  if (peaq->frame_counter + peaq->frame_counter_fb != frame_counter || splice)
+    publish_results (peaq);
+
+  if (G_UNLIKELY (peaq->collect_stats)) {
+    processing_time = stats_processing_time (peaq) - processing_time;
+    stats_stop (peaq, STAGE_FRAMING, chain_start + processing_time, 1,
+                peaq->frame_counter + peaq->frame_counter_fb - frame_counter);
+    if (peaq->stats_interval > 0 &&
+        peaq->frame_counter - peaq->stats_posted_frame >= peaq->stats_interval) {
+      peaq->stats_posted_frame = peaq->frame_counter;
+      stats = get_stats (peaq);
+      latency = get_latency (peaq);
+    }
   }
 
+  regions = !g_queue_is_empty (&peaq->screen_regions);
+
   GST_OBJECT_UNLOCK (peaq);
 
-  return GST_FLOW_OK;
+  peaq_tracer_end ("pad-chain", trace_start);
+
+  if (stats)
+    gst_element_post_message (element,
+                              gst_message_new_element (GST_OBJECT (peaq),
+                                                       stats));
+  if (latency)
+    gst_element_post_message (element,
+                              gst_message_new_element (GST_OBJECT (peaq),
+                                                       latency));
+  if (splice)
+    gst_element_post_message (element,
+                              gst_message_new_element (GST_OBJECT (peaq),
+                                                       splice));
+  if (G_UNLIKELY (regions))
+    post_screen_regions (peaq);
+
+  return ret;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+  return chain (pad, parent, buffer, NULL);
+}
+
+/*
+ * pad_chain_list:
+ *
+ * Handles a whole list of buffers with a single acquisition of the object lock
+ * and a single pass over the complete frames, reducing the overhead for the
+ * many small buffers of live sources.
+ */
+static GstFlowReturn
+pad_chain_list (GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+  return chain (pad, parent, NULL, list);
 }
 
 static gboolean
 pad_event (GstPad *pad, GstObject *parent, GstEvent* event)
 {
   gboolean ret = FALSE;
+  GstPeaq *peaq = GST_PEAQ (parent);
+
+  GST_OBJECT_LOCK (peaq);
+  if (peaq->recorder) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      GstCaps *caps;
+      gst_event_parse_caps (event, &caps);
+      peaq_recorder_caps (peaq->recorder, pad == peaq->testpad, caps);
+    } else {
+      peaq_recorder_event (peaq->recorder, pad == peaq->testpad, event);
+    }
+  }
+  GST_OBJECT_UNLOCK (peaq);
+
   switch (event->type) {
     case GST_EVENT_EOS:
       {
         GstElement *element = GST_ELEMENT (parent);
-        GstPeaq *peaq = GST_PEAQ (element);
 
         if (pad == peaq->refpad) {
           peaq->ref_eos = TRUE;
@@ -676,6 +3175,13 @@ pad_event (GstPad *pad, GstObject *parent, GstEvent* event)
           peaq->test_eos = TRUE;
         }
 
+        if (peaq->testsrcpad) {
+          /* downstream posts the end-of-stream message */
+          gst_pad_event_default (pad, parent, event);
+          ret = TRUE;
+          break;
+        }
+
         if (peaq->ref_eos && peaq->test_eos) {
           GstMessage *msg = gst_message_new_eos (parent);
           guint32 seqnum = gst_event_get_seqnum (event);
@@ -691,7 +3197,6 @@ pad_event (GstPad *pad, GstObject *parent, GstEvent* event)
         GstCaps *caps;
         gst_event_parse_caps (event, &caps);
         GstPad *other_pad;
-        GstPeaq *peaq = GST_PEAQ (parent);
         if (pad == peaq->refpad) {
           other_pad = peaq->testpad;
         } else {
@@ -703,6 +3208,12 @@ pad_event (GstPad *pad, GstObject *parent, GstEvent* event)
         } else {
           ret = FALSE;
         }
+        if (ret && peaq->testsrcpad) {
+          /* an unlinked ref_src pad does not refuse the caps */
+          ret = gst_pad_event_default (pad, parent, event) ||
+            pad == peaq->refpad;
+          break;
+        }
         gst_event_unref (event);
         break;
       }
@@ -748,6 +3259,7 @@ static GstStateChangeReturn
 change_state (GstElement * element, GstStateChange transition)
 {
   GstPeaq *peaq;
+  gboolean checkpoints_ignored;
 
   GstElementClass *parent_class = 
     GST_ELEMENT_CLASS (g_type_class_peek_parent (g_type_class_peek
@@ -758,11 +3270,56 @@ change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (peaq->trace_file && !peaq->tracing) {
+        peaq_tracer_start (peaq->trace_file);
+        peaq->tracing = TRUE;
+      }
+      if (peaq->record_file && !peaq->recorder) {
+        PeaqRecorder *recorder =
+          peaq_recorder_new (peaq->record_file, peaq->record_data);
+        if (!recorder)
+          g_warning ("could not open record file %s", peaq->record_file);
+        GST_OBJECT_LOCK (peaq);
+        peaq->recorder = recorder;
+        GST_OBJECT_UNLOCK (peaq);
+      }
+      GST_OBJECT_LOCK (peaq);
+      start_screening (peaq);
+      /* both checkpoints and screening use the accumulator logs */
+      checkpoints_ignored = peaq->screen_log[0] != NULL &&
+        (peaq->checkpoint_file != NULL || peaq->resume_file != NULL);
+      peaq->checkpoints_pending = !peaq->screen_log[0] &&
+        (peaq->checkpoint_file != NULL || peaq->resume_file != NULL);
+      peaq->frame_trace_pending = peaq->frame_trace_file != NULL;
+      peaq->results_ring_pending = peaq->results_ring_name != NULL;
+      peaq->skip_bytes[0] = 0;
+      peaq->skip_bytes[1] = 0;
+      peaq->spliced = FALSE;
+      GST_OBJECT_UNLOCK (peaq);
+      reset_stats (peaq);
+      GST_OBJECT_LOCK (peaq);
+      peaq->memory_peak = 0;
+      peaq->memory_adapters_peak = 0;
+      update_memory_peak (peaq);
+      GST_OBJECT_UNLOCK (peaq);
+      if (checkpoints_ignored)
+        GST_ELEMENT_WARNING (peaq, RESOURCE, SETTINGS,
+                             ("Checkpoints are not supported in screening "
+                              "mode, ignoring checkpoint-file and "
+                              "resume-file."), (NULL));
+      if (peaq->replay_file) {
+        GST_OBJECT_LOCK (peaq);
+        reset_results (peaq);
+        GST_OBJECT_UNLOCK (peaq);
+        replay_frame_trace (peaq);
+      }
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
-      if (peaq->advanced) {
+      if (peaq->spliced) {
+        /* the stored contributions include the final flush */
+      } else if (peaq->advanced) {
         do_flush (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
                   process_fft_block_advanced, 
                   peaq_earmodel_get_frame_size (peaq->fft_ear_model));
@@ -771,12 +3328,37 @@ change_state (GstElement * element, GstStateChange transition)
                   peaq_earmodel_get_frame_size (peaq->fb_ear_model));
       } else {
         do_flush (peaq, peaq->ref_adapter_fft, peaq->test_adapter_fft,
+                  peaq->screen_log[0] ? process_fft_block_screening :
                   process_fft_block_basic, 
                   peaq_earmodel_get_frame_size (peaq->fft_ear_model));
       }
 
+      GST_OBJECT_LOCK (peaq);
+      stop_screening (peaq);
+      stop_frame_trace (peaq);
+      stop_results_ring (peaq);
+      GST_OBJECT_UNLOCK (peaq);
+      post_screen_regions (peaq);
+
+      GST_OBJECT_LOCK (peaq);
+      if (peaq->checkpoints)
+        stop_checkpoints (peaq);
+      peaq->checkpoints_pending = FALSE;
+      publish_results (peaq);
+      GST_OBJECT_UNLOCK (peaq);
+
       calculate_odg (peaq);
 
+      if (peaq->tracing) {
+        peaq_tracer_stop ();
+        peaq->tracing = FALSE;
+      }
+      GST_OBJECT_LOCK (peaq);
+      if (peaq->recorder) {
+        peaq_recorder_free (peaq->recorder);
+        peaq->recorder = NULL;
+      }
+      GST_OBJECT_UNLOCK (peaq);
       break;
     default:
       break;
@@ -807,20 +3389,32 @@ apply_ear_model (PeaqEarModel *model, guint channels, gfloat *data,
     } else {
       data_c = data;
     }
+    GstClockTime t = peaq_tracer_begin ();
     peaq_earmodel_process_block (model, state[c], data_c);
+    peaq_tracer_end ("earmodel-process-block", t);
   }
 }
 
 static void
-apply_ear_model_and_preprocess (GstPeaq *peaq, PeaqEarModel *model,
-                                gfloat *refdata, gfloat *testdata,
-                                gpointer *refstate, gpointer *teststate,
-                                guint frame_counter)
+apply_ear_models (GstPeaq *peaq, PeaqEarModel *model, gfloat *refdata,
+                  gfloat *testdata, gpointer *refstate, gpointer *teststate)
 {
-  guint c;
   gint channels = peaq->channels;
+  GstClockTime t = stats_start (peaq);
   apply_ear_model (model, channels, refdata, refstate);
   apply_ear_model (model, channels, testdata, teststate);
+  stats_stop (peaq, model == peaq->fb_ear_model ?
+              STAGE_FB_EAR_MODEL : STAGE_FFT_EAR_MODEL,
+              t, 2 * channels, 1);
+}
+
+static void
+preprocess (GstPeaq *peaq, PeaqEarModel *model, gpointer *refstate,
+            gpointer *teststate, guint frame_counter)
+{
+  guint c;
+  gint channels = peaq->channels;
+  GstClockTime t = stats_start (peaq);
   for (c = 0; c < channels; c++) {
     gdouble const *ref_excitation =
       peaq_earmodel_get_excitation (model, refstate[c]);
@@ -844,28 +3438,340 @@ apply_ear_model_and_preprocess (GstPeaq *peaq, PeaqEarModel *model,
         peaq->loudness_reached_frame = frame_counter;
     }
   }
+  stats_stop (peaq, STAGE_PREPROCESSING, t, channels, 1);
 }
 
+/*
+ * calc_frame_energy:
+ * @refdata: Reference frame.
+ * @testdata: Test frame.
+ * @samples: Number of (interleaved) samples to include.
+ * @energy: Array of two values to store the signal and noise energy in.
+ *
+ * Computes the contribution of one frame to #GstPeaq:totalsnr. Only the first
+ * half of each FFT frame is included, so that every sample is counted once.
+ */
 static void
-process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+calc_frame_energy (gfloat *refdata, gfloat *testdata, guint samples,
+                   gdouble *energy)
 {
   guint i;
-  gint channels = peaq->channels;
+  energy[0] = 0.;
+  energy[1] = 0.;
+  for (i = 0; i < samples; i++) {
+    energy[0] += refdata[i] * refdata[i];
+    energy[1] += (refdata[i] - testdata[i]) * (refdata[i] - testdata[i]);
+  }
+}
 
-  PeaqEarModel *ear_params = peaq->fft_ear_model;
-  guint frame_size = peaq_earmodel_get_frame_size (ear_params);
+/*
+ * finish_frame:
+ * @peaq: The #GstPeaq instance.
+ * @path: Whether an FFT or a filter bank frame was processed.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ * @energy: Signal and noise energy of the frame as computed by
+ * calc_frame_energy(), only used for FFT frames.
+ *
+ * Writes the frame to the frame trace and the results ring if enabled, adds
+ * the energy to the totals and advances the frame counter.
+ */
+static void
+finish_frame (GstPeaq *peaq, enum _LatencyPath path, gboolean above_thres,
+              gdouble const *energy)
+{
+  if (peaq->results_ring)
+    publish_ring_entry (peaq, path);
+  if (peaq->frame_trace)
+    trace_frame (peaq, path, above_thres, energy);
+  if (peaq->results_ring) {
+    guint i;
+    for (i = 0; i < COUNT_MOV_BASIC; i++)
+      if (peaq->window_accum[i] && is_mov_on_path (peaq, i, path))
+        peaq_movaccum_clear_frame_values (peaq->mov_accum[i]);
+  }
 
-  gboolean above_thres =
-    is_frame_above_threshold (refdata, frame_size, channels);
+  if (path == LATENCY_FB) {
+    peaq->frame_counter_fb++;
+  } else {
+    if (is_frame_scored (peaq, path)) {
+      peaq->total_signal_energy += energy[0];
+      peaq->total_noise_energy += energy[1];
+    }
+    peaq->frame_counter++;
+    if (peaq->results_ring)
+      advance_window (peaq);
+  }
+}
 
-  for (i = 0; i < COUNT_MOV_BASIC; i++)
-    peaq_movaccum_set_tentative (peaq->mov_accum[i], !above_thres);
+/*
+ * is_mov_on_path:
+ * @peaq: The #GstPeaq instance.
+ * @mov: Index of the MOV.
+ * @path: The latency path.
+ *
+ * In advanced mode, the segmental NMR and the EHS are computed from the FFT
+ * frames, the other MOVs from the filter bank frames; in basic mode, all MOVs
+ * are computed from the FFT frames.
+ *
+ * Returns: Whether the MOV is computed from the frames of the given path.
+ */
+static gboolean
+is_mov_on_path (GstPeaq *peaq, guint mov, enum _LatencyPath path)
+{
+  if (!peaq->advanced)
+    return path == LATENCY_FFT;
+  return (path == LATENCY_FFT) ==
+    (mov == MOVADV_SEGMENTAL_NMR || mov == MOVADV_EHS);
+}
+
+/*
+ * is_frame_scored:
+ * @peaq: The #GstPeaq instance.
+ * @path: The latency path of the current frame.
+ *
+ * Returns: Whether the current frame of @path starts at or after
+ * #GstPeaq:score-start and hence contributes to the results.
+ */
+static gboolean
+is_frame_scored (GstPeaq *peaq, enum _LatencyPath path)
+{
+  if (G_LIKELY (peaq->score_start == 0))
+    return TRUE;
+  if (path == LATENCY_FB)
+    return (guint64) peaq->frame_counter_fb *
+      peaq_earmodel_get_step_size (peaq->fb_ear_model) >= peaq->score_start;
+  return (guint64) peaq->frame_counter *
+    peaq_earmodel_get_step_size (peaq->fft_ear_model) >= peaq->score_start;
+}
+
+/*
+ * reset_mov_tracking:
+ * @peaq: The #GstPeaq instance.
+ * @onset: Whether to forget the validity onsets, too.
+ *
+ * Forgets the tentative states last set by begin_mov_frame(), e.g. because
+ * the accumulators have been restored.
+ */
+static void
+reset_mov_tracking (GstPeaq *peaq, gboolean onset)
+{
+  guint i;
+  for (i = 0; i < COUNT_LATENCY_PATHS; i++) {
+    peaq->mov_tentative[i] = -1;
+    if (onset)
+      peaq->mov_onset[i] = G_MAXUINT64;
+  }
+}
+
+/*
+ * begin_mov_frame:
+ * @peaq: The #GstPeaq instance.
+ * @path: The latency path of the frame.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ *
+ * Sets the accumulators of the MOVs computed on @path to be tentative if the
+ * frame is below the energy threshold, unless they already are in the state
+ * set for the previous frame.
+ *
+ * Before the first frame above the threshold, the accumulators discard all
+ * contributions, so with #GstPeaq:skip-warm-up the MOV calculation is skipped
+ * for these frames without changing the results. While checkpoints are being
+ * recorded, the contributions are computed nevertheless, as the log may be
+ * replayed on accumulators which have already started. Frames before
+ * #GstPeaq:score-start are always skipped, leaving the accumulators as they
+ * are.
+ *
+ * Returns: %FALSE if the MOV calculation is to be skipped for the frame.
+ */
+static gboolean
+begin_mov_frame (GstPeaq *peaq, enum _LatencyPath path, gboolean above_thres)
+{
+  guint mov_count = peaq->advanced ? COUNT_MOV_ADVANCED : COUNT_MOV_BASIC;
+  gint tentative = !above_thres;
+  guint i;
+
+  if (G_UNLIKELY (!is_frame_scored (peaq, path)))
+    return FALSE;
+
+  if (G_UNLIKELY (peaq->mov_onset[path] == G_MAXUINT64)) {
+    for (i = 0; !is_mov_on_path (peaq, i, path); i++);
+    if (!above_thres && peaq->skip_warm_up &&
+        !(peaq->checkpoints && !peaq->resuming) &&
+        !peaq_movaccum_is_started (peaq->mov_accum[i]))
+      return FALSE;
+    peaq->mov_onset[path] =
+      path == LATENCY_FB ? peaq->frame_counter_fb : peaq->frame_counter;
+  }
+
+  if (tentative != peaq->mov_tentative[path]) {
+    for (i = 0; i < mov_count; i++)
+      if (is_mov_on_path (peaq, i, path))
+        peaq_movaccum_set_tentative (peaq->mov_accum[i], tentative);
+    peaq->mov_tentative[path] = tentative;
+  }
+  return TRUE;
+}
+
+/*
+ * start_results_ring:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Creates the shared-memory ring named by #GstPeaq:results-ring with one
+ * value per MOV and channel after the distortion index, the objective
+ * difference grade and the windowed objective difference grade, and sets up
+ * the window accumulators mirroring the MOV accumulators. Called on the first
+ * buffer, when the number of channels is known.
+ */
+static void
+start_results_ring (GstPeaq *peaq)
+{
+  guint mov_count = peaq->advanced ? COUNT_MOV_ADVANCED : COUNT_MOV_BASIC;
+  GPtrArray *names = g_ptr_array_new_with_free_func (g_free);
+  guint i, c;
+
+  peaq->results_ring_pending = FALSE;
+  g_ptr_array_add (names, g_strdup ("di"));
+  g_ptr_array_add (names, g_strdup ("odg"));
+  g_ptr_array_add (names, g_strdup ("window-odg"));
+  for (i = 0; i < mov_count; i++) {
+    guint channels = peaq_movaccum_get_channels (peaq->mov_accum[i]);
+    peaq->ring_offsets[i] = names->len;
+    for (c = 0; c < channels; c++)
+      g_ptr_array_add (names,
+                       g_strdup_printf ("mov.%s.%u", peaq->advanced ?
+                                        mov_names_advanced[i] :
+                                        mov_names_basic[i], c));
+  }
+
+  peaq->results_ring =
+    peaq_resultsring_new (peaq->results_ring_name, peaq->results_ring_slots,
+                          (gchar const *const *) names->pdata, names->len);
+  if (!peaq->results_ring) {
+    g_warning ("could not create results ring %s", peaq->results_ring_name);
+    g_ptr_array_free (names, TRUE);
+    return;
+  }
+  peaq->ring_values = g_new (gdouble, names->len);
+  g_ptr_array_free (names, TRUE);
+
+  for (i = 0; i < mov_count; i++) {
+    peaq->window_accum[i] = peaq_movaccum_new ();
+    peaq_movaccum_set_mode (peaq->window_accum[i],
+                            peaq_movaccum_get_mode (peaq->mov_accum[i]));
+    peaq_movaccum_set_channels (peaq->window_accum[i],
+                                peaq_movaccum_get_channels (peaq->mov_accum[i]));
+    peaq_movaccum_set_mirror (peaq->mov_accum[i], peaq->window_accum[i]);
+    peaq_movaccum_clear_frame_values (peaq->mov_accum[i]);
+  }
+  peaq->window_length =
+    MAX (1, (guint64) (peaq->results_ring_window * 48000 /
+                       peaq_earmodel_get_step_size (peaq->fft_ear_model)
+                       + 0.5));
+  peaq->window_frames = 0;
+  peaq->window_odg = NAN;
+}
+
+static void
+stop_results_ring (GstPeaq *peaq)
+{
+  guint i;
+  peaq->results_ring_pending = FALSE;
+  if (!peaq->results_ring)
+    return;
+  peaq_resultsring_free (peaq->results_ring);
+  peaq->results_ring = NULL;
+  g_free (peaq->ring_values);
+  peaq->ring_values = NULL;
+  for (i = 0; i < COUNT_MOV_BASIC; i++) {
+    if (!peaq->window_accum[i])
+      continue;
+    peaq_movaccum_set_mirror (peaq->mov_accum[i], NULL);
+    g_object_unref (peaq->window_accum[i]);
+    peaq->window_accum[i] = NULL;
+  }
+}
+
+/*
+ * publish_ring_entry:
+ * @peaq: The #GstPeaq instance.
+ * @path: The latency path of the frame just processed.
+ *
+ * Publishes the running distortion index and objective difference grade, the
+ * objective difference grade of the last completed window and the frame
+ * values of the MOVs computed on @path. Never blocks.
+ */
+static void
+publish_ring_entry (GstPeaq *peaq, enum _LatencyPath path)
+{
+  guint mov_count = peaq->advanced ? COUNT_MOV_ADVANCED : COUNT_MOV_BASIC;
+  gdouble *values = peaq->ring_values;
+  guint i, c;
+
+  values[0] = calculate_di_from (peaq, peaq->mov_accum);
+  values[1] = peaq_calculate_odg (values[0]);
+  values[2] = peaq->window_odg;
+  for (i = 0; i < mov_count; i++) {
+    PeaqMovAccum *acc = peaq->mov_accum[i];
+    gboolean on_path = is_mov_on_path (peaq, i, path);
+    for (c = 0; c < peaq_movaccum_get_channels (acc); c++)
+      values[peaq->ring_offsets[i] + c] =
+        on_path ? peaq_movaccum_get_frame_value (acc, c) : NAN;
+  }
+  peaq_resultsring_publish (peaq->results_ring, path,
+                            path == LATENCY_FB ? peaq->frame_counter_fb :
+                            peaq->frame_counter, values);
+}
+
+/*
+ * advance_window:
+ * @peaq: The #GstPeaq instance.
+ *
+ * Counts an FFT frame and, at the end of a window, computes its objective
+ * difference grade from the window accumulators and resets them. As the
+ * filter bank frames are not aligned with the FFT frames, the advanced
+ * version windows contain the filter bank frames processed until the end of
+ * the last FFT frame of the window.
+ */
+static void
+advance_window (GstPeaq *peaq)
+{
+  guint mov_count = peaq->advanced ? COUNT_MOV_ADVANCED : COUNT_MOV_BASIC;
+  guint i;
+
+  if (++peaq->window_frames < peaq->window_length)
+    return;
+  peaq->window_frames = 0;
+  peaq->window_odg =
+    peaq_calculate_odg (calculate_di_from (peaq, peaq->window_accum));
+  for (i = 0; i < mov_count; i++) {
+    guint channels = peaq_movaccum_get_channels (peaq->window_accum[i]);
+    /* reallocating clears the accumulated values */
+    peaq_movaccum_set_channels (peaq->window_accum[i], 0);
+    peaq_movaccum_set_channels (peaq->window_accum[i], channels);
+  }
+}
+
+/*
+ * calc_movs_fft_basic:
+ * @peaq: The #GstPeaq instance.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ *
+ * Performs the pre-processing and computes all MOVs of the basic version from
+ * the current FFT ear model states, i.e. everything following the ear model
+ * in process_fft_block_basic(). Also used by replay_frame_trace().
+ */
+static void
+calc_movs_fft_basic (GstPeaq *peaq, gboolean above_thres)
+{
+  gboolean valid = begin_mov_frame (peaq, LATENCY_FFT, above_thres);
+
+  preprocess (peaq, peaq->fft_ear_model, peaq->ref_fft_ear_state,
+              peaq->test_fft_ear_state, peaq->frame_counter);
 
-  apply_ear_model_and_preprocess (peaq, peaq->fft_ear_model,
-                                  refdata, testdata,
-                                  peaq->ref_fft_ear_state,
-                                  peaq->test_fft_ear_state,
-                                  peaq->frame_counter);
+  if (!valid)
+    return;
+
+  GstClockTime t = stats_start (peaq);
 
   /* modulation difference */
   if (peaq->frame_counter >= 24) {
@@ -874,6 +3780,7 @@ process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                                     peaq->mov_accum[MOVBASIC_AVG_MOD_DIFF_1],
                                     peaq->mov_accum[MOVBASIC_AVG_MOD_DIFF_2],
                                     peaq->mov_accum[MOVBASIC_WIN_MOD_DIFF]);
+    t = stats_stop (peaq, STAGE_MOV_MODULATION_DIFFERENCE, t, 1, 1);
   }
 
   /* noise loudness */
@@ -883,6 +3790,7 @@ process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                              peaq->test_modulation_processor,
                              peaq->level_adapter,
                              peaq->mov_accum[MOVBASIC_RMS_NOISE_LOUD]);
+    t = stats_stop (peaq, STAGE_MOV_NOISE_LOUDNESS, t, 1, 1);
   }
 
   /* bandwidth */
@@ -890,6 +3798,7 @@ process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                       peaq->test_fft_ear_state, 
                       peaq->mov_accum[MOVBASIC_BANDWIDTH_REF],
                       peaq->mov_accum[MOVBASIC_BANDWIDTH_TEST]);
+  t = stats_stop (peaq, STAGE_MOV_BANDWIDTH, t, 1, 1);
 
   /* noise-to-mask ratio */
   peaq_mov_nmr (PEAQ_FFTEARMODEL (peaq->fft_ear_model),
@@ -897,6 +3806,7 @@ process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                 peaq->test_fft_ear_state,
                 peaq->mov_accum[MOVBASIC_TOTAL_NMR],
                 peaq->mov_accum[MOVBASIC_REL_DIST_FRAMES]);
+  t = stats_stop (peaq, STAGE_MOV_NMR, t, 1, 1);
 
   /* probability of detection */
   peaq_mov_prob_detect(peaq->fft_ear_model,
@@ -905,41 +3815,29 @@ process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                        peaq->channels,
                        peaq->mov_accum[MOVBASIC_ADB],
                        peaq->mov_accum[MOVBASIC_MFPD]);
+  t = stats_stop (peaq, STAGE_MOV_PROB_DETECT, t, 1, 1);
 
   /* error harmonic structure */
   peaq_mov_ehs (peaq->fft_ear_model, peaq->ref_fft_ear_state,
                 peaq->test_fft_ear_state, peaq->mov_accum[MOVBASIC_EHS]);
-
-  for (i = 0; i < channels * frame_size / 2; i++) {
-    peaq->total_signal_energy
-      += refdata[i] * refdata[i];
-    peaq->total_noise_energy 
-      += (refdata[i] - testdata[i]) * (refdata[i] - testdata[i]);
-  }
-
-  peaq->frame_counter++;
+  stats_stop (peaq, STAGE_MOV_EHS, t, 1, 1);
 }
 
+/*
+ * calc_movs_fft_advanced:
+ * @peaq: The #GstPeaq instance.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ *
+ * Computes the MOVs of the advanced version based on the FFT ear model from
+ * its current states.
+ */
 static void
-process_fft_block_advanced (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+calc_movs_fft_advanced (GstPeaq *peaq, gboolean above_thres)
 {
-  guint i;
-  gint channels = peaq->channels;
-
-  PeaqEarModel *ear_params = peaq->fft_ear_model;
-  guint frame_size = peaq_earmodel_get_frame_size (ear_params);
+  if (!begin_mov_frame (peaq, LATENCY_FFT, above_thres))
+    return;
 
-  gboolean above_thres =
-    is_frame_above_threshold (refdata, frame_size, channels);
-
-  peaq_movaccum_set_tentative (peaq->mov_accum[MOVADV_SEGMENTAL_NMR],
-                               !above_thres);
-  peaq_movaccum_set_tentative (peaq->mov_accum[MOVADV_EHS], !above_thres);
-
-  apply_ear_model (peaq->fft_ear_model, channels, refdata,
-                   peaq->ref_fft_ear_state);
-  apply_ear_model (peaq->fft_ear_model, channels, testdata,
-                   peaq->test_fft_ear_state);
+  GstClockTime t = stats_start (peaq);
 
   /* noise-to-mask ratio */
   peaq_mov_nmr (PEAQ_FFTEARMODEL (peaq->fft_ear_model),
@@ -947,42 +3845,34 @@ process_fft_block_advanced (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                 peaq->test_fft_ear_state,
                 peaq->mov_accum[MOVADV_SEGMENTAL_NMR],
                 NULL);
+  t = stats_stop (peaq, STAGE_MOV_NMR, t, 1, 1);
 
   /* error harmonic structure */
   peaq_mov_ehs (peaq->fft_ear_model, peaq->ref_fft_ear_state,
                 peaq->test_fft_ear_state, peaq->mov_accum[MOVADV_EHS]);
-
-  for (i = 0; i < channels * frame_size / 2; i++) {
-    peaq->total_signal_energy += refdata[i] * refdata[i];
-    peaq->total_noise_energy 
-      += (refdata[i] - testdata[i]) * (refdata[i] - testdata[i]);
-  }
-
-  peaq->frame_counter++;
+  stats_stop (peaq, STAGE_MOV_EHS, t, 1, 1);
 }
 
+/*
+ * calc_movs_fb:
+ * @peaq: The #GstPeaq instance.
+ * @above_thres: Whether the reference frame exceeds the energy threshold.
+ *
+ * Performs the pre-processing and computes the MOVs of the advanced version
+ * based on the filter bank ear model from its current states.
+ */
 static void
-process_fb_block (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+calc_movs_fb (GstPeaq *peaq, gboolean above_thres)
 {
-  gint channels = peaq->channels;
-  PeaqEarModel *ear_params = peaq->fb_ear_model;
-  guint frame_size = peaq_earmodel_get_frame_size (ear_params);
+  gboolean valid = begin_mov_frame (peaq, LATENCY_FB, above_thres);
 
-  gboolean above_thres =
-    is_frame_above_threshold (refdata, frame_size, channels);
+  preprocess (peaq, peaq->fb_ear_model, peaq->ref_fb_ear_state,
+              peaq->test_fb_ear_state, peaq->frame_counter_fb);
 
-  peaq_movaccum_set_tentative (peaq->mov_accum[MOVADV_RMS_MOD_DIFF],
-                               !above_thres);
-  peaq_movaccum_set_tentative (peaq->mov_accum[MOVADV_RMS_NOISE_LOUD_ASYM],
-                               !above_thres);
-  peaq_movaccum_set_tentative (peaq->mov_accum[MOVADV_AVG_LIN_DIST],
-                               !above_thres);
+  if (!valid)
+    return;
 
-  apply_ear_model_and_preprocess (peaq, peaq->fb_ear_model,
-                                  refdata, testdata,
-                                  peaq->ref_fb_ear_state,
-                                  peaq->test_fb_ear_state,
-                                  peaq->frame_counter_fb);
+  GstClockTime t = stats_start (peaq);
 
   /* modulation difference */
   if (peaq->frame_counter_fb >= 125) {
@@ -990,6 +3880,7 @@ process_fb_block (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                                     peaq->test_modulation_processor,
                                     peaq->mov_accum[MOVADV_RMS_MOD_DIFF],
                                     NULL, NULL);
+    t = stats_stop (peaq, STAGE_MOV_MODULATION_DIFFERENCE, t, 1, 1);
   }
 
   /* noise loudness */
@@ -1004,9 +3895,210 @@ process_fb_block (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
                        peaq->level_adapter,
                        peaq->ref_fb_ear_state,
                        peaq->mov_accum[MOVADV_AVG_LIN_DIST]);
+    stats_stop (peaq, STAGE_MOV_NOISE_LOUDNESS, t, 2, 1);
+  }
+}
+
+static void
+process_fft_block_basic (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+{
+  gdouble energy[2];
+  gint channels = peaq->channels;
+  guint frame_size = peaq_earmodel_get_frame_size (peaq->fft_ear_model);
+
+  gboolean above_thres =
+    is_frame_above_threshold (refdata, frame_size, channels);
+
+  apply_ear_models (peaq, peaq->fft_ear_model, refdata, testdata,
+                    peaq->ref_fft_ear_state, peaq->test_fft_ear_state);
+  calc_movs_fft_basic (peaq, above_thres);
+
+  calc_frame_energy (refdata, testdata, channels * frame_size / 2, energy);
+  finish_frame (peaq, LATENCY_FFT, above_thres, energy);
+}
+
+/*
+ * process_fft_block_screening:
+ * @peaq: The #GstPeaq instance.
+ * @refdata: Reference frame.
+ * @testdata: Test frame.
+ *
+ * Cheap variant of process_fft_block_basic() for #GstPeaq:screening, which
+ * only applies the ear model (without pre-processing) and computes the
+ * NMR and detection probability based MOVs needed to flag the frame.
+ */
+static void
+process_fft_block_screening (GstPeaq *peaq, gfloat *refdata,
+                             gfloat *testdata)
+{
+  gdouble energy[2];
+  gint channels = peaq->channels;
+  PeaqEarModel *ear_params = peaq->fft_ear_model;
+  guint frame_size = peaq_earmodel_get_frame_size (ear_params);
+  guint step_size = peaq_earmodel_get_step_size (ear_params);
+  guint64 start = (guint64) peaq->frame_counter * step_size;
+
+  /* the threshold flag is only of interest for the frame trace */
+  gboolean above_thres = peaq->frame_trace &&
+    is_frame_above_threshold (refdata, frame_size, channels);
+
+  apply_ear_models (peaq, ear_params, refdata, testdata,
+                    peaq->ref_fft_ear_state, peaq->test_fft_ear_state);
+
+  GstClockTime t = stats_start (peaq);
+
+  peaq_mov_nmr (PEAQ_FFTEARMODEL (ear_params), peaq->ref_fft_ear_state,
+                peaq->test_fft_ear_state, peaq->mov_accum[MOVBASIC_TOTAL_NMR],
+                NULL);
+  t = stats_stop (peaq, STAGE_MOV_NMR, t, 1, 1);
+
+  peaq_mov_prob_detect (ear_params, peaq->ref_fft_ear_state,
+                        peaq->test_fft_ear_state, peaq->channels,
+                        peaq->mov_accum[MOVBASIC_ADB],
+                        peaq->mov_accum[MOVBASIC_MFPD]);
+  stats_stop (peaq, STAGE_MOV_PROB_DETECT, t, 1, 1);
+
+  screen_frame (peaq, start, start + frame_size);
+
+  calc_frame_energy (refdata, testdata, channels * frame_size / 2, energy);
+  finish_frame (peaq, LATENCY_FFT, above_thres, energy);
+}
+
+static void
+process_fft_block_advanced (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+{
+  gdouble energy[2];
+  gint channels = peaq->channels;
+  guint frame_size = peaq_earmodel_get_frame_size (peaq->fft_ear_model);
+
+  gboolean above_thres =
+    is_frame_above_threshold (refdata, frame_size, channels);
+
+  apply_ear_models (peaq, peaq->fft_ear_model, refdata, testdata,
+                    peaq->ref_fft_ear_state, peaq->test_fft_ear_state);
+  calc_movs_fft_advanced (peaq, above_thres);
+
+  calc_frame_energy (refdata, testdata, channels * frame_size / 2, energy);
+  finish_frame (peaq, LATENCY_FFT, above_thres, energy);
+}
+
+static void
+process_fb_block (GstPeaq *peaq, gfloat *refdata, gfloat *testdata)
+{
+  guint frame_size = peaq_earmodel_get_frame_size (peaq->fb_ear_model);
+
+  gboolean above_thres =
+    is_frame_above_threshold (refdata, frame_size, peaq->channels);
+
+  apply_ear_models (peaq, peaq->fb_ear_model, refdata, testdata,
+                    peaq->ref_fb_ear_state, peaq->test_fb_ear_state);
+  calc_movs_fb (peaq, above_thres);
+
+  finish_frame (peaq, LATENCY_FB, above_thres, NULL);
+}
+
+/*
+ * publish_results:
+ * @peaq: The #GstPeaq.
+ *
+ * Computes the model output variables, the distortion index, the objective
+ * difference grade and the total SNR from the current accumulator values and
+ * stores them as the snapshot returned by read_results(). Uses a sequence
+ * counter (odd while writing) instead of a lock, so readers never block
+ * the processing. Must be called with the object lock held, making it the
+ * only writer.
+ */
+static void
+publish_results (GstPeaq *peaq)
+{
+  struct _Results results;
+  guint i;
+
+  memset (&results, 0, sizeof (results));
+  results.frames = peaq->frame_counter;
+  if (peaq->advanced) {
+    for (i = 0; i < COUNT_MOV_ADVANCED; i++)
+      results.movs[i] = peaq_movaccum_get_value (peaq->mov_accum[i]);
+    results.di = peaq_calculate_di_advanced (results.movs);
+  } else {
+    for (i = 0; i < COUNT_MOV_BASIC; i++)
+      results.movs[i] = peaq_movaccum_get_value (peaq->mov_accum[i]);
+    results.di = peaq_calculate_di_basic (results.movs);
   }
+  results.odg = peaq_calculate_odg (results.di);
+  results.total_snr =
+    10 * log10 (peaq->total_signal_energy / peaq->total_noise_energy);
+
+  g_atomic_int_inc (&peaq->results_seq);
+  peaq->results = results;
+  g_atomic_int_inc (&peaq->results_seq);
+}
+
+/*
+ * read_results:
+ * @peaq: The #GstPeaq.
+ * @results: Location to copy the snapshot to.
+ *
+ * Copies the last snapshot stored by publish_results(), retrying if it was
+ * updated in the meantime.
+ */
+static void
+read_results (GstPeaq *peaq, struct _Results *results)
+{
+  gint seq;
+  do {
+    seq = g_atomic_int_get (&peaq->results_seq);
+    *results = peaq->results;
+  } while ((seq & 1) || g_atomic_int_get (&peaq->results_seq) != seq);
+}
+
+static GstStructure *
+get_results (GstPeaq *peaq)
+{
+  struct _Results results;
+  guint i;
+  GstStructure *structure;
+
+  read_results (peaq, &results);
+  structure = gst_structure_new ("peaq-results",
+                                 "frames", G_TYPE_UINT, results.frames,
+                                 "di", G_TYPE_DOUBLE, results.di,
+                                 "odg", G_TYPE_DOUBLE, results.odg,
+                                 "totalsnr", G_TYPE_DOUBLE, results.total_snr,
+                                 NULL);
+  if (peaq->advanced)
+    for (i = 0; i < COUNT_MOV_ADVANCED; i++)
+      gst_structure_set (structure, mov_names_advanced[i], G_TYPE_DOUBLE,
+                         results.movs[i], NULL);
+  else
+    for (i = 0; i < COUNT_MOV_BASIC; i++)
+      gst_structure_set (structure, mov_names_basic[i], G_TYPE_DOUBLE,
+                         results.movs[i], NULL);
+  return structure;
+}
 
-  peaq->frame_counter_fb++;
+/*
+ * calculate_di_from:
+ * @peaq: The #GstPeaq instance.
+ * @accums: The MOV accumulators, either #GstPeaq.mov_accum or the window
+ * accumulators.
+ *
+ * Returns: The distortion index of the current values of @accums for the
+ * version selected with #GstPeaq:advanced.
+ */
+static gdouble
+calculate_di_from (GstPeaq *peaq, PeaqMovAccum *const *accums)
+{
+  gdouble movs[COUNT_MOV_BASIC];
+  guint i;
+  if (peaq->advanced) {
+    for (i = 0; i < COUNT_MOV_ADVANCED; i++)
+      movs[i] = peaq_movaccum_get_value (accums[i]);
+    return peaq_calculate_di_advanced (movs);
+  }
+  for (i = 0; i < COUNT_MOV_BASIC; i++)
+    movs[i] = peaq_movaccum_get_value (accums[i]);
+  return peaq_calculate_di_basic (movs);
 }
 
 static double
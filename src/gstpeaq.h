@@ -43,10 +43,15 @@ G_BEGIN_DECLS;
 							    GST_TYPE_PEAQ, \
 							    GstPeaqClass))
 
+#define GST_TYPE_PEAQ_PASS       (gst_peaq_pass_get_type())
+#define GST_IS_PEAQ_PASS(obj)    (G_TYPE_CHECK_INSTANCE_TYPE((obj), \
+							     GST_TYPE_PEAQ_PASS))
+
 typedef struct _GstPeaq GstPeaq;
 typedef struct _GstPeaqClass GstPeaqClass;
 
 GType gst_peaq_get_type ();
+GType gst_peaq_pass_get_type ();
 
 G_END_DECLS;
 
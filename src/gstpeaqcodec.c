@@ -0,0 +1,628 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * gstpeaqcodec.c: Evaluate a codec in the loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:gstpeaqcodec
+ * @short_description: Evaluates an encoder and decoder in the loop.
+ * @title: peaqcodec
+ *
+ * The peaqcodec element is a bin with a single sink pad taking the reference
+ * signal. It passes the signal through the encoder and decoder given as
+ * #GstPeaqCodec:codec (in gst-launch syntax) and compares the decoded signal
+ * to the reference with a #GstPeaq element named "peaq", without writing the
+ * encoded or decoded data to disk. Both branches get a queue of their own,
+ * followed by the conversion to the format required by #GstPeaq.
+ *
+ * To time-align the signals, the reference is delayed by
+ * #GstPeaqCodec:delay samples of silence. By default, the delay is taken from the
+ * latency the codec reports, i.e. the difference of the minimum latency
+ * reported at its output and at its input once it has produced the first
+ * buffer; until then, the reference is held back in its queue, which is
+ * therefore unbounded. Codecs not reporting their algorithmic delay (or
+ * trimming it themselves) need an explicit #GstPeaqCodec:delay. The delay
+ * actually applied can be read from #GstPeaqCodec:compensated-delay.
+ *
+ * Properties of the #GstPeaq element and the results are accessible as child
+ * properties, e.g. "peaq::advanced" or "peaq::odg". The following evaluates
+ * an MP3 encoder at 128 kbit/s:
+ * |[
+ * gst-launch \
+ *   filesrc location="ref.wav" \! wavparse \! audioconvert \! \
+ *   peaqcodec codec="lamemp3enc target=bitrate bitrate=128 \! mpegaudioparse \! mpg123audiodec" \
+ *     peaq::console-output=true
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <string.h>
+
+#include "gstpeaqcodec.h"
+
+#define PEAQ_CAPS \
+  "audio/x-raw, format = F32LE, layout = interleaved, rate = (int) 48000"
+
+enum
+{
+  PROP_0,
+  PROP_CODEC,
+  PROP_DELAY,
+  PROP_COMPENSATED_DELAY
+};
+
+struct _GstPeaqCodec
+{
+  GstBin parent;
+  GstPad *sinkpad;
+  GstElement *tee;
+  GstElement *ref_queue;
+  GstElement *ref_filter;
+  GstElement *test_queue;
+  GstElement *test_convert;
+  GstElement *test_filter;
+  GstElement *codec;
+  GstElement *peaq;
+  gchar *codec_description;
+  gint64 delay;
+  GMutex lock;
+  GCond delay_known_cond;
+  gboolean delay_known;
+  gboolean delay_inserted;
+  gboolean flushing;
+  guint64 compensated_delay;
+  gulong test_probe_id;
+  gulong ref_probe_id;
+};
+
+struct _GstPeaqCodecClass
+{
+  GstBinClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("audio/x-raw"));
+
+static void base_init (gpointer g_class);
+static void class_init (gpointer g_class, gpointer class_data);
+static void init (GTypeInstance *obj, gpointer g_class);
+static void finalize (GObject *object);
+static void get_property (GObject *obj, guint id, GValue *value,
+                          GParamSpec *pspec);
+static void set_property (GObject *obj, guint id, const GValue *value,
+                          GParamSpec *pspec);
+static GstStateChangeReturn change_state (GstElement *element,
+                                          GstStateChange transition);
+static GstElement *make_element (GstPeaqCodec *bin, gchar const *factory);
+static gboolean build_fixed (GstPeaqCodec *bin);
+static gboolean build_codec (GstPeaqCodec *bin);
+static GstPadProbeReturn test_probe (GstPad *pad, GstPadProbeInfo *info,
+                                     gpointer user_data);
+static GstPadProbeReturn ref_probe (GstPad *pad, GstPadProbeInfo *info,
+                                    gpointer user_data);
+static GstClockTime query_min_latency (GstPad *pad);
+static void set_delay_known (GstPeaqCodec *bin, guint64 delay);
+static GstPadProbeReturn release_probe (GstPeaqCodec *bin, gulong *probe_id);
+static void remove_probe (GstPeaqCodec *bin, GstElement *element,
+                          gulong *probe_id);
+
+GType
+gst_peaq_codec_get_type (void)
+{
+  static GType type = 0;
+  if (type == 0) {
+    static const GTypeInfo info = {
+      sizeof (GstPeaqCodecClass),
+      base_init,
+      NULL,                     /* base_finalize */
+      class_init,
+      NULL,                     /* class_finalize */
+      NULL,                     /* class_data */
+      sizeof (GstPeaqCodec),
+      0,                        /* n_preallocs */
+      init
+    };
+    type = g_type_register_static (GST_TYPE_BIN, "GstPeaqCodec", &info, 0);
+  }
+  return type;
+}
+
+static void
+base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (g_class);
+
+  GstPadTemplate *pad_template = gst_static_pad_template_get (&sink_template);
+  gst_element_class_add_pad_template (element_class, pad_template);
+
+  element_class->change_state = change_state;
+
+  gobject_class->finalize = finalize;
+}
+
+static void
+class_init (gpointer g_class, gpointer class_data)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (g_class);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  object_class->get_property = get_property;
+  object_class->set_property = set_property;
+  g_object_class_install_property (object_class,
+				   PROP_CODEC,
+				   g_param_spec_string ("codec",
+							"codec",
+							"Encoder and decoder the reference is passed through, in gst-launch syntax",
+							NULL,
+							G_PARAM_READWRITE));
+  g_object_class_install_property (object_class,
+				   PROP_DELAY,
+				   g_param_spec_int64 ("delay",
+						       "delay",
+						       "Delay of the codec in samples at 48 kHz, or -1 to use the latency reported by the codec",
+						       -1, G_MAXINT64, -1,
+						       G_PARAM_READWRITE |
+						       G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class,
+				   PROP_COMPENSATED_DELAY,
+				   g_param_spec_uint64 ("compensated-delay",
+							"compensated delay",
+							"Number of samples of silence the reference has been delayed by",
+							0, G_MAXUINT64, 0,
+							G_PARAM_READABLE));
+
+  gst_element_class_set_static_metadata (element_class,
+                                        "Perceptual evaluation of a codec",
+                                        "Sink/Audio",
+                                        "Compute objective audio quality measures of an encoder and decoder",
+                                        "Martin Holters <" PACKAGE_BUGREPORT ">");
+}
+
+static void
+init (GTypeInstance *obj, gpointer g_class)
+{
+  GstPadTemplate *template;
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (obj);
+
+  template = gst_static_pad_template_get (&sink_template);
+  bin->sinkpad = gst_ghost_pad_new_no_target_from_template ("sink", template);
+  gst_object_unref (template);
+  gst_element_add_pad (GST_ELEMENT (bin), bin->sinkpad);
+
+  bin->tee = NULL;
+  bin->codec = NULL;
+  bin->peaq = NULL;
+  bin->codec_description = NULL;
+  g_mutex_init (&bin->lock);
+  g_cond_init (&bin->delay_known_cond);
+  bin->delay_known = FALSE;
+  bin->delay_inserted = FALSE;
+  bin->flushing = FALSE;
+  bin->compensated_delay = 0;
+  bin->test_probe_id = 0;
+  bin->ref_probe_id = 0;
+}
+
+static void
+finalize (GObject *object)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (object);
+  GObjectClass *parent_class =
+    G_OBJECT_CLASS (g_type_class_peek_parent
+                    (g_type_class_peek (GST_TYPE_PEAQ_CODEC)));
+
+  g_free (bin->codec_description);
+  g_mutex_clear (&bin->lock);
+  g_cond_clear (&bin->delay_known_cond);
+  parent_class->finalize (object);
+}
+
+static void
+get_property (GObject *obj, guint id, GValue *value, GParamSpec *pspec)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (obj);
+  switch (id) {
+    case PROP_CODEC:
+      g_value_set_string (value, bin->codec_description);
+      break;
+    case PROP_DELAY:
+      g_value_set_int64 (value, bin->delay);
+      break;
+    case PROP_COMPENSATED_DELAY:
+      g_mutex_lock (&bin->lock);
+      g_value_set_uint64 (value, bin->compensated_delay);
+      g_mutex_unlock (&bin->lock);
+      break;
+  }
+}
+
+static void
+set_property (GObject *obj, guint id, const GValue *value, GParamSpec *pspec)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (obj);
+  switch (id) {
+    case PROP_CODEC:
+      g_free (bin->codec_description);
+      bin->codec_description = g_value_dup_string (value);
+      break;
+    case PROP_DELAY:
+      bin->delay = g_value_get_int64 (value);
+      break;
+  }
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element, GstStateChange transition)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (element);
+  GstElementClass *parent_class =
+    GST_ELEMENT_CLASS (g_type_class_peek_parent
+                       (g_type_class_peek (GST_TYPE_PEAQ_CODEC)));
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!bin->tee && !build_fixed (bin))
+        return GST_STATE_CHANGE_FAILURE;
+      if (!build_codec (bin))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      {
+        GstPad *pad;
+        g_mutex_lock (&bin->lock);
+        bin->delay_known = FALSE;
+        bin->delay_inserted = FALSE;
+        bin->flushing = FALSE;
+        bin->compensated_delay = 0;
+        g_mutex_unlock (&bin->lock);
+        pad = gst_element_get_static_pad (bin->test_filter, "src");
+        bin->test_probe_id =
+          gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+                             GST_PAD_PROBE_TYPE_BUFFER_LIST |
+                             GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                             test_probe, bin, NULL);
+        gst_object_unref (pad);
+        pad = gst_element_get_static_pad (bin->ref_filter, "src");
+        bin->ref_probe_id =
+          gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+                             GST_PAD_PROBE_TYPE_BUFFER_LIST |
+                             GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+                             ref_probe, bin, NULL);
+        gst_object_unref (pad);
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* release a reference branch waiting for the delay */
+      g_mutex_lock (&bin->lock);
+      bin->flushing = TRUE;
+      g_cond_broadcast (&bin->delay_known_cond);
+      g_mutex_unlock (&bin->lock);
+      /* the probes of a stream ended early are still installed */
+      remove_probe (bin, bin->test_filter, &bin->test_probe_id);
+      remove_probe (bin, bin->ref_filter, &bin->ref_probe_id);
+      break;
+    default:
+      break;
+  }
+
+  return parent_class->change_state (element, transition);
+}
+
+static GstElement *
+make_element (GstPeaqCodec *bin, gchar const *factory)
+{
+  GstElement *element = gst_element_factory_make (factory, NULL);
+  if (!element) {
+    GST_ELEMENT_ERROR (bin, CORE, MISSING_PLUGIN,
+                       ("Element %s could not be created.", factory), (NULL));
+    return NULL;
+  }
+  gst_bin_add (GST_BIN (bin), element);
+  return element;
+}
+
+/*
+ * build_fixed:
+ * @bin: The #GstPeaqCodec.
+ *
+ * Creates and links the elements not depending on #GstPeaqCodec:codec: the
+ * tee, the reference branch up to the ref pad of the #GstPeaq element, and
+ * the test branch from the codec output on.
+ *
+ * Returns: %FALSE if an element could not be created.
+ */
+static gboolean
+build_fixed (GstPeaqCodec *bin)
+{
+  GstElement *ref_convert, *ref_resample, *test_resample;
+  GstCaps *caps;
+  GstPad *pad;
+
+  if (!(bin->tee = make_element (bin, "tee")) ||
+      !(bin->ref_queue = make_element (bin, "queue")) ||
+      !(ref_convert = make_element (bin, "audioconvert")) ||
+      !(ref_resample = make_element (bin, "audioresample")) ||
+      !(bin->ref_filter = make_element (bin, "capsfilter")) ||
+      !(bin->test_queue = make_element (bin, "queue")) ||
+      !(bin->test_convert = make_element (bin, "audioconvert")) ||
+      !(test_resample = make_element (bin, "audioresample")) ||
+      !(bin->test_filter = make_element (bin, "capsfilter")))
+    return FALSE;
+  bin->peaq = gst_element_factory_make ("peaq", "peaq");
+  if (!bin->peaq) {
+    GST_ELEMENT_ERROR (bin, CORE, MISSING_PLUGIN,
+                       ("Element peaq could not be created."), (NULL));
+    return FALSE;
+  }
+  gst_bin_add (GST_BIN (bin), bin->peaq);
+
+  /* the reference is held back until the codec delay is known */
+  g_object_set (bin->ref_queue, "max-size-buffers", 0, "max-size-bytes", 0,
+                "max-size-time", (guint64) 0, NULL);
+  caps = gst_caps_from_string (PEAQ_CAPS);
+  g_object_set (bin->ref_filter, "caps", caps, NULL);
+  g_object_set (bin->test_filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  if (!gst_element_link_many (bin->tee, bin->ref_queue, ref_convert,
+                              ref_resample, bin->ref_filter, NULL) ||
+      !gst_element_link_pads (bin->ref_filter, "src", bin->peaq, "ref") ||
+      !gst_element_link (bin->tee, bin->test_queue) ||
+      !gst_element_link_many (bin->test_convert, test_resample,
+                              bin->test_filter, NULL) ||
+      !gst_element_link_pads (bin->test_filter, "src", bin->peaq, "test"))
+    return FALSE;
+
+  pad = gst_element_get_static_pad (bin->tee, "sink");
+  gst_ghost_pad_set_target (GST_GHOST_PAD (bin->sinkpad), pad);
+  gst_object_unref (pad);
+  return TRUE;
+}
+
+/*
+ * build_codec:
+ * @bin: The #GstPeaqCodec.
+ *
+ * (Re-)creates the codec from #GstPeaqCodec:codec and links it between the
+ * queue and the conversion of the test branch.
+ *
+ * Returns: %FALSE if the description could not be parsed or linked.
+ */
+static gboolean
+build_codec (GstPeaqCodec *bin)
+{
+  GError *error = NULL;
+
+  if (bin->codec) {
+    gst_element_set_state (bin->codec, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (bin), bin->codec);
+    bin->codec = NULL;
+  }
+  if (!bin->codec_description) {
+    GST_ELEMENT_ERROR (bin, CORE, NEGOTIATION,
+                       ("No codec given."), (NULL));
+    return FALSE;
+  }
+  bin->codec = gst_parse_bin_from_description (bin->codec_description, TRUE,
+                                               &error);
+  if (!bin->codec) {
+    GST_ELEMENT_ERROR (bin, CORE, FAILED,
+                       ("Codec %s could not be created: %s",
+                        bin->codec_description, error->message), (NULL));
+    g_error_free (error);
+    return FALSE;
+  }
+  gst_bin_add (GST_BIN (bin), bin->codec);
+  if (!gst_element_link_many (bin->test_queue, bin->codec, bin->test_convert,
+                              NULL)) {
+    GST_ELEMENT_ERROR (bin, CORE, NEGOTIATION,
+                       ("Codec %s could not be linked.",
+                        bin->codec_description), (NULL));
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+ * query_min_latency:
+ * @pad: A sink pad.
+ *
+ * Returns: The minimum latency reported by the elements upstream of @pad, 0
+ * if the query fails.
+ */
+static GstClockTime
+query_min_latency (GstPad *pad)
+{
+  GstQuery *query = gst_query_new_latency ();
+  GstClockTime min_latency = 0;
+  if (gst_pad_peer_query (pad, query)) {
+    gboolean live;
+    GstClockTime max_latency;
+    gst_query_parse_latency (query, &live, &min_latency, &max_latency);
+    if (!GST_CLOCK_TIME_IS_VALID (min_latency))
+      min_latency = 0;
+  }
+  gst_query_unref (query);
+  return min_latency;
+}
+
+static void
+set_delay_known (GstPeaqCodec *bin, guint64 delay)
+{
+  g_mutex_lock (&bin->lock);
+  if (!bin->delay_known) {
+    bin->compensated_delay = delay;
+    bin->delay_known = TRUE;
+    g_cond_broadcast (&bin->delay_known_cond);
+  }
+  g_mutex_unlock (&bin->lock);
+}
+
+/*
+ * release_probe:
+ * @bin: The #GstPeaqCodec.
+ * @probe_id: Location of the id of the probe that is done.
+ *
+ * Claims the probe for removal by its callback, unless change_state() has
+ * claimed it already, so that it is removed exactly once.
+ *
+ * Returns: The value for the callback to return.
+ */
+static GstPadProbeReturn
+release_probe (GstPeaqCodec *bin, gulong *probe_id)
+{
+  GstPadProbeReturn ret;
+  g_mutex_lock (&bin->lock);
+  ret = *probe_id ? GST_PAD_PROBE_REMOVE : GST_PAD_PROBE_OK;
+  *probe_id = 0;
+  g_mutex_unlock (&bin->lock);
+  return ret;
+}
+
+/*
+ * remove_probe:
+ * @bin: The #GstPeaqCodec.
+ * @element: The element on whose source pad the probe is installed.
+ * @probe_id: Location of the id of the probe.
+ *
+ * Removes the probe unless its callback has removed it already.
+ */
+static void
+remove_probe (GstPeaqCodec *bin, GstElement *element, gulong *probe_id)
+{
+  gulong id;
+  g_mutex_lock (&bin->lock);
+  id = *probe_id;
+  *probe_id = 0;
+  g_mutex_unlock (&bin->lock);
+  if (id) {
+    GstPad *pad = gst_element_get_static_pad (element, "src");
+    gst_pad_remove_probe (pad, id);
+    gst_object_unref (pad);
+  }
+}
+
+/*
+ * test_probe:
+ *
+ * Determines the delay once the codec has produced its first buffer (or
+ * nothing at all), when the codec has configured its latency.
+ */
+static GstPadProbeReturn
+test_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (user_data);
+  guint64 delay = 0;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) != GST_EVENT_EOS)
+      return GST_PAD_PROBE_OK;
+  } else if (bin->delay >= 0) {
+    delay = bin->delay;
+  } else {
+    GstPad *codec_sink = gst_element_get_static_pad (bin->codec, "sink");
+    GstPad *convert_sink =
+      gst_element_get_static_pad (bin->test_convert, "sink");
+    GstClockTime codec_in = query_min_latency (codec_sink);
+    GstClockTime codec_out = query_min_latency (convert_sink);
+    if (codec_out > codec_in)
+      delay = gst_util_uint64_scale_round (codec_out - codec_in, 48000,
+                                           GST_SECOND);
+    gst_object_unref (codec_sink);
+    gst_object_unref (convert_sink);
+  }
+  set_delay_known (bin, delay);
+  return release_probe (bin, &bin->test_probe_id);
+}
+
+/*
+ * ref_probe:
+ *
+ * Waits for the delay to be determined and pushes that many samples of
+ * silence ahead of the first reference buffer. A flush releases the wait and
+ * drops the buffer; the silence then goes ahead of the first buffer after
+ * the flush.
+ */
+static GstPadProbeReturn
+ref_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  GstPeaqCodec *bin = GST_PEAQ_CODEC (user_data);
+  guint64 delay;
+  GstCaps *caps;
+  gint channels = 1;
+  GstBuffer *silence;
+  GstMapInfo map;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    g_mutex_lock (&bin->lock);
+    switch (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info))) {
+      case GST_EVENT_FLUSH_START:
+        bin->flushing = TRUE;
+        g_cond_broadcast (&bin->delay_known_cond);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        bin->flushing = FALSE;
+        break;
+      default:
+        break;
+    }
+    g_mutex_unlock (&bin->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  g_mutex_lock (&bin->lock);
+  if (bin->delay_inserted) {
+    /* the silence pushed below */
+    g_mutex_unlock (&bin->lock);
+    return GST_PAD_PROBE_OK;
+  }
+  while (!bin->delay_known && !bin->flushing)
+    g_cond_wait (&bin->delay_known_cond, &bin->lock);
+  if (bin->flushing) {
+    g_mutex_unlock (&bin->lock);
+    return GST_PAD_PROBE_DROP;
+  }
+  bin->delay_inserted = TRUE;
+  delay = bin->compensated_delay;
+  g_mutex_unlock (&bin->lock);
+
+  if (delay > 0) {
+    caps = gst_pad_get_current_caps (pad);
+    if (caps) {
+      gst_structure_get_int (gst_caps_get_structure (caps, 0), "channels",
+                             &channels);
+      gst_caps_unref (caps);
+    }
+    silence = gst_buffer_new_allocate (NULL, delay * channels *
+                                       sizeof (gfloat), NULL);
+    gst_buffer_map (silence, &map, GST_MAP_WRITE);
+    memset (map.data, 0, map.size);
+    gst_buffer_unmap (silence, &map);
+    gst_pad_push (pad, silence);
+  }
+  return release_probe (bin, &bin->ref_probe_id);
+}
@@ -0,0 +1,44 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * gstpeaqcodec.h: Evaluate a codec in the loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_PEAQ_CODEC_H__
+#define __GST_PEAQ_CODEC_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS;
+
+#define GST_TYPE_PEAQ_CODEC            (gst_peaq_codec_get_type())
+#define GST_PEAQ_CODEC(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj), \
+								   GST_TYPE_PEAQ_CODEC, \
+								   GstPeaqCodec))
+#define GST_IS_PEAQ_CODEC(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), \
+								   GST_TYPE_PEAQ_CODEC))
+
+typedef struct _GstPeaqCodec GstPeaqCodec;
+typedef struct _GstPeaqCodecClass GstPeaqCodecClass;
+
+GType gst_peaq_codec_get_type ();
+
+G_END_DECLS;
+
+#endif /* __GST_PEAQ_CODEC_H__ */
@@ -24,13 +24,18 @@
 #endif
 
 #include "gstpeaq.h"
+#include "gstpeaqcodec.h"
 
 #include <gst/gst.h>
 
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  return gst_element_register (plugin, "peaq", GST_RANK_NONE, GST_TYPE_PEAQ);
+  return gst_element_register (plugin, "peaq", GST_RANK_NONE, GST_TYPE_PEAQ) &&
+    gst_element_register (plugin, "peaqpass", GST_RANK_NONE,
+                          GST_TYPE_PEAQ_PASS) &&
+    gst_element_register (plugin, "peaqcodec", GST_RANK_NONE,
+                          GST_TYPE_PEAQ_CODEC);
 }
 
 GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
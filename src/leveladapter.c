@@ -36,6 +36,7 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include "leveladapter.h"
 
@@ -384,3 +385,92 @@ peaq_leveladapter_get_adapted_test (PeaqLevelAdapter const* level)
 {
   return level->spectrally_adapted_test_patterns;
 }
+
+/**
+ * peaq_leveladapter_get_memory_size:
+ * @level: The #PeaqLevelAdapter to determine the memory usage of.
+ *
+ * Returns the number of bytes allocated for @level, not including the
+ * referenced #PeaqEarModel.
+ *
+ * Returns: The memory used by @level in bytes.
+ */
+gsize
+peaq_leveladapter_get_memory_size (PeaqLevelAdapter const *level)
+{
+  /* nine per-band arrays, see peaq_leveladapter_set_ear_model() */
+  return sizeof (PeaqLevelAdapter) +
+    9 * peaq_earmodel_get_band_count (level->ear_model) * sizeof (gdouble);
+}
+
+/**
+ * peaq_leveladapter_get_checkpoint_size:
+ * @level: The #PeaqLevelAdapter to determine the checkpoint size of.
+ *
+ * Returns the number of values written by
+ * peaq_leveladapter_save_checkpoint().
+ *
+ * Returns: The number of values in a checkpoint of @level.
+ */
+gsize
+peaq_leveladapter_get_checkpoint_size (PeaqLevelAdapter const *level)
+{
+  /* the six time-smoothed per-band arrays; the spectrally adapted patterns are
+   * recomputed for every frame */
+  return 6 * peaq_earmodel_get_band_count (level->ear_model);
+}
+
+/**
+ * peaq_leveladapter_save_checkpoint:
+ * @level: The #PeaqLevelAdapter to save the state of.
+ * @data: Array of peaq_leveladapter_get_checkpoint_size() values to write to.
+ *
+ * Copies the filter states carried over from one call of
+ * peaq_leveladapter_process() to the next to @data.
+ */
+void
+peaq_leveladapter_save_checkpoint (PeaqLevelAdapter const *level,
+                                   gdouble *data)
+{
+  guint band_count = peaq_earmodel_get_band_count (level->ear_model);
+  gsize size = band_count * sizeof (gdouble);
+  memcpy (data, level->ref_filtered_excitation, size);
+  data += band_count;
+  memcpy (data, level->test_filtered_excitation, size);
+  data += band_count;
+  memcpy (data, level->filtered_num, size);
+  data += band_count;
+  memcpy (data, level->filtered_den, size);
+  data += band_count;
+  memcpy (data, level->pattcorr_ref, size);
+  data += band_count;
+  memcpy (data, level->pattcorr_test, size);
+}
+
+/**
+ * peaq_leveladapter_restore_checkpoint:
+ * @level: The #PeaqLevelAdapter to restore the state of.
+ * @data: Array of peaq_leveladapter_get_checkpoint_size() values as written
+ * by peaq_leveladapter_save_checkpoint().
+ *
+ * Sets the filter states carried over from one call of
+ * peaq_leveladapter_process() to the next from @data.
+ */
+void
+peaq_leveladapter_restore_checkpoint (PeaqLevelAdapter *level,
+                                      gdouble const *data)
+{
+  guint band_count = peaq_earmodel_get_band_count (level->ear_model);
+  gsize size = band_count * sizeof (gdouble);
+  memcpy (level->ref_filtered_excitation, data, size);
+  data += band_count;
+  memcpy (level->test_filtered_excitation, data, size);
+  data += band_count;
+  memcpy (level->filtered_num, data, size);
+  data += band_count;
+  memcpy (level->filtered_den, data, size);
+  data += band_count;
+  memcpy (level->pattcorr_ref, data, size);
+  data += band_count;
+  memcpy (level->pattcorr_test, data, size);
+}
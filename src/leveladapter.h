@@ -53,4 +53,10 @@ void peaq_leveladapter_process (PeaqLevelAdapter *level,
 				gdouble const *test_excitation);
 gdouble const* peaq_leveladapter_get_adapted_ref (PeaqLevelAdapter const* level);
 gdouble const* peaq_leveladapter_get_adapted_test (PeaqLevelAdapter const* level);
+gsize peaq_leveladapter_get_memory_size (PeaqLevelAdapter const *level);
+gsize peaq_leveladapter_get_checkpoint_size (PeaqLevelAdapter const *level);
+void peaq_leveladapter_save_checkpoint (PeaqLevelAdapter const *level,
+                                        gdouble *data);
+void peaq_leveladapter_restore_checkpoint (PeaqLevelAdapter *level,
+                                           gdouble const *data);
 #endif
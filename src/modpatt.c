@@ -38,6 +38,7 @@
 #include "modpatt.h"
 
 #include <math.h>
+#include <string.h>
 
 /**
  * PeaqModulationProcessorClass:
@@ -287,3 +288,80 @@ peaq_modulationprocessor_get_modulation (PeaqModulationProcessor const *modproc)
 {
   return modproc->modulation;
 }
+
+/**
+ * peaq_modulationprocessor_get_memory_size:
+ * @modproc: The #PeaqModulationProcessor to determine the memory usage of.
+ *
+ * Returns the number of bytes allocated for @modproc, not including the
+ * referenced #PeaqEarModel.
+ *
+ * Returns: The memory used by @modproc in bytes.
+ */
+gsize
+peaq_modulationprocessor_get_memory_size (PeaqModulationProcessor const *modproc)
+{
+  /* five per-band arrays, see peaq_modulationprocessor_set_ear_model() */
+  return sizeof (PeaqModulationProcessor) +
+    5 * peaq_earmodel_get_band_count (modproc->ear_model) * sizeof (gdouble);
+}
+
+/**
+ * peaq_modulationprocessor_get_checkpoint_size:
+ * @modproc: The #PeaqModulationProcessor to determine the checkpoint size of.
+ *
+ * Returns the number of values written by
+ * peaq_modulationprocessor_save_checkpoint().
+ *
+ * Returns: The number of values in a checkpoint of @modproc.
+ */
+gsize
+peaq_modulationprocessor_get_checkpoint_size (PeaqModulationProcessor const *modproc)
+{
+  /* previous_loudness, filtered_loudness and filtered_loudness_derivative;
+   * the modulation is recomputed for every frame */
+  return 3 * peaq_earmodel_get_band_count (modproc->ear_model);
+}
+
+/**
+ * peaq_modulationprocessor_save_checkpoint:
+ * @modproc: The #PeaqModulationProcessor to save the state of.
+ * @data: Array of peaq_modulationprocessor_get_checkpoint_size() values to
+ * write to.
+ *
+ * Copies the loudness of the previous frame and the filter states carried
+ * over from one call of peaq_modulationprocessor_process() to the next to
+ * @data.
+ */
+void
+peaq_modulationprocessor_save_checkpoint (PeaqModulationProcessor const *modproc,
+                                          gdouble *data)
+{
+  guint band_count = peaq_earmodel_get_band_count (modproc->ear_model);
+  memcpy (data, modproc->previous_loudness, band_count * sizeof (gdouble));
+  memcpy (data + band_count, modproc->filtered_loudness,
+          band_count * sizeof (gdouble));
+  memcpy (data + 2 * band_count, modproc->filtered_loudness_derivative,
+          band_count * sizeof (gdouble));
+}
+
+/**
+ * peaq_modulationprocessor_restore_checkpoint:
+ * @modproc: The #PeaqModulationProcessor to restore the state of.
+ * @data: Array of peaq_modulationprocessor_get_checkpoint_size() values as
+ * written by peaq_modulationprocessor_save_checkpoint().
+ *
+ * Sets the loudness of the previous frame and the filter states carried over
+ * from one call of peaq_modulationprocessor_process() to the next from @data.
+ */
+void
+peaq_modulationprocessor_restore_checkpoint (PeaqModulationProcessor *modproc,
+                                             gdouble const *data)
+{
+  guint band_count = peaq_earmodel_get_band_count (modproc->ear_model);
+  memcpy (modproc->previous_loudness, data, band_count * sizeof (gdouble));
+  memcpy (modproc->filtered_loudness, data + band_count,
+          band_count * sizeof (gdouble));
+  memcpy (modproc->filtered_loudness_derivative, data + 2 * band_count,
+          band_count * sizeof (gdouble));
+}
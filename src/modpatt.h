@@ -54,4 +54,10 @@ void peaq_modulationprocessor_process (PeaqModulationProcessor *modproc,
 				       gdouble const* unsmeared_excitation);
 gdouble const *peaq_modulationprocessor_get_average_loudness (PeaqModulationProcessor const *modproc);
 gdouble const *peaq_modulationprocessor_get_modulation (PeaqModulationProcessor const *modproc);
+gsize peaq_modulationprocessor_get_memory_size (PeaqModulationProcessor const *modproc);
+gsize peaq_modulationprocessor_get_checkpoint_size (PeaqModulationProcessor const *modproc);
+void peaq_modulationprocessor_save_checkpoint (PeaqModulationProcessor const *modproc,
+                                               gdouble *data);
+void peaq_modulationprocessor_restore_checkpoint (PeaqModulationProcessor *modproc,
+                                                  gdouble const *data);
 #endif
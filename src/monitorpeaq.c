@@ -0,0 +1,377 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * monitorpeaq.c: Evaluate many streams at once on a fixed pool of threads.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+/*
+ * Simulates monitoring a number of programs on one host: the reference/test
+ * pairs of WAV files (16, 24 or 32 bit integer or 32 bit float at 48 kHz)
+ * listed in a manifest, one pair of file names separated by whitespace per
+ * line (empty lines and lines starting with # are ignored), are all evaluated
+ * at the same time, each by its own peaq element, but without any streaming
+ * threads: the data is pushed in chunks of --hops FFT hops by a fixed pool of
+ * --threads worker threads.
+ *
+ * Each chunk of a stream becomes due when it has completely arrived (in real
+ * time, counted from the start) and has to be processed before the next chunk
+ * of the stream arrives. The workers always take the chunk with the earliest
+ * deadline, so all streams advance at the same pace and each stream is
+ * processed by only one worker at a time, keeping its state in that worker's
+ * cache for a whole chunk. With --realtime, the workers wait for the data to
+ * arrive and the chunks finished after their deadline are counted; otherwise
+ * the streams are processed as fast as possible and the achieved real-time
+ * factor gives the number of streams the host could monitor.
+ *
+ * Only the threading and scheduling are shared between the streams. Their
+ * ear models still run one hop of one stream at a time; processing the same
+ * hop of several streams in a single pass over a structure-of-streams layout
+ * is not implemented.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "toolutil.h"
+
+#define SAMPLING_RATE 48000
+#define HOP_FRAMES 1024
+
+typedef struct _Stream Stream;
+
+struct _Stream
+{
+  gchar *name;
+  gfloat *ref;
+  gfloat *test;
+  guint channels;
+  gsize frames;
+  gsize position;
+  GstElement *peaq;
+  GstPad *ref_src;
+  GstPad *test_src;
+  gint64 deadline;
+  guint chunks;
+  guint misses;
+  gint64 max_lateness;
+  gboolean ok;
+  gdouble odg;
+  gdouble di;
+};
+
+static gboolean advanced = FALSE;
+static gdouble playback_level = 92.;
+static gint threads = 0;
+static gint hops = 16;
+static gboolean realtime = FALSE;
+static gchar **arguments;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced, "use advanced version",
+   NULL},
+  {"basic", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &advanced,
+   "use basic version (default)", NULL},
+  {"playback-level", 0, 0, G_OPTION_ARG_DOUBLE, &playback_level,
+   "playback level in dB SPL (default: 92)", "DB"},
+  {"threads", 't', 0, G_OPTION_ARG_INT, &threads,
+   "number of worker threads (default: number of processors)", "N"},
+  {"hops", 0, 0, G_OPTION_ARG_INT, &hops,
+   "number of FFT hops (1024 samples) per chunk (default: 16)", "N"},
+  {"realtime", 'r', 0, G_OPTION_ARG_NONE, &realtime,
+   "wait for the data to arrive in real time and count missed deadlines",
+   NULL},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &arguments, NULL,
+   "MANIFEST"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static gint64 start_time;
+static GThreadPool *pool;
+static GMutex finished_mutex;
+static GCond finished_cond;
+static guint finished;
+
+/*
+ * compare_deadlines:
+ *
+ * Orders the queued streams of the thread pool by the deadline of their next
+ * chunk.
+ */
+static gint
+compare_deadlines (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  Stream const *sa = a;
+  Stream const *sb = b;
+  return sa->deadline < sb->deadline ? -1 : sa->deadline > sb->deadline;
+}
+
+static gint64
+chunk_end_time (gsize position)
+{
+  return start_time + (gint64) position * G_USEC_PER_SEC / SAMPLING_RATE;
+}
+
+static void
+schedule (Stream *stream)
+{
+  gsize chunk = (gsize) hops * HOP_FRAMES;
+  /* due once the chunk has arrived, to be done when the next one has */
+  stream->deadline = chunk_end_time (MIN (stream->position + 2 * chunk,
+                                          stream->frames + chunk));
+  g_thread_pool_push (pool, stream, NULL);
+}
+
+static void
+finish (Stream *stream)
+{
+  gst_element_set_state (stream->peaq, GST_STATE_NULL);
+  g_object_get (stream->peaq, "odg", &stream->odg, "di", &stream->di, NULL);
+  gst_object_unref (stream->ref_src);
+  gst_object_unref (stream->test_src);
+  gst_object_unref (stream->peaq);
+  g_free (stream->ref);
+  g_free (stream->test);
+  stream->ref = stream->test = NULL;
+
+  g_mutex_lock (&finished_mutex);
+  finished++;
+  g_cond_signal (&finished_cond);
+  g_mutex_unlock (&finished_mutex);
+}
+
+/*
+ * process_chunk:
+ * @data: The #Stream to advance.
+ * @user_data: Unused.
+ *
+ * Pushes the next chunk of the stream through its element and queues the
+ * stream again for the chunk after that, or finishes the stream.
+ */
+static void
+process_chunk (gpointer data, gpointer user_data)
+{
+  Stream *stream = data;
+  gsize chunk = MIN ((gsize) hops * HOP_FRAMES,
+                     stream->frames - stream->position);
+  gsize size = chunk * stream->channels * sizeof (gfloat);
+  gsize offset = stream->position * stream->channels;
+  gint64 now;
+
+  if (realtime) {
+    gint64 arrival = chunk_end_time (stream->position + chunk);
+    now = g_get_monotonic_time ();
+    if (arrival > now)
+      g_usleep (arrival - now);
+  }
+
+  if (peaq_toolutil_push_block (stream->ref_src, stream->ref + offset,
+                                size) != GST_FLOW_OK ||
+      peaq_toolutil_push_block (stream->test_src, stream->test + offset,
+                                size) != GST_FLOW_OK) {
+    g_printf ("Error: pushing data of %s failed\n", stream->name);
+    stream->ok = FALSE;
+  }
+  stream->position += chunk;
+  stream->chunks++;
+
+  now = g_get_monotonic_time ();
+  if (realtime && now > stream->deadline) {
+    stream->misses++;
+    stream->max_lateness = MAX (stream->max_lateness, now - stream->deadline);
+  }
+
+  if (stream->ok && stream->position < stream->frames)
+    schedule (stream);
+  else
+    finish (stream);
+}
+
+static gboolean
+setup_stream (Stream *stream, gchar const *ref_file, gchar const *test_file)
+{
+  guint ref_channels, test_channels;
+  gsize ref_frames, test_frames;
+
+  stream->ref = peaq_toolutil_read_wav (ref_file, &ref_channels, &ref_frames);
+  stream->test = peaq_toolutil_read_wav (test_file, &test_channels,
+                                         &test_frames);
+  if (!stream->ref || !stream->test || ref_channels != test_channels ||
+      ref_channels > 2) {
+    if (stream->ref && stream->test)
+      g_printf ("Error: %s and %s must both be mono or stereo\n", ref_file,
+                test_file);
+    g_free (stream->ref);
+    g_free (stream->test);
+    return FALSE;
+  }
+  if (MIN (ref_frames, test_frames) == 0) {
+    g_printf ("Error: %s or %s is empty\n", ref_file, test_file);
+    g_free (stream->ref);
+    g_free (stream->test);
+    return FALSE;
+  }
+  stream->name = g_strdup (test_file);
+  stream->channels = ref_channels;
+  stream->frames = MIN (ref_frames, test_frames);
+  stream->ok = TRUE;
+
+  stream->peaq = gst_element_factory_make ("peaq", NULL);
+  if (!stream->peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    exit (2);
+  }
+  gst_object_ref_sink (stream->peaq);
+  g_object_set (G_OBJECT (stream->peaq), "advanced", advanced,
+                "playback-level", playback_level,
+                "console_output", FALSE, NULL);
+  stream->ref_src = peaq_toolutil_create_src_pad (stream->peaq, "ref");
+  stream->test_src = peaq_toolutil_create_src_pad (stream->peaq, "test");
+  gst_element_set_state (stream->peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (stream->ref_src, stream->channels);
+  peaq_toolutil_start_stream (stream->test_src, stream->channels);
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gchar *manifest;
+  gchar **lines;
+  GArray *streams;
+  gsize total_frames = 0;
+  guint chunks = 0, misses = 0, failures = 0;
+  gint64 max_lateness = 0;
+  gdouble wall_time;
+  guint i;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "monitorpeaq evaluates all reference/test pairs listed in MANIFEST\n"
+                                "concurrently on a fixed pool of threads.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (arguments == NULL || arguments[0] == NULL || arguments[1] != NULL ||
+      hops < 1) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+  if (threads < 1)
+    threads = g_get_num_processors ();
+
+  if (!g_file_get_contents (arguments[0], &manifest, NULL, NULL)) {
+    g_printf ("Error: could not read %s\n", arguments[0]);
+    return 1;
+  }
+
+  /* the streams are referenced by the pool, so the array must not grow */
+  lines = g_strsplit (manifest, "\n", -1);
+  g_free (manifest);
+  streams = g_array_sized_new (FALSE, TRUE, sizeof (Stream),
+                               g_strv_length (lines));
+  for (i = 0; lines[i]; i++) {
+    gchar **files;
+    Stream stream = { NULL };
+    guint j, k;
+
+    g_strstrip (lines[i]);
+    if (lines[i][0] == '\0' || lines[i][0] == '#')
+      continue;
+    files = g_strsplit_set (lines[i], " \t", -1);
+    /* remove empty fields from repeated separators */
+    for (j = k = 0; files[j]; j++)
+      if (files[j][0] != '\0')
+        files[k++] = files[j];
+      else
+        g_free (files[j]);
+    files[k] = NULL;
+    if (k != 2) {
+      g_printf ("Error: line %u of %s is no pair of file names\n", i + 1,
+                arguments[0]);
+      failures++;
+    } else if (!setup_stream (&stream, files[0], files[1])) {
+      failures++;
+    } else {
+      g_array_append_val (streams, stream);
+    }
+    g_strfreev (files);
+  }
+  g_strfreev (lines);
+
+  pool = g_thread_pool_new (process_chunk, NULL, threads, TRUE, NULL);
+  g_thread_pool_set_sort_function (pool, compare_deadlines, NULL);
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < streams->len; i++)
+    schedule (&g_array_index (streams, Stream, i));
+
+  g_mutex_lock (&finished_mutex);
+  while (finished < streams->len)
+    g_cond_wait (&finished_cond, &finished_mutex);
+  g_mutex_unlock (&finished_mutex);
+  wall_time = (g_get_monotonic_time () - start_time) / (gdouble) G_USEC_PER_SEC;
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  g_printf ("%8s %8s %8s %12s  %s\n", "ODG", "DI", "misses", "max late/ms",
+            "stream");
+  for (i = 0; i < streams->len; i++) {
+    Stream *stream = &g_array_index (streams, Stream, i);
+    if (stream->ok)
+      g_printf ("%8.3f %8.3f %8u %12.1f  %s\n", stream->odg, stream->di,
+                stream->misses, stream->max_lateness / 1000., stream->name);
+    else
+      failures++;
+    total_frames += stream->frames;
+    chunks += stream->chunks;
+    misses += stream->misses;
+    max_lateness = MAX (max_lateness, stream->max_lateness);
+    g_free (stream->name);
+  }
+  g_printf ("%u streams on %d threads: %.1f s of audio in %.1f s "
+            "(%.1f times real time)\n", streams->len, threads,
+            total_frames / (gdouble) SAMPLING_RATE, wall_time,
+            total_frames / (gdouble) SAMPLING_RATE / wall_time);
+  if (realtime)
+    g_printf ("%u of %u chunks missed their deadline, by up to %.1f ms\n",
+              misses, chunks, max_lateness / 1000.);
+  if (failures)
+    g_printf ("%u pairs failed\n", failures);
+  g_array_free (streams, TRUE);
+
+  gst_deinit ();
+
+  return failures > 0 ? 1 : 0;
+}
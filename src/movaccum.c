@@ -38,11 +38,24 @@
  * occurred), the value before the first quiet frame will be used.  If,
  * however, a louder frame occurs, tentative mode can be deactived to commit
  * all accumulation done in the mean time.
+ *
+ * To support incremental re-evaluation, the complete accumulator state can be
+ * saved with peaq_movaccum_save_checkpoint() and restored with
+ * peaq_movaccum_restore_checkpoint(). Furthermore, with a log set with
+ * peaq_movaccum_set_log(), all calls to peaq_movaccum_accumulate() and
+ * peaq_movaccum_set_tentative() are recorded, such that they can later be
+ * applied to another accumulator with peaq_movaccum_replay().
+ *
+ * For per-frame inspection, the value accumulated in the current frame is
+ * available from peaq_movaccum_get_frame_value() until the next call of
+ * peaq_movaccum_clear_frame_values().
  */
 
 #include "movaccum.h"
+#include "tracer.h"
 
 #include <math.h>
+#include <string.h>
 
 typedef enum _Status Status;
 typedef struct _Fraction Fraction;
@@ -105,12 +118,17 @@ struct _PeaqMovAccum
   guint channels;
   gpointer *data;
   gpointer *data_saved;
+  GArray *log;
+  PeaqMovAccum *mirror;
+  gdouble *frame_values;
 };
 
 static void class_init (gpointer klass, gpointer class_data);
 static void init (GTypeInstance *obj, gpointer klass);
 static void finalize (GObject *obj);
 static void realloc_data (PeaqMovAccum *acc, guint old_channels);
+static void get_data_sizes (PeaqMovAccum const *acc, gsize *data_size,
+                            gsize *data_saved_size);
 
 GType
 peaq_movaccum_get_type ()
@@ -166,6 +184,9 @@ init (GTypeInstance *obj, gpointer klass)
   acc->channels = 0;
   acc->data = NULL;
   acc->data_saved = NULL;
+  acc->log = NULL;
+  acc->mirror = NULL;
+  acc->frame_values = NULL;
   acc->status = STATUS_INIT;
   acc->mode = MODE_AVG;
   realloc_data (acc, 0);
@@ -184,6 +205,11 @@ finalize (GObject *obj)
 
   g_free (acc->data);
   g_free (acc->data_saved);
+  g_free (acc->frame_values);
+  if (acc->log)
+    g_array_unref (acc->log);
+  if (acc->mirror)
+    g_object_unref (acc->mirror);
 }
 
 /**
@@ -267,8 +293,11 @@ realloc_data (PeaqMovAccum *acc, guint old_channels)
   if (acc->channels != old_channels) {
     g_free (acc->data);
     g_free (acc->data_saved);
+    g_free (acc->frame_values);
     acc->data = g_new0 (gpointer, acc->channels);
     acc->data_saved = g_new0 (gpointer, acc->channels);
+    acc->frame_values = g_new (gdouble, acc->channels);
+    peaq_movaccum_clear_frame_values (acc);
   }
 
   for (c = 0; c < acc->channels; c++)
@@ -316,6 +345,12 @@ realloc_data (PeaqMovAccum *acc, guint old_channels)
 void
 peaq_movaccum_set_tentative (PeaqMovAccum *acc, gboolean tentative)
 {
+  if (acc->log) {
+    gdouble entry[3] = { -1., tentative ? 1. : 0., 0. };
+    g_array_append_vals (acc->log, entry, 3);
+  }
+  if (acc->mirror)
+    peaq_movaccum_set_tentative (acc->mirror, tentative);
   if (tentative) {
     if (acc->status == STATUS_NORMAL) {
       /* transition to tentative status */
@@ -353,6 +388,38 @@ peaq_movaccum_set_tentative (PeaqMovAccum *acc, gboolean tentative)
   }
 }
 
+/**
+ * peaq_movaccum_is_started:
+ * @acc: The #PeaqMovAccum to query.
+ *
+ * Newly created accumulators discard all values passed to
+ * peaq_movaccum_accumulate() until peaq_movaccum_set_tentative() is called
+ * with @tentative set to %FALSE for the first time.
+ *
+ * Returns: Whether accumulated values are taken into account.
+ */
+gboolean
+peaq_movaccum_is_started (PeaqMovAccum const *acc)
+{
+  return acc->status != STATUS_INIT;
+}
+
+/**
+ * peaq_movaccum_reset:
+ * @acc: The #PeaqMovAccum to reset.
+ *
+ * Discards all accumulated values, keeping the mode and the number of
+ * channels. As for a newly created #PeaqMovAccum, values are discarded until
+ * peaq_movaccum_set_tentative() is called with @tentative set to %FALSE.
+ */
+void
+peaq_movaccum_reset (PeaqMovAccum *acc)
+{
+  realloc_data (acc, acc->channels);
+  peaq_movaccum_clear_frame_values (acc);
+  acc->status = STATUS_INIT;
+}
+
 /**
  * peaq_movaccum_accumulate:
  * @acc: The #PeaqMovAccum instance to use for accumulation.
@@ -369,8 +436,17 @@ void
 peaq_movaccum_accumulate (PeaqMovAccum *acc, guint c, gdouble val,
                           gdouble weight)
 {
+  GstClockTime t;
+  if (acc->log) {
+    gdouble entry[3] = { c, val, weight };
+    g_array_append_vals (acc->log, entry, 3);
+  }
+  if (acc->mirror)
+    peaq_movaccum_accumulate (acc->mirror, c, val, weight);
+  acc->frame_values[c] = val;
   if (acc->status == STATUS_INIT)
     return;
+  t = peaq_tracer_begin ();
   switch (acc->mode) {
     case MODE_RMS:
       weight *= weight;
@@ -422,6 +498,7 @@ peaq_movaccum_accumulate (PeaqMovAccum *acc, guint c, gdouble val,
       }
       break;
   }
+  peaq_tracer_end ("accumulate", t);
 }
 
 /**
@@ -479,3 +556,210 @@ peaq_movaccum_get_value (PeaqMovAccum const *acc)
   value /= acc->channels;
   return value;
 }
+
+/**
+ * peaq_movaccum_get_memory_size:
+ * @acc: The #PeaqMovAccum to determine the memory usage of.
+ *
+ * Returns the number of bytes allocated for @acc including the per-channel
+ * accumulation data for the current #PeaqMovAccumMode.
+ *
+ * Returns: The memory used by @acc in bytes.
+ */
+gsize
+peaq_movaccum_get_memory_size (PeaqMovAccum const *acc)
+{
+  gsize data_size;
+  gsize data_saved_size;
+  get_data_sizes (acc, &data_size, &data_saved_size);
+  return sizeof (PeaqMovAccum) +
+    acc->channels * (2 * sizeof (gpointer) + sizeof (gdouble) + data_size +
+                     data_saved_size);
+}
+
+/**
+ * peaq_movaccum_get_checkpoint_size:
+ * @acc: The #PeaqMovAccum to determine the checkpoint size of.
+ *
+ * Returns the number of values written by peaq_movaccum_save_checkpoint() for
+ * the current number of channels and #PeaqMovAccumMode.
+ *
+ * Returns: The number of values in a checkpoint of @acc.
+ */
+gsize
+peaq_movaccum_get_checkpoint_size (PeaqMovAccum const *acc)
+{
+  gsize data_size;
+  gsize data_saved_size;
+  get_data_sizes (acc, &data_size, &data_saved_size);
+  /* the per-channel data only consists of gdoubles */
+  return 1 + acc->channels * (data_size + data_saved_size) / sizeof (gdouble);
+}
+
+/**
+ * peaq_movaccum_save_checkpoint:
+ * @acc: The #PeaqMovAccum to save the state of.
+ * @data: Array of peaq_movaccum_get_checkpoint_size() values to write to.
+ *
+ * Copies the complete accumulator state, including the tentative state and
+ * the value saved when entering it, to @data.
+ */
+void
+peaq_movaccum_save_checkpoint (PeaqMovAccum const *acc, gdouble *data)
+{
+  guint c;
+  gsize data_size;
+  gsize data_saved_size;
+  get_data_sizes (acc, &data_size, &data_saved_size);
+  *data++ = acc->status;
+  for (c = 0; c < acc->channels; c++) {
+    memcpy (data, acc->data[c], data_size);
+    data += data_size / sizeof (gdouble);
+    memcpy (data, acc->data_saved[c], data_saved_size);
+    data += data_saved_size / sizeof (gdouble);
+  }
+}
+
+/**
+ * peaq_movaccum_restore_checkpoint:
+ * @acc: The #PeaqMovAccum to restore the state of.
+ * @data: Array of peaq_movaccum_get_checkpoint_size() values as written by
+ * peaq_movaccum_save_checkpoint().
+ *
+ * Sets the complete accumulator state from @data. The number of channels and
+ * the #PeaqMovAccumMode have to be the same as when saving the checkpoint.
+ */
+void
+peaq_movaccum_restore_checkpoint (PeaqMovAccum *acc, gdouble const *data)
+{
+  guint c;
+  gsize data_size;
+  gsize data_saved_size;
+  get_data_sizes (acc, &data_size, &data_saved_size);
+  acc->status = (Status) *data++;
+  for (c = 0; c < acc->channels; c++) {
+    memcpy (acc->data[c], data, data_size);
+    data += data_size / sizeof (gdouble);
+    memcpy (acc->data_saved[c], data, data_saved_size);
+    data += data_saved_size / sizeof (gdouble);
+  }
+}
+
+/**
+ * peaq_movaccum_set_log:
+ * @acc: The #PeaqMovAccum to log the contributions to.
+ * @log: A #GArray of gdouble to append to or NULL to disable logging.
+ *
+ * Starts (or stops) recording all subsequent calls to
+ * peaq_movaccum_accumulate() and peaq_movaccum_set_tentative() by appending
+ * three values per call to @log: the channel, @val and @weight for
+ * accumulation, or -1 and the tentative flag for changes of the tentative
+ * state. The @acc holds a reference to @log while logging.
+ */
+void
+peaq_movaccum_set_log (PeaqMovAccum *acc, GArray *log)
+{
+  if (log)
+    g_array_ref (log);
+  if (acc->log)
+    g_array_unref (acc->log);
+  acc->log = log;
+}
+
+/**
+ * peaq_movaccum_set_mirror:
+ * @acc: The #PeaqMovAccum whose contributions to forward.
+ * @mirror: A #PeaqMovAccum with the same mode and number of channels or NULL
+ * to stop forwarding.
+ *
+ * Applies all subsequent calls to peaq_movaccum_accumulate() and
+ * peaq_movaccum_set_tentative() on @acc to @mirror as well, e.g. to
+ * accumulate over a shorter time span that can be reset independently with
+ * peaq_movaccum_set_channels(). The @acc holds a reference to @mirror.
+ */
+void
+peaq_movaccum_set_mirror (PeaqMovAccum *acc, PeaqMovAccum *mirror)
+{
+  if (mirror)
+    g_object_ref (mirror);
+  if (acc->mirror)
+    g_object_unref (acc->mirror);
+  acc->mirror = mirror;
+}
+
+/**
+ * peaq_movaccum_replay:
+ * @acc: The #PeaqMovAccum to apply the logged contributions to.
+ * @log: Values as recorded with peaq_movaccum_set_log().
+ * @n_values: Number of values in @log, a multiple of three.
+ *
+ * Applies the calls to peaq_movaccum_accumulate() and
+ * peaq_movaccum_set_tentative() recorded in @log to @acc in the original
+ * order.
+ */
+void
+peaq_movaccum_replay (PeaqMovAccum *acc, gdouble const *log, gsize n_values)
+{
+  gsize i;
+  for (i = 0; i + 3 <= n_values; i += 3) {
+    if (log[i] < 0.)
+      peaq_movaccum_set_tentative (acc, log[i + 1] != 0.);
+    else
+      peaq_movaccum_accumulate (acc, (guint) log[i], log[i + 1], log[i + 2]);
+  }
+}
+
+/**
+ * peaq_movaccum_clear_frame_values:
+ * @acc: The #PeaqMovAccum of which to clear the frame values.
+ *
+ * Resets the values returned by peaq_movaccum_get_frame_value() to NaN,
+ * usually at the start of a frame.
+ */
+void
+peaq_movaccum_clear_frame_values (PeaqMovAccum *acc)
+{
+  guint c;
+  for (c = 0; c < acc->channels; c++)
+    acc->frame_values[c] = NAN;
+}
+
+/**
+ * peaq_movaccum_get_frame_value:
+ * @acc: The #PeaqMovAccum to get the frame value of.
+ * @c: Number of the channel.
+ *
+ * Returns: The @val most recently passed to peaq_movaccum_accumulate() for
+ * channel @c since the last call of peaq_movaccum_clear_frame_values(), or NaN
+ * if there was none, i.e. the contribution of the current frame.
+ */
+gdouble
+peaq_movaccum_get_frame_value (PeaqMovAccum const *acc, guint c)
+{
+  return acc->frame_values[c];
+}
+
+static void
+get_data_sizes (PeaqMovAccum const *acc, gsize *data_size,
+                gsize *data_saved_size)
+{
+  switch (acc->mode) {
+    case MODE_AVG:
+    case MODE_AVG_LOG:
+    case MODE_RMS:
+    case MODE_ADB:
+      *data_size = *data_saved_size = sizeof (Fraction);
+      break;
+    case MODE_RMS_ASYM:
+      *data_size = *data_saved_size = sizeof (TwinFraction);
+      break;
+    case MODE_AVG_WINDOW:
+      *data_size = sizeof (WinAvgData);
+      *data_saved_size = sizeof (Fraction);
+      break;
+    case MODE_FILTERED_MAX:
+    default:
+      *data_size = *data_saved_size = sizeof (FiltMaxData);
+      break;
+  }
+}
@@ -338,8 +338,20 @@ guint peaq_movaccum_get_channels (PeaqMovAccum const *acc);
 void peaq_movaccum_set_mode (PeaqMovAccum *acc, PeaqMovAccumMode mode);
 PeaqMovAccumMode peaq_movaccum_get_mode (PeaqMovAccum *acc);
 void peaq_movaccum_set_tentative (PeaqMovAccum *acc, gboolean tentative);
+gboolean peaq_movaccum_is_started (PeaqMovAccum const *acc);
+void peaq_movaccum_reset (PeaqMovAccum *acc);
 void peaq_movaccum_accumulate (PeaqMovAccum *acc, guint c, gdouble val,
                                gdouble weight);
 gdouble peaq_movaccum_get_value (PeaqMovAccum const *acc);
+gsize peaq_movaccum_get_memory_size (PeaqMovAccum const *acc);
+gsize peaq_movaccum_get_checkpoint_size (PeaqMovAccum const *acc);
+void peaq_movaccum_save_checkpoint (PeaqMovAccum const *acc, gdouble *data);
+void peaq_movaccum_restore_checkpoint (PeaqMovAccum *acc, gdouble const *data);
+void peaq_movaccum_set_log (PeaqMovAccum *acc, GArray *log);
+void peaq_movaccum_set_mirror (PeaqMovAccum *acc, PeaqMovAccum *mirror);
+void peaq_movaccum_replay (PeaqMovAccum *acc, gdouble const *log,
+                           gsize n_values);
+void peaq_movaccum_clear_frame_values (PeaqMovAccum *acc);
+gdouble peaq_movaccum_get_frame_value (PeaqMovAccum const *acc, guint c);
 
 #endif
@@ -1231,16 +1231,19 @@ peaq_mov_prob_detect (PeaqEarModel const *ear_model, const gpointer *ref_state,
   guint band_count = peaq_earmodel_get_band_count (ear_model);
   gdouble binaural_detection_probability = 1.;
   gdouble binaural_detection_steps = 0.;
+  gdouble const **ref_excitation = g_newa (gdouble const *, channels);
+  gdouble const **test_excitation = g_newa (gdouble const *, channels);
+  for (c = 0; c < channels; c++) {
+    ref_excitation[c] = peaq_earmodel_get_excitation (ear_model, ref_state[c]);
+    test_excitation[c] =
+      peaq_earmodel_get_excitation (ear_model, test_state[c]);
+  }
   for (i = 0; i < band_count; i++) {
     gdouble detection_probability = 0.;
     gdouble detection_steps = 0.;
     for (c = 0; c < channels; c++) {
-      gdouble const *ref_excitation =
-        peaq_earmodel_get_excitation (ear_model, ref_state[c]);
-      gdouble const *test_excitation =
-        peaq_earmodel_get_excitation (ear_model, test_state[c]);
-      gdouble eref_db = 10. * log10 (ref_excitation[i]);
-      gdouble etest_db = 10. * log10 (test_excitation[i]);
+      gdouble eref_db = 10. * log10 (ref_excitation[c][i]);
+      gdouble etest_db = 10. * log10 (test_excitation[c][i]);
       /* (73) in [BS1387] */
       gdouble l = 0.3 * MAX (eref_db, etest_db) + 0.7 * etest_db;
       /* (74) in [BS1387] */
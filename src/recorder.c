@@ -0,0 +1,367 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * recorder.c: Recording and reading of input buffer patterns.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:recorder
+ * @short_description: Recording of input buffer patterns.
+ * @title: Recorder
+ *
+ * A #PeaqRecorder logs the caps, buffers, buffer lists, gaps and
+ * end-of-stream events arriving at the ref and test pads of the peaq element
+ * in the order they are received, including buffer sizes, timestamps, flags, the time of
+ * arrival and optionally the sample data. A #PeaqRecordReader reads such a
+ * recording back, e.g. to drive the element with exactly the same pattern
+ * with the replaypeaq tool.
+ *
+ * The file starts with the eight bytes "PEAQREC1", followed by one entry per
+ * #PeaqRecord, consisting of a 48 byte header (kind, pad, two reserved bytes,
+ * flags, arrival, pts, duration, size and data size, all little endian) and
+ * the data. A buffer list is stored as a list entry followed by one entry
+ * per buffer.
+ */
+
+#include "recorder.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#define RECORD_MAGIC "PEAQREC1"
+#define RECORD_HEADER_SIZE 48
+
+struct _PeaqRecorder
+{
+  GMutex mutex;
+  FILE *file;
+  gboolean with_data;
+  GstClockTime start;
+};
+
+struct _PeaqRecordReader
+{
+  FILE *file;
+  guint64 remaining;
+  guint8 *data;
+};
+
+/**
+ * peaq_recorder_new:
+ * @filename: Name of the file to record to.
+ * @with_data: Whether to record the buffer contents.
+ *
+ * Returns: The new #PeaqRecorder or %NULL if @filename could not be opened.
+ */
+PeaqRecorder *
+peaq_recorder_new (gchar const *filename, gboolean with_data)
+{
+  PeaqRecorder *recorder;
+  FILE *file = g_fopen (filename, "wb");
+  if (!file)
+    return NULL;
+  fwrite (RECORD_MAGIC, 1, strlen (RECORD_MAGIC), file);
+  recorder = g_new (PeaqRecorder, 1);
+  g_mutex_init (&recorder->mutex);
+  recorder->file = file;
+  recorder->with_data = with_data;
+  recorder->start = gst_util_get_timestamp ();
+  return recorder;
+}
+
+/**
+ * peaq_recorder_free:
+ * @recorder: The #PeaqRecorder to close and free.
+ */
+void
+peaq_recorder_free (PeaqRecorder *recorder)
+{
+  fclose (recorder->file);
+  g_mutex_clear (&recorder->mutex);
+  g_free (recorder);
+}
+
+/* must be called with the mutex held */
+static void
+write_record_unlocked (PeaqRecorder *recorder, PeaqRecordKind kind, guint pad,
+                       guint flags, GstClockTime pts, GstClockTime duration,
+                       guint64 size, guint8 const *data, gsize data_size)
+{
+  guint8 header[RECORD_HEADER_SIZE];
+  guint64 values[5];
+  guint32 flags_le = GUINT32_TO_LE (flags);
+  guint i;
+
+  memset (header, 0, sizeof (header));
+  header[0] = kind;
+  header[1] = pad;
+  memcpy (header + 4, &flags_le, 4);
+
+  values[0] = gst_util_get_timestamp () - recorder->start;
+  values[1] = pts;
+  values[2] = duration;
+  values[3] = size;
+  values[4] = data_size;
+  for (i = 0; i < 5; i++) {
+    guint64 value_le = GUINT64_TO_LE (values[i]);
+    memcpy (header + 8 + 8 * i, &value_le, 8);
+  }
+  fwrite (header, 1, sizeof (header), recorder->file);
+  if (data_size)
+    fwrite (data, 1, data_size, recorder->file);
+}
+
+static void
+write_record (PeaqRecorder *recorder, PeaqRecordKind kind, guint pad,
+              guint flags, GstClockTime pts, GstClockTime duration,
+              guint64 size, guint8 const *data, gsize data_size)
+{
+  g_mutex_lock (&recorder->mutex);
+  write_record_unlocked (recorder, kind, pad, flags, pts, duration, size,
+                         data, data_size);
+  g_mutex_unlock (&recorder->mutex);
+}
+
+/* must be called with the mutex held */
+static void
+write_buffer_unlocked (PeaqRecorder *recorder, guint pad, GstBuffer *buffer)
+{
+  GstMapInfo map;
+  if (recorder->with_data && gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    write_record_unlocked (recorder, PEAQ_RECORD_BUFFER, pad,
+                           GST_BUFFER_FLAGS (buffer), GST_BUFFER_PTS (buffer),
+                           GST_BUFFER_DURATION (buffer), map.size, map.data,
+                           map.size);
+    gst_buffer_unmap (buffer, &map);
+  } else {
+    write_record_unlocked (recorder, PEAQ_RECORD_BUFFER, pad,
+                           GST_BUFFER_FLAGS (buffer), GST_BUFFER_PTS (buffer),
+                           GST_BUFFER_DURATION (buffer),
+                           gst_buffer_get_size (buffer), NULL, 0);
+  }
+}
+
+/**
+ * peaq_recorder_caps:
+ * @recorder: The #PeaqRecorder to record to.
+ * @pad: 0 for the reference, 1 for the test pad.
+ * @caps: The caps received on @pad.
+ */
+void
+peaq_recorder_caps (PeaqRecorder *recorder, guint pad, GstCaps *caps)
+{
+  gchar *caps_str = gst_caps_to_string (caps);
+  write_record (recorder, PEAQ_RECORD_CAPS, pad, 0, GST_CLOCK_TIME_NONE,
+                GST_CLOCK_TIME_NONE, 0, (guint8 const *) caps_str,
+                strlen (caps_str));
+  g_free (caps_str);
+}
+
+/**
+ * peaq_recorder_buffer:
+ * @recorder: The #PeaqRecorder to record to.
+ * @pad: 0 for the reference, 1 for the test pad.
+ * @buffer: The buffer received on @pad.
+ *
+ * Records size, timestamp, duration and flags of @buffer and, if @recorder
+ * was created with data, its contents.
+ */
+void
+peaq_recorder_buffer (PeaqRecorder *recorder, guint pad, GstBuffer *buffer)
+{
+  g_mutex_lock (&recorder->mutex);
+  write_buffer_unlocked (recorder, pad, buffer);
+  g_mutex_unlock (&recorder->mutex);
+}
+
+/**
+ * peaq_recorder_list:
+ * @recorder: The #PeaqRecorder to record to.
+ * @pad: 0 for the reference, 1 for the test pad.
+ * @list: The buffer list received on @pad.
+ *
+ * Records the start of @list and then each of its buffers like
+ * peaq_recorder_buffer(), without entries of the other pad in between.
+ */
+void
+peaq_recorder_list (PeaqRecorder *recorder, guint pad, GstBufferList *list)
+{
+  guint i;
+  guint length = gst_buffer_list_length (list);
+  g_mutex_lock (&recorder->mutex);
+  write_record_unlocked (recorder, PEAQ_RECORD_LIST, pad, 0,
+                         GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE, length,
+                         NULL, 0);
+  for (i = 0; i < length; i++)
+    write_buffer_unlocked (recorder, pad, gst_buffer_list_get (list, i));
+  g_mutex_unlock (&recorder->mutex);
+}
+
+/**
+ * peaq_recorder_event:
+ * @recorder: The #PeaqRecorder to record to.
+ * @pad: 0 for the reference, 1 for the test pad.
+ * @event: The event received on @pad.
+ *
+ * Records @event if it is a gap or end-of-stream event, others are ignored.
+ */
+void
+peaq_recorder_event (PeaqRecorder *recorder, guint pad, GstEvent *event)
+{
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_GAP:
+      {
+        GstClockTime timestamp, duration;
+        gst_event_parse_gap (event, &timestamp, &duration);
+        write_record (recorder, PEAQ_RECORD_GAP, pad, 0, timestamp, duration,
+                      0, NULL, 0);
+      }
+      break;
+    case GST_EVENT_EOS:
+      write_record (recorder, PEAQ_RECORD_EOS, pad, 0, GST_CLOCK_TIME_NONE,
+                    GST_CLOCK_TIME_NONE, 0, NULL, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * peaq_record_reader_new:
+ * @filename: Name of a file written by a #PeaqRecorder.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Returns: The new #PeaqRecordReader or %NULL if @filename could not be opened
+ * or is not a recording.
+ */
+PeaqRecordReader *
+peaq_record_reader_new (gchar const *filename, GError **error)
+{
+  PeaqRecordReader *reader;
+  gchar magic[8];
+  long length;
+  FILE *file = g_fopen (filename, "rb");
+  if (!file) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "could not open %s", filename);
+    return NULL;
+  }
+  if (fread (magic, 1, sizeof (magic), file) != sizeof (magic) ||
+      memcmp (magic, RECORD_MAGIC, sizeof (magic)) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "%s is not a buffer pattern recording", filename);
+    fclose (file);
+    return NULL;
+  }
+  /* the length bounds the data sizes claimed by the headers */
+  if (fseek (file, 0, SEEK_END) != 0 || (length = ftell (file)) < 0 ||
+      fseek (file, sizeof (magic), SEEK_SET) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "could not determine the length of %s", filename);
+    fclose (file);
+    return NULL;
+  }
+  reader = g_new (PeaqRecordReader, 1);
+  reader->file = file;
+  reader->remaining = length - sizeof (magic);
+  reader->data = NULL;
+  return reader;
+}
+
+/**
+ * peaq_record_reader_next:
+ * @reader: The #PeaqRecordReader to read from.
+ * @record: The #PeaqRecord to fill.
+ * @error: Return location for a #GError or %NULL.
+ *
+ * Reads the next entry. The data pointed to by @record is owned by @reader
+ * and valid until the next call.
+ *
+ * Returns: %TRUE if an entry was read, %FALSE at the end of the recording or
+ * if it is truncated or corrupt, in which case @error is set.
+ */
+gboolean
+peaq_record_reader_next (PeaqRecordReader *reader, PeaqRecord *record,
+                         GError **error)
+{
+  guint8 header[RECORD_HEADER_SIZE];
+  guint64 values[5];
+  guint32 flags_le;
+  guint i;
+
+  if (reader->remaining == 0)
+    return FALSE;
+  if (reader->remaining < sizeof (header) ||
+      fread (header, 1, sizeof (header), reader->file) != sizeof (header)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "truncated record header");
+    return FALSE;
+  }
+  reader->remaining -= sizeof (header);
+  memcpy (&flags_le, header + 4, 4);
+  for (i = 0; i < 5; i++) {
+    guint64 value_le;
+    memcpy (&value_le, header + 8 + 8 * i, 8);
+    values[i] = GUINT64_FROM_LE (value_le);
+  }
+  record->kind = header[0];
+  record->pad = header[1];
+  record->flags = GUINT32_FROM_LE (flags_le);
+  record->arrival = values[0];
+  record->pts = values[1];
+  record->duration = values[2];
+  record->size = values[3];
+  record->data_size = values[4];
+  g_free (reader->data);
+  reader->data = NULL;
+  if (record->data_size > reader->remaining ||
+      (record->kind == PEAQ_RECORD_BUFFER &&
+       record->data_size > record->size)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "invalid data size %" G_GUINT64_FORMAT " in record",
+                 record->data_size);
+    return FALSE;
+  }
+  if (record->data_size) {
+    reader->data = g_malloc (record->data_size + 1);
+    if (fread (reader->data, 1, record->data_size, reader->file) !=
+        record->data_size) {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "truncated record data");
+      return FALSE;
+    }
+    reader->remaining -= record->data_size;
+    /* terminate for convenience with caps strings */
+    reader->data[record->data_size] = '\0';
+  }
+  record->data = reader->data;
+  return TRUE;
+}
+
+/**
+ * peaq_record_reader_free:
+ * @reader: The #PeaqRecordReader to close and free.
+ */
+void
+peaq_record_reader_free (PeaqRecordReader *reader)
+{
+  fclose (reader->file);
+  g_free (reader->data);
+  g_free (reader);
+}
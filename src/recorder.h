@@ -0,0 +1,94 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * recorder.h: Recording and reading of input buffer patterns.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __RECORDER_H__
+#define __RECORDER_H__ 1
+
+#include <gst/gst.h>
+
+typedef struct _PeaqRecorder PeaqRecorder;
+typedef struct _PeaqRecordReader PeaqRecordReader;
+typedef struct _PeaqRecord PeaqRecord;
+typedef enum _PeaqRecordKind PeaqRecordKind;
+
+/**
+ * PeaqRecordKind:
+ * @PEAQ_RECORD_CAPS: Caps event; the data holds the caps as string.
+ * @PEAQ_RECORD_BUFFER: Buffer passed to the chain function; the data holds
+ * the buffer contents if recorded with data.
+ * @PEAQ_RECORD_GAP: Gap event; timestamp and duration are taken from the
+ * event.
+ * @PEAQ_RECORD_EOS: End-of-stream event.
+ * @PEAQ_RECORD_LIST: Buffer list passed to the chain list function; the size
+ * holds the number of buffers, which follow as %PEAQ_RECORD_BUFFER entries.
+ */
+enum _PeaqRecordKind
+{
+  PEAQ_RECORD_CAPS,
+  PEAQ_RECORD_BUFFER,
+  PEAQ_RECORD_GAP,
+  PEAQ_RECORD_EOS,
+  PEAQ_RECORD_LIST
+};
+
+/**
+ * PeaqRecord:
+ * @kind: What was recorded.
+ * @pad: 0 for the reference, 1 for the test pad.
+ * @flags: The #GstBufferFlags of a buffer.
+ * @arrival: Time of arrival in nanoseconds since recording started.
+ * @pts: Presentation timestamp of a buffer or timestamp of a gap.
+ * @duration: Duration of a buffer or gap.
+ * @size: Size of a buffer in bytes or number of buffers in a list.
+ * @data_size: Number of bytes in @data.
+ * @data: Additional data depending on @kind or %NULL.
+ *
+ * One entry of a recording, in the order the element received them.
+ */
+struct _PeaqRecord
+{
+  PeaqRecordKind kind;
+  guint pad;
+  guint flags;
+  GstClockTime arrival;
+  GstClockTime pts;
+  GstClockTime duration;
+  guint64 size;
+  guint64 data_size;
+  guint8 *data;
+};
+
+PeaqRecorder *peaq_recorder_new (gchar const *filename, gboolean with_data);
+void peaq_recorder_free (PeaqRecorder *recorder);
+void peaq_recorder_caps (PeaqRecorder *recorder, guint pad, GstCaps *caps);
+void peaq_recorder_buffer (PeaqRecorder *recorder, guint pad,
+                           GstBuffer *buffer);
+void peaq_recorder_list (PeaqRecorder *recorder, guint pad,
+                         GstBufferList *list);
+void peaq_recorder_event (PeaqRecorder *recorder, guint pad,
+                          GstEvent *event);
+PeaqRecordReader *peaq_record_reader_new (gchar const *filename,
+                                          GError **error);
+gboolean peaq_record_reader_next (PeaqRecordReader *reader,
+                                  PeaqRecord *record, GError **error);
+void peaq_record_reader_free (PeaqRecordReader *reader);
+
+#endif
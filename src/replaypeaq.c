@@ -0,0 +1,304 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * replaypeaq.c: Drive the peaq element with a recorded buffer pattern.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Reads a recording made with the record-file property of the peaq element
+ * and pushes the same sequence of caps, buffers (with identical sizes,
+ * timestamps and flags), gaps and end-of-stream events into the ref and test
+ * pads of a new peaq element from a single thread. Recorded buffer lists are
+ * pushed as lists again. If the recording includes
+ * the sample data, it is used, otherwise the buffers are filled with
+ * deterministic noise. With --paced, the recorded times of arrival are
+ * reproduced, otherwise the pattern is replayed as fast as possible, --loops
+ * times. Afterwards, the processing time and the resulting distortion index
+ * and objective difference grade are printed.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "recorder.h"
+#include "toolutil.h"
+
+static gboolean advanced = FALSE;
+static gboolean paced = FALSE;
+static gint loops = 1;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced,
+   "use advanced version of PEAQ", NULL},
+  {"paced", 0, 0, G_OPTION_ARG_NONE, &paced,
+   "reproduce the recorded times of arrival", NULL},
+  {"loops", 'l', 0, G_OPTION_ARG_INT, &loops,
+   "replay the pattern N times (default: 1)", "N"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static GstBuffer *
+create_buffer (PeaqRecord const *record, guint32 *seed)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, record->size, NULL);
+  if (record->data_size == record->size) {
+    gst_buffer_fill (buffer, 0, record->data, record->size);
+  } else {
+    GstMapInfo map;
+    guint i;
+    gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+    memset (map.data, 0, map.size);
+    for (i = 0; i < map.size / sizeof (gfloat); i++) {
+      *seed = *seed * 1664525 + 1013904223;
+      ((gfloat *) map.data)[i] = (gint32) *seed / 2147483648.f * 0.1f;
+    }
+    gst_buffer_unmap (buffer, &map);
+  }
+  GST_BUFFER_PTS (buffer) = record->pts;
+  GST_BUFFER_DURATION (buffer) = record->duration;
+  GST_BUFFER_FLAGS (buffer) = record->flags;
+  return buffer;
+}
+
+/*
+ * push_list:
+ * @reader: The #PeaqRecordReader positioned after a list entry.
+ * @list_record: The list entry.
+ * @pad: The source pad to push the list to.
+ * @seed: State of the noise for buffers recorded without data.
+ * @ref_bytes: Location to add the number of bytes pushed to the ref pad to.
+ * @error: Return location for a #GError.
+ *
+ * Reads the buffers of a recorded list and pushes them as one list.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+push_list (PeaqRecordReader *reader, PeaqRecord const *list_record,
+           GstPad *pad, guint32 *seed, guint64 *ref_bytes, GError **error)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint64 i, bytes = 0;
+  PeaqRecord record;
+
+  for (i = 0; i < list_record->size; i++) {
+    if (!peaq_record_reader_next (reader, &record, error) ||
+        record.kind != PEAQ_RECORD_BUFFER || record.pad != list_record->pad) {
+      if (!*error)
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                     "incomplete buffer list in recording");
+      gst_buffer_list_unref (list);
+      return FALSE;
+    }
+    gst_buffer_list_add (list, create_buffer (&record, seed));
+    bytes += record.size;
+  }
+  if (gst_pad_push_list (pad, list) != GST_FLOW_OK) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                 "pushing buffer list failed");
+    return FALSE;
+  }
+  if (list_record->pad == 0)
+    *ref_bytes += bytes;
+  return TRUE;
+}
+
+/*
+ * replay:
+ * @filename: Name of the recording.
+ * @pads: The source pads linked to the ref and test pad.
+ * @last: Whether this is the last loop, i.e. end-of-stream is to be sent.
+ * @ref_bytes: Location to add the number of bytes pushed to the ref pad to.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+replay (gchar const *filename, GstPad **pads, gboolean last,
+        guint64 *ref_bytes)
+{
+  GError *error = NULL;
+  PeaqRecord record;
+  guint32 seed = 1;
+  gint64 start = g_get_monotonic_time ();
+  static gboolean started[2] = { FALSE, FALSE };
+  PeaqRecordReader *reader = peaq_record_reader_new (filename, &error);
+
+  if (!reader) {
+    g_printf ("Error: %s\n", error->message);
+    g_error_free (error);
+    return FALSE;
+  }
+
+  while (peaq_record_reader_next (reader, &record, &error)) {
+    GstPad *pad;
+    if (record.pad > 1) {
+      g_printf ("Error: invalid pad in recording\n");
+      peaq_record_reader_free (reader);
+      return FALSE;
+    }
+    pad = pads[record.pad];
+    if (paced) {
+      gint64 delay = start + record.arrival / 1000 - g_get_monotonic_time ();
+      if (delay > 0)
+        g_usleep (delay);
+    }
+    switch (record.kind) {
+      case PEAQ_RECORD_CAPS:
+        {
+          GstCaps *caps = gst_caps_from_string ((gchar const *) record.data);
+          if (!started[record.pad]) {
+            GstSegment segment;
+            gchar *stream_id = gst_pad_get_name (pad);
+            gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+            g_free (stream_id);
+            gst_pad_push_event (pad, gst_event_new_caps (caps));
+            gst_segment_init (&segment, GST_FORMAT_TIME);
+            gst_pad_push_event (pad, gst_event_new_segment (&segment));
+            started[record.pad] = TRUE;
+          } else {
+            gst_pad_push_event (pad, gst_event_new_caps (caps));
+          }
+          gst_caps_unref (caps);
+        }
+        break;
+      case PEAQ_RECORD_BUFFER:
+        if (gst_pad_push (pad, create_buffer (&record, &seed)) !=
+            GST_FLOW_OK) {
+          g_printf ("Error: pushing buffer failed\n");
+          peaq_record_reader_free (reader);
+          return FALSE;
+        }
+        if (record.pad == 0)
+          *ref_bytes += record.size;
+        break;
+      case PEAQ_RECORD_LIST:
+        if (!push_list (reader, &record, pad, &seed, ref_bytes, &error)) {
+          g_printf ("Error: %s\n", error->message);
+          g_error_free (error);
+          peaq_record_reader_free (reader);
+          return FALSE;
+        }
+        break;
+      case PEAQ_RECORD_GAP:
+        gst_pad_push_event (pad, gst_event_new_gap (record.pts,
+                                                    record.duration));
+        break;
+      case PEAQ_RECORD_EOS:
+        if (last)
+          gst_pad_push_event (pad, gst_event_new_eos ());
+        break;
+    }
+  }
+
+  peaq_record_reader_free (reader);
+  if (error) {
+    g_printf ("Error: %s: %s\n", filename, error->message);
+    g_error_free (error);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  GstElement *peaq;
+  GstPad *pads[2];
+  guint64 ref_bytes = 0;
+  gint64 start_time, end_time;
+  gint channels = 0;
+  gdouble di, odg;
+  gboolean ok = TRUE;
+  gint loop;
+
+  context = g_option_context_new ("RECORDING");
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "replaypeaq drives the peaq element with a buffer pattern recorded\n"
+                                "using its record-file property.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (argc != 2) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  peaq = gst_element_factory_make ("peaq", NULL);
+  if (!peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    return 2;
+  }
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "console_output", FALSE, NULL);
+  pads[0] = peaq_toolutil_create_src_pad (peaq, "ref");
+  pads[1] = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+
+  start_time = g_get_monotonic_time ();
+  for (loop = 0; ok && loop < loops; loop++)
+    ok = replay (argv[1], pads, loop == loops - 1, &ref_bytes);
+  end_time = g_get_monotonic_time ();
+
+  if (ok) {
+    GstCaps *caps = gst_pad_get_current_caps (pads[0]);
+    if (caps) {
+      gst_structure_get_int (gst_caps_get_structure (caps, 0), "channels",
+                             &channels);
+      gst_caps_unref (caps);
+    }
+  }
+
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "di", &di, "odg", &odg, NULL);
+
+  if (ok) {
+    gdouble audio_time = channels > 0 ?
+      ref_bytes / (channels * sizeof (gfloat) * 48000.) : 0.;
+    gdouble elapsed = (end_time - start_time) * 1e-6;
+    g_printf ("Processing time: %.3f s\n", elapsed);
+    if (audio_time > 0.)
+      g_printf ("Realtime factor: %.1fx\n", audio_time / elapsed);
+    g_printf ("Distortion Index: %.3f\n", di);
+    g_printf ("Objective Difference Grade: %.3f\n", odg);
+  }
+
+  gst_object_unref (pads[0]);
+  gst_object_unref (pads[1]);
+  gst_object_unref (peaq);
+  gst_deinit ();
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * rescorepeaq.c: Re-evaluate a frame trace without re-running the ear models.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Computes the objective difference grade of each given frame trace, written
+ * by the peaq element with frame-trace-quantities=replay, by setting the
+ * replay-file property of a peaq element and taking it to PAUSED and back to
+ * READY without any input, i.e. running only the pre-processing, the MOV
+ * calculation and the neural network. The result is
+ * the same as that of the run which wrote the trace, so changes to these
+ * stages can be evaluated on a corpus in a fraction of the time.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+static gchar **filenames;
+static gboolean advanced = FALSE;
+static gboolean console_output = FALSE;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced,
+   "the traces were written in advanced mode", NULL},
+  {"basic", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &advanced,
+   "the traces were written in basic mode (default)", NULL},
+  {"verbose", 'v', 0, G_OPTION_ARG_NONE, &console_output,
+   "print the model output variables", NULL},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL,
+   "TRACEFILE..."},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gdouble odg, di;
+  guint i;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "rescorepeaq recomputes the objective difference grade from frame traces\n"
+                                "written with frame-trace-quantities=replay.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (filenames == NULL || filenames[0] == NULL) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  g_printf ("%8s %8s  %s\n", "ODG", "DI", "trace");
+  for (i = 0; filenames[i]; i++) {
+    GstElement *peaq = gst_element_factory_make ("peaq", NULL);
+    if (!peaq) {
+      puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+      exit (2);
+    }
+    gst_object_ref_sink (peaq);
+    g_object_set (peaq, "advanced", advanced,
+                  "console-output", console_output,
+                  "replay-file", filenames[i], NULL);
+    gst_element_set_state (peaq, GST_STATE_PAUSED);
+    gst_element_set_state (peaq, GST_STATE_READY);
+    g_object_get (peaq, "odg", &odg, "di", &di, NULL);
+    gst_element_set_state (peaq, GST_STATE_NULL);
+    g_printf ("%8.3f %8.3f  %s\n", odg, di, filenames[i]);
+    gst_object_unref (peaq);
+  }
+
+  gst_deinit ();
+
+  return 0;
+}
@@ -0,0 +1,470 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * resultsring.c: Shared-memory ring of per-frame results.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:resultsring
+ * @short_description: Shared-memory ring of per-frame results.
+ * @title: Results ring
+ *
+ * A #PeaqResultsRing publishes a fixed number of values per frame (e.g. the
+ * per-frame contributions of the model output variables and the running
+ * objective difference grade) to other processes through a named
+ * shared-memory region (POSIX shared memory, or a named file mapping on
+ * Windows). There is a single writer and any number of readers; readers never
+ * block the writer, and a reader falling behind by more than the number of
+ * slots loses the overwritten entries.
+ *
+ * The region starts with a #PeaqResultsRingHeader, followed by the names of
+ * the values, and then holds #PeaqResultsRingHeader.slot_count slots of
+ * #PeaqResultsRingHeader.slot_size bytes, each a #PeaqResultsRingSlot. All
+ * fields are in host byte order; header size and slot size are multiples of
+ * 64 bytes. Entry n (counting from 0) is written to slot n modulo the slot
+ * count: the writer first sets the slot's seq to 0, then writes the table,
+ * frame and values, then sets seq to n + 1 and finally the head in the header
+ * to n + 1 (all counters modulo 2<superscript>32</superscript>). To read entry
+ * n &lt; head, a reader checks that seq equals n + 1, copies the slot and
+ * checks seq again; if either check fails, the entry has been overwritten in
+ * the meantime. Once the writer has finished, the state in the header is set
+ * to 2 and the name is removed, while readers having the region mapped can
+ * still read the last entries.
+ *
+ * A #PeaqResultsRingReader implements this for C; the watchpeaq tool is an
+ * example of its use.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "resultsring.h"
+
+#include <string.h>
+
+#ifdef G_OS_WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define RING_ALIGNMENT 64
+#define STATE_ACTIVE 1
+#define STATE_FINISHED 2
+
+struct _PeaqResultsRing
+{
+  gchar *name;
+  gpointer handle;
+  guint8 *base;
+  gsize size;
+  PeaqResultsRingHeader *header;
+  guint slot_count;
+  gsize slot_size;
+  guint value_count;
+  guint32 head;
+};
+
+struct _PeaqResultsRingReader
+{
+  gpointer handle;
+  guint8 *base;
+  gsize size;
+  PeaqResultsRingHeader const *header;
+  guint slot_count;
+  gsize slot_size;
+  guint value_count;
+  gchar **names;
+};
+
+static gsize
+align (gsize size)
+{
+  return (size + RING_ALIGNMENT - 1) / RING_ALIGNMENT * RING_ALIGNMENT;
+}
+
+/*
+ * region_name:
+ *
+ * POSIX shared memory names start with a slash, Windows names must not
+ * contain one; accept both forms.
+ */
+static gchar *
+region_name (gchar const *name)
+{
+#ifdef G_OS_WIN32
+  return g_strconcat ("Local\\", name[0] == '/' ? name + 1 : name, NULL);
+#else
+  return name[0] == '/' ? g_strdup (name) : g_strconcat ("/", name, NULL);
+#endif
+}
+
+/*
+ * map_region:
+ * @name: Name as returned by region_name().
+ * @size: Size to create the region with, or 0 to open an existing region
+ * read-only.
+ * @handle: Location to store the handle needed by unmap_region().
+ * @mapped_size: Location to store the size of the mapping.
+ *
+ * Returns: The start of the mapping or %NULL on failure.
+ */
+static guint8 *
+map_region (gchar const *name, gsize size, gpointer *handle,
+            gsize *mapped_size)
+{
+#ifdef G_OS_WIN32
+  HANDLE mapping;
+  guint8 *base;
+  MEMORY_BASIC_INFORMATION info;
+  if (size > 0)
+    mapping = CreateFileMappingA (INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                  (DWORD) ((guint64) size >> 32),
+                                  (DWORD) size, name);
+  else
+    mapping = OpenFileMappingA (FILE_MAP_READ, FALSE, name);
+  if (!mapping)
+    return NULL;
+  base = MapViewOfFile (mapping, size > 0 ? FILE_MAP_ALL_ACCESS :
+                        FILE_MAP_READ, 0, 0, size);
+  if (!base || !VirtualQuery (base, &info, sizeof (info))) {
+    if (base)
+      UnmapViewOfFile (base);
+    CloseHandle (mapping);
+    return NULL;
+  }
+  *handle = mapping;
+  *mapped_size = size > 0 ? size : info.RegionSize;
+  return base;
+#else
+  gboolean create = size > 0;
+  gpointer base;
+  int fd;
+  if (create) {
+    fd = shm_open (name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return NULL;
+    if (ftruncate (fd, size) != 0) {
+      close (fd);
+      shm_unlink (name);
+      return NULL;
+    }
+  } else {
+    struct stat st;
+    fd = shm_open (name, O_RDONLY, 0);
+    if (fd < 0)
+      return NULL;
+    if (fstat (fd, &st) != 0 || st.st_size <= 0) {
+      close (fd);
+      return NULL;
+    }
+    size = st.st_size;
+  }
+  base = mmap (NULL, size, create ? PROT_READ | PROT_WRITE : PROT_READ,
+               MAP_SHARED, fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    return NULL;
+  *handle = NULL;
+  *mapped_size = size;
+  return base;
+#endif
+}
+
+static void
+unmap_region (guint8 *base, gsize size, gpointer handle)
+{
+#ifdef G_OS_WIN32
+  UnmapViewOfFile (base);
+  CloseHandle (handle);
+#else
+  munmap (base, size);
+#endif
+}
+
+/**
+ * peaq_resultsring_new:
+ * @name: Name of the shared-memory region, e.g. "/peaq-results".
+ * @slot_count: Minimum number of slots; rounded up to a power of two.
+ * @value_names: The names of the values, truncated to
+ * #PEAQ_RESULTSRING_NAME_SIZE - 1 characters.
+ * @value_count: Number of values per entry.
+ *
+ * Creates (or replaces) the shared-memory region and initializes the header.
+ *
+ * Returns: The new #PeaqResultsRing or %NULL if the region could not be
+ * created.
+ */
+PeaqResultsRing *
+peaq_resultsring_new (gchar const *name, guint slot_count,
+                      gchar const *const *value_names, guint value_count)
+{
+  PeaqResultsRing *ring = g_new0 (PeaqResultsRing, 1);
+  gsize header_size =
+    align (sizeof (PeaqResultsRingHeader) +
+           value_count * PEAQ_RESULTSRING_NAME_SIZE);
+  guint i;
+
+  ring->slot_count = 1;
+  while (ring->slot_count < slot_count)
+    ring->slot_count *= 2;
+  ring->slot_size =
+    align (sizeof (PeaqResultsRingSlot) + value_count * sizeof (gdouble));
+  ring->value_count = value_count;
+  ring->size = header_size + ring->slot_count * ring->slot_size;
+  ring->name = region_name (name);
+  ring->base = map_region (ring->name, ring->size, &ring->handle,
+                           &ring->size);
+  if (!ring->base) {
+    g_free (ring->name);
+    g_free (ring);
+    return NULL;
+  }
+
+  memset (ring->base, 0, ring->size);
+  ring->header = (PeaqResultsRingHeader *) ring->base;
+  memcpy (ring->header->magic, PEAQ_RESULTSRING_MAGIC, 8);
+  ring->header->header_size = header_size;
+  ring->header->slot_size = ring->slot_size;
+  ring->header->slot_count = ring->slot_count;
+  ring->header->value_count = value_count;
+  for (i = 0; i < value_count; i++)
+    g_strlcpy ((gchar *) ring->base + sizeof (PeaqResultsRingHeader) +
+               i * PEAQ_RESULTSRING_NAME_SIZE, value_names[i],
+               PEAQ_RESULTSRING_NAME_SIZE);
+  g_atomic_int_set (&ring->header->state, STATE_ACTIVE);
+  return ring;
+}
+
+/**
+ * peaq_resultsring_publish:
+ * @ring: The #PeaqResultsRing to write to.
+ * @table: Index of the table the entry belongs to.
+ * @frame: Frame number within the table.
+ * @values: The values to publish.
+ *
+ * Writes the next entry, overwriting the oldest one once all slots are used.
+ * Never blocks.
+ */
+void
+peaq_resultsring_publish (PeaqResultsRing *ring, guint table, guint64 frame,
+                          gdouble const *values)
+{
+  PeaqResultsRingSlot *slot = (PeaqResultsRingSlot *)
+    (ring->base + ring->header->header_size +
+     (ring->head & (ring->slot_count - 1)) * ring->slot_size);
+
+  /* the atomic read-modify-write is a full barrier, so the data written
+   * below cannot become visible before the slot is marked as invalid */
+  g_atomic_int_and ((guint *) &slot->seq, 0);
+  slot->table = table;
+  slot->frame = frame;
+  memcpy (slot->values, values, ring->value_count * sizeof (gdouble));
+  g_atomic_int_set (&slot->seq, (gint) (ring->head + 1));
+  ring->head++;
+  g_atomic_int_set (&ring->header->head, (gint) ring->head);
+}
+
+/**
+ * peaq_resultsring_free:
+ * @ring: The #PeaqResultsRing to close.
+ *
+ * Marks the ring as finished, unmaps it and removes its name. Readers still
+ * having it mapped can continue to read the last entries.
+ */
+void
+peaq_resultsring_free (PeaqResultsRing *ring)
+{
+  g_atomic_int_set (&ring->header->state, STATE_FINISHED);
+  unmap_region (ring->base, ring->size, ring->handle);
+#ifndef G_OS_WIN32
+  shm_unlink (ring->name);
+#endif
+  g_free (ring->name);
+  g_free (ring);
+}
+
+/**
+ * peaq_resultsring_reader_new:
+ * @name: Name of the shared-memory region as given to peaq_resultsring_new().
+ * @error: Location to store an error or %NULL.
+ *
+ * Maps an existing results ring for reading.
+ *
+ * Returns: The new #PeaqResultsRingReader or %NULL if the region does not
+ * exist or is no results ring.
+ */
+PeaqResultsRingReader *
+peaq_resultsring_reader_new (gchar const *name, GError **error)
+{
+  PeaqResultsRingReader *reader = g_new0 (PeaqResultsRingReader, 1);
+  gchar *full_name = region_name (name);
+  PeaqResultsRingHeader const *header;
+  gsize size;
+  guint i;
+
+  reader->base = map_region (full_name, 0, &reader->handle, &size);
+  g_free (full_name);
+  if (!reader->base) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+                 "could not open shared memory %s", name);
+    g_free (reader);
+    return NULL;
+  }
+  reader->size = size;
+  header = reader->header = (PeaqResultsRingHeader const *) reader->base;
+  if (size < sizeof (PeaqResultsRingHeader) ||
+      memcmp (header->magic, PEAQ_RESULTSRING_MAGIC, 8) != 0 ||
+      header->slot_count == 0 ||
+      (header->slot_count & (header->slot_count - 1)) != 0 ||
+      header->slot_size < sizeof (PeaqResultsRingSlot) +
+      header->value_count * sizeof (gdouble) ||
+      header->header_size < sizeof (PeaqResultsRingHeader) +
+      header->value_count * PEAQ_RESULTSRING_NAME_SIZE ||
+      size < header->header_size + (gsize) header->slot_count *
+      header->slot_size) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                 "shared memory %s is no results ring", name);
+    unmap_region (reader->base, reader->size, reader->handle);
+    g_free (reader);
+    return NULL;
+  }
+  reader->slot_count = header->slot_count;
+  reader->slot_size = header->slot_size;
+  reader->value_count = header->value_count;
+  reader->names = g_new0 (gchar *, reader->value_count + 1);
+  for (i = 0; i < reader->value_count; i++)
+    reader->names[i] =
+      g_strndup ((gchar const *) reader->base +
+                 sizeof (PeaqResultsRingHeader) +
+                 i * PEAQ_RESULTSRING_NAME_SIZE, PEAQ_RESULTSRING_NAME_SIZE);
+  return reader;
+}
+
+/**
+ * peaq_resultsring_reader_free:
+ * @reader: The #PeaqResultsRingReader to close.
+ */
+void
+peaq_resultsring_reader_free (PeaqResultsRingReader *reader)
+{
+  unmap_region (reader->base, reader->size, reader->handle);
+  g_strfreev (reader->names);
+  g_free (reader);
+}
+
+/**
+ * peaq_resultsring_reader_get_value_count:
+ * @reader: The #PeaqResultsRingReader.
+ *
+ * Returns: The number of values per entry.
+ */
+guint
+peaq_resultsring_reader_get_value_count (PeaqResultsRingReader const *reader)
+{
+  return reader->value_count;
+}
+
+/**
+ * peaq_resultsring_reader_get_value_name:
+ * @reader: The #PeaqResultsRingReader.
+ * @index: Index of the value.
+ *
+ * Returns: The name of the value.
+ */
+gchar const *
+peaq_resultsring_reader_get_value_name (PeaqResultsRingReader const *reader,
+                                        guint index)
+{
+  return reader->names[index];
+}
+
+/**
+ * peaq_resultsring_reader_get_slot_count:
+ * @reader: The #PeaqResultsRingReader.
+ *
+ * Returns: The number of slots, i.e. how many of the most recent entries can
+ * be read.
+ */
+guint
+peaq_resultsring_reader_get_slot_count (PeaqResultsRingReader const *reader)
+{
+  return reader->slot_count;
+}
+
+/**
+ * peaq_resultsring_reader_get_head:
+ * @reader: The #PeaqResultsRingReader.
+ *
+ * Returns: The number of entries written so far, modulo
+ * 2<superscript>32</superscript>.
+ */
+guint32
+peaq_resultsring_reader_get_head (PeaqResultsRingReader const *reader)
+{
+  return (guint32) g_atomic_int_get (&reader->header->head);
+}
+
+/**
+ * peaq_resultsring_reader_is_finished:
+ * @reader: The #PeaqResultsRingReader.
+ *
+ * Returns: Whether the writer has finished, i.e. no further entries will be
+ * written.
+ */
+gboolean
+peaq_resultsring_reader_is_finished (PeaqResultsRingReader const *reader)
+{
+  return g_atomic_int_get (&reader->header->state) == STATE_FINISHED;
+}
+
+/**
+ * peaq_resultsring_reader_read:
+ * @reader: The #PeaqResultsRingReader.
+ * @entry: Index of the entry to read, less than the head.
+ * @table: Location to store the table index.
+ * @frame: Location to store the frame number.
+ * @values: Array of peaq_resultsring_reader_get_value_count() values to store
+ * the values in.
+ *
+ * Copies the given entry.
+ *
+ * Returns: %TRUE on success, %FALSE if the entry has already been
+ * overwritten (or is just being overwritten), in which case the output is
+ * undefined.
+ */
+gboolean
+peaq_resultsring_reader_read (PeaqResultsRingReader const *reader,
+                              guint32 entry, guint *table, guint64 *frame,
+                              gdouble *values)
+{
+  PeaqResultsRingSlot const *slot = (PeaqResultsRingSlot const *)
+    (reader->base + reader->header->header_size +
+     (entry & (reader->slot_count - 1)) * reader->slot_size);
+  guint32 seq = (guint32) g_atomic_int_get (&slot->seq);
+  if (seq != entry + 1)
+    return FALSE;
+  *table = slot->table;
+  *frame = slot->frame;
+  memcpy (values, slot->values, reader->value_count * sizeof (gdouble));
+  return (guint32) g_atomic_int_get (&slot->seq) == seq;
+}
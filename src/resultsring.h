@@ -0,0 +1,100 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * resultsring.h: Shared-memory ring of per-frame results.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __RESULTSRING_H__
+#define __RESULTSRING_H__ 1
+
+#include <glib.h>
+
+#define PEAQ_RESULTSRING_MAGIC "PEAQRNG1"
+#define PEAQ_RESULTSRING_NAME_SIZE 32
+
+typedef struct _PeaqResultsRing PeaqResultsRing;
+typedef struct _PeaqResultsRingReader PeaqResultsRingReader;
+typedef struct _PeaqResultsRingHeader PeaqResultsRingHeader;
+typedef struct _PeaqResultsRingSlot PeaqResultsRingSlot;
+
+/**
+ * PeaqResultsRingHeader:
+ * @magic: The eight characters "PEAQRNG1".
+ * @header_size: Offset of the first slot in bytes.
+ * @slot_size: Size of each slot in bytes.
+ * @slot_count: Number of slots, a power of two.
+ * @value_count: Number of values per slot.
+ * @state: 1 while the writer is active, 2 once it has finished.
+ * @head: Number of slots written so far (modulo 2<superscript>32</superscript>).
+ *
+ * Layout of the start of the shared-memory region, in host byte order. It is
+ * followed by @value_count names of #PEAQ_RESULTSRING_NAME_SIZE bytes each
+ * (NUL-padded), and the slots start at @header_size.
+ */
+struct _PeaqResultsRingHeader
+{
+  gchar magic[8];
+  guint32 header_size;
+  guint32 slot_size;
+  guint32 slot_count;
+  guint32 value_count;
+  gint32 state;
+  gint32 head;
+  guint8 reserved[32];
+};
+
+/**
+ * PeaqResultsRingSlot:
+ * @seq: One plus the index of the entry held by the slot, or 0 while it is
+ * being written.
+ * @table: Index of the table the entry belongs to (e.g. 0 for FFT and 1 for
+ * filter bank frames).
+ * @frame: Frame number within the table.
+ * @values: The @value_count values.
+ *
+ * Layout of one slot. Entry n is written to slot n modulo @slot_count.
+ */
+struct _PeaqResultsRingSlot
+{
+  gint32 seq;
+  guint32 table;
+  guint64 frame;
+  gdouble values[];
+};
+
+PeaqResultsRing *peaq_resultsring_new (gchar const *name, guint slot_count,
+                                       gchar const *const *value_names,
+                                       guint value_count);
+void peaq_resultsring_publish (PeaqResultsRing *ring, guint table,
+                               guint64 frame, gdouble const *values);
+void peaq_resultsring_free (PeaqResultsRing *ring);
+
+PeaqResultsRingReader *peaq_resultsring_reader_new (gchar const *name,
+                                                    GError **error);
+void peaq_resultsring_reader_free (PeaqResultsRingReader *reader);
+guint peaq_resultsring_reader_get_value_count (PeaqResultsRingReader const *reader);
+gchar const *peaq_resultsring_reader_get_value_name (PeaqResultsRingReader const *reader,
+                                                     guint index);
+guint peaq_resultsring_reader_get_slot_count (PeaqResultsRingReader const *reader);
+guint32 peaq_resultsring_reader_get_head (PeaqResultsRingReader const *reader);
+gboolean peaq_resultsring_reader_is_finished (PeaqResultsRingReader const *reader);
+gboolean peaq_resultsring_reader_read (PeaqResultsRingReader const *reader,
+                                       guint32 entry, guint *table,
+                                       guint64 *frame, gdouble *values);
+
+#endif
@@ -0,0 +1,388 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * screenpeaq.c: Two-pass screening of a reference/test pair.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Evaluates a reference/test pair of WAV files (16, 24 or 32 bit integer or
+ * 32 bit float at 48 kHz) in two passes:
+ *
+ *  1. The whole item is run through a peaq element with screening enabled,
+ *     which only computes the per-frame NMR and detection probability and
+ *     flags the regions where they exceed --nmr-threshold and --pd-threshold.
+ *  2. The flagged regions and, as a control, randomly placed regions of
+ *     --control-length seconds covering about --control-fraction of the item
+ *     are each evaluated with a fresh peaq element in the basic or (with
+ *     --advanced) advanced version, starting --warm-up seconds early so the
+ *     ear model has settled. The warm-up is excluded from the resulting
+ *     grades with the score-start property.
+ *
+ * The report lists the grades of all regions and states the coverage, i.e.
+ * the fraction of the item that has been fully analysed, and the time spent
+ * in each pass.
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "toolutil.h"
+
+#define SAMPLING_RATE 48000
+#define BLOCK_FRAMES 4800
+
+typedef struct _Region Region;
+
+struct _Region
+{
+  guint64 start;
+  guint64 end;
+  gboolean control;
+  gdouble max_nmr;
+  gdouble max_pd;
+  gdouble odg;
+  gdouble di;
+};
+
+static gchar **filenames;
+static gboolean advanced = FALSE;
+static gdouble nmr_threshold = 0.;
+static gdouble pd_threshold = 0.5;
+static gdouble warm_up = 1.;
+static gdouble control_fraction = 0.05;
+static gdouble control_length = 2.;
+static gint seed = 1;
+
+static GOptionEntry option_entries[] = {
+  {"advanced", 0, 0, G_OPTION_ARG_NONE, &advanced,
+   "use advanced version for the second pass", NULL},
+  {"nmr-threshold", 0, 0, G_OPTION_ARG_DOUBLE, &nmr_threshold,
+   "per-frame NMR flagging a frame (default: 0)", "DB"},
+  {"pd-threshold", 0, 0, G_OPTION_ARG_DOUBLE, &pd_threshold,
+   "per-frame detection probability flagging a frame (default: 0.5)", "P"},
+  {"warm-up", 0, 0, G_OPTION_ARG_DOUBLE, &warm_up,
+   "audio analysed before each region (default: 1)", "SECONDS"},
+  {"control-fraction", 0, 0, G_OPTION_ARG_DOUBLE, &control_fraction,
+   "fraction of the item to analyse as control sample (default: 0.05)",
+   "FRACTION"},
+  {"control-length", 0, 0, G_OPTION_ARG_DOUBLE, &control_length,
+   "length of each control region (default: 2)", "SECONDS"},
+  {"seed", 0, 0, G_OPTION_ARG_INT, &seed,
+   "seed for the placement of the control regions (default: 1)", "N"},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL,
+   "REFFILE TESTFILE"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+/*
+ * analyse:
+ * @ref: Interleaved reference samples.
+ * @test: Interleaved test samples.
+ * @channels: Number of channels.
+ * @start: First frame to analyse.
+ * @score_start: First frame to contribute to the grades, the frames from
+ * @start on only serve as warm-up.
+ * @end: Frame after the last one to analyse.
+ * @screening: Whether to run the screening pass.
+ * @odg: Location to store the objective difference grade.
+ * @di: Location to store the distortion index.
+ * @flagged: #GArray of #Region to append the flagged regions to in screening
+ * mode or %NULL.
+ *
+ * Runs frames @start to @end through a new peaq element.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+analyse (gfloat const *ref, gfloat const *test, guint channels,
+         guint64 start, guint64 score_start, guint64 end, gboolean screening,
+         gdouble *odg, gdouble *di, GArray *flagged)
+{
+  gboolean ok = TRUE;
+  GstElement *peaq;
+  GstBus *bus;
+  GstMessage *message;
+  GstPad *ref_src, *test_src;
+  guint64 position;
+
+  peaq = gst_element_factory_make ("peaq", NULL);
+  if (!peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    exit (2);
+  }
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", screening ? FALSE : advanced,
+                "screening", screening, "screen-nmr-threshold", nmr_threshold,
+                "screen-pd-threshold", pd_threshold,
+                "score-start", score_start - start,
+                "console_output", FALSE, NULL);
+  bus = gst_bus_new ();
+  gst_element_set_bus (peaq, bus);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, channels);
+  peaq_toolutil_start_stream (test_src, channels);
+
+  for (position = start; ok && position < end; position += BLOCK_FRAMES) {
+    gsize size = MIN (BLOCK_FRAMES, end - position) * channels *
+      sizeof (gfloat);
+    if (peaq_toolutil_push_block (ref_src, ref + position * channels,
+                                  size) != GST_FLOW_OK ||
+        peaq_toolutil_push_block (test_src, test + position * channels,
+                                  size) != GST_FLOW_OK) {
+      puts ("Error: pushing data failed");
+      ok = FALSE;
+    }
+  }
+
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "odg", odg, "di", di, NULL);
+
+  while ((message = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT))) {
+    GstStructure const *s = gst_message_get_structure (message);
+    if (flagged && gst_structure_has_name (s, "peaq-flagged-region")) {
+      Region region = { 0 };
+      gst_structure_get_uint64 (s, "start", &region.start);
+      gst_structure_get_uint64 (s, "end", &region.end);
+      gst_structure_get_double (s, "max-nmr", &region.max_nmr);
+      gst_structure_get_double (s, "max-pd", &region.max_pd);
+      region.start += start;
+      region.end = MIN (region.end + start, end);
+      g_array_append_val (flagged, region);
+    }
+    gst_message_unref (message);
+  }
+
+  gst_element_set_bus (peaq, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+
+  return ok;
+}
+
+static gint
+compare_regions (gconstpointer a, gconstpointer b)
+{
+  guint64 start_a = ((Region const *) a)->start;
+  guint64 start_b = ((Region const *) b)->start;
+  return start_a < start_b ? -1 : start_a > start_b;
+}
+
+/*
+ * merge_regions:
+ * @regions: #GArray of #Region sorted by their start.
+ * @gap: Distance up to which regions are merged.
+ *
+ * Merges flagged regions less than @gap frames apart, as their warm-up would
+ * overlap the preceding region anyway.
+ */
+static void
+merge_regions (GArray *regions, guint64 gap)
+{
+  guint i, j;
+  for (i = 0, j = 1; j < regions->len; j++) {
+    Region *prev = &g_array_index (regions, Region, i);
+    Region *next = &g_array_index (regions, Region, j);
+    if (next->start <= prev->end + gap) {
+      prev->end = MAX (prev->end, next->end);
+      prev->max_nmr = MAX (prev->max_nmr, next->max_nmr);
+      prev->max_pd = MAX (prev->max_pd, next->max_pd);
+    } else {
+      g_array_index (regions, Region, ++i) = *next;
+    }
+  }
+  if (regions->len > 0)
+    g_array_set_size (regions, i + 1);
+}
+
+/*
+ * add_control_regions:
+ * @regions: #GArray of #Region, sorted by their start.
+ * @frames: Length of the item.
+ * @gap: Minimum distance to other regions.
+ *
+ * Randomly places control regions not overlapping any other region (including
+ * its warm-up) until they cover --control-fraction of @frames or no more space
+ * is found, and sorts @regions again.
+ */
+static void
+add_control_regions (GArray *regions, guint64 frames, guint64 gap)
+{
+  GRand *rand = g_rand_new_with_seed (seed);
+  guint64 length = MIN (control_length * SAMPLING_RATE, frames);
+  guint64 target = control_fraction * frames;
+  guint64 covered = 0;
+  guint attempts;
+
+  for (attempts = 0; covered < target && attempts < 1000 && length > 0;
+       attempts++) {
+    Region region = { 0 };
+    guint i;
+    region.start = g_rand_double (rand) * (frames - length + 1);
+    region.end = region.start + length;
+    region.control = TRUE;
+    for (i = 0; i < regions->len; i++) {
+      Region *other = &g_array_index (regions, Region, i);
+      if (region.start < other->end + gap && other->start < region.end + gap)
+        break;
+    }
+    if (i == regions->len) {
+      g_array_append_val (regions, region);
+      covered += length;
+    }
+  }
+  g_array_sort (regions, compare_regions);
+  g_rand_free (rand);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gfloat *ref, *test;
+  guint ref_channels, test_channels;
+  gsize ref_frames, test_frames;
+  guint64 frames, warm_up_frames;
+  guint64 flagged_frames = 0, control_frames = 0, analysed_frames = 0;
+  gdouble odg, di;
+  gdouble screening_time, full_time;
+  gdouble worst_odg = 0., worst_control_odg = 0.;
+  gint64 t;
+  GArray *regions;
+  guint i;
+  gboolean ok = TRUE;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "screenpeaq flags suspicious regions of an item with a cheap screening pass\n"
+                                "and fully analyses only these and a random control sample.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (filenames == NULL || filenames[0] == NULL || filenames[1] == NULL
+      || filenames[2] != NULL) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (warm_up < 0. || control_fraction < 0. || control_fraction > 1. ||
+      control_length <= 0.) {
+    g_printf ("Error: invalid warm-up or control sample settings\n");
+    return 1;
+  }
+
+  ref = peaq_toolutil_read_wav (filenames[0], &ref_channels, &ref_frames);
+  test = peaq_toolutil_read_wav (filenames[1], &test_channels, &test_frames);
+  if (!ref || !test)
+    return 1;
+  if (ref_channels != test_channels || ref_channels > 2) {
+    g_printf ("Error: reference and test must both be mono or stereo\n");
+    return 1;
+  }
+  frames = MIN (ref_frames, test_frames);
+  warm_up_frames = warm_up * SAMPLING_RATE;
+
+  /* first pass */
+  regions = g_array_new (FALSE, FALSE, sizeof (Region));
+  t = g_get_monotonic_time ();
+  ok &= analyse (ref, test, ref_channels, 0, 0, frames, TRUE, &odg, &di,
+                 regions);
+  screening_time = (g_get_monotonic_time () - t) * 1e-6;
+  merge_regions (regions, warm_up_frames);
+  for (i = 0; i < regions->len; i++)
+    flagged_frames += g_array_index (regions, Region, i).end -
+      g_array_index (regions, Region, i).start;
+  add_control_regions (regions, frames, warm_up_frames);
+
+  /* second pass */
+  g_printf ("%-8s %10s %10s %9s %6s %8s %8s\n", "region", "start [s]",
+            "end [s]", "NMR [dB]", "PD", "ODG", "DI");
+  t = g_get_monotonic_time ();
+  for (i = 0; i < regions->len; i++) {
+    Region *region = &g_array_index (regions, Region, i);
+    guint64 start = region->start > warm_up_frames ?
+      region->start - warm_up_frames : 0;
+    ok &= analyse (ref, test, ref_channels, start, region->start,
+                   region->end, FALSE, &region->odg, &region->di, NULL);
+    analysed_frames += region->end - start;
+    if (region->control) {
+      control_frames += region->end - region->start;
+      worst_control_odg = MIN (worst_control_odg, region->odg);
+      g_printf ("%-8s %10.3f %10.3f %9s %6s %8.3f %8.3f\n", "control",
+                (gdouble) region->start / SAMPLING_RATE,
+                (gdouble) region->end / SAMPLING_RATE, "", "",
+                region->odg, region->di);
+    } else {
+      worst_odg = MIN (worst_odg, region->odg);
+      g_printf ("%-8s %10.3f %10.3f %9.2f %6.3f %8.3f %8.3f\n", "flagged",
+                (gdouble) region->start / SAMPLING_RATE,
+                (gdouble) region->end / SAMPLING_RATE, region->max_nmr,
+                region->max_pd, region->odg, region->di);
+    }
+  }
+  full_time = (g_get_monotonic_time () - t) * 1e-6;
+
+  g_printf ("\nItem length:       %10.3f s\n", (gdouble) frames / SAMPLING_RATE);
+  g_printf ("Screening pass:    %10.3f s processing time (%.1fx realtime)\n",
+            screening_time,
+            frames / (gdouble) SAMPLING_RATE / MAX (screening_time, 1e-6));
+  g_printf ("Full %-8s pass: %10.3f s processing time for %.3f s of audio"
+            " including warm-up\n", advanced ? "advanced" : "basic",
+            full_time, (gdouble) analysed_frames / SAMPLING_RATE);
+  g_printf ("Flagged regions:   %10.3f s (%.1f%%)\n",
+            (gdouble) flagged_frames / SAMPLING_RATE,
+            frames ? 100. * flagged_frames / frames : 0.);
+  g_printf ("Control regions:   %10.3f s (%.1f%%)\n",
+            (gdouble) control_frames / SAMPLING_RATE,
+            frames ? 100. * control_frames / frames : 0.);
+  g_printf ("Coverage:          %10.1f%% of the item fully analysed\n",
+            frames ? 100. * (flagged_frames + control_frames) / frames : 0.);
+  g_printf ("Worst ODG:         %10.3f (flagged), %.3f (control)\n",
+            worst_odg, worst_control_odg);
+  if (worst_control_odg < worst_odg)
+    g_printf ("Warning: a control region scored worse than all flagged regions;"
+              " the thresholds may be too high\n");
+
+  g_array_free (regions, TRUE);
+  g_free (ref);
+  g_free (test);
+
+  gst_deinit ();
+
+  return ok ? 0 : 1;
+}
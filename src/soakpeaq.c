@@ -0,0 +1,287 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * soakpeaq.c: Long-duration soak test for the peaq element.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Pushes --hours of generated audio, cycling through full-scale noise,
+ * silence, transients and silence again, as fast as possible into the ref and
+ * test pads of a peaq element, first in basic, then in advanced mode. Every
+ * --interval minutes (of audio), the throughput, the resident set size of the
+ * process, the data buffered in the element's adapters and the current
+ * distortion index are reported. The test fails if
+ *
+ *  - the throughput of an interval drops by more than --max-slowdown compared
+ *    to the first interval (e.g. due to denormals after the silent parts),
+ *  - the resident set size grows by more than --max-rss-growth kB after the
+ *    first interval,
+ *  - the data buffered in the adapters exceeds MAX_ADAPTER_BYTES, or
+ *  - the distortion index stops being finite.
+ *
+ * Run with "make soak".
+ */
+
+#include <gst/gst.h>
+#include <glib/gprintf.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "toolutil.h"
+
+#define SAMPLING_RATE 48000
+#define BLOCK_FRAMES 4800
+#define SEGMENT_SECONDS 10
+#define MAX_ADAPTER_BYTES (1 << 20)
+
+typedef enum _SegmentType SegmentType;
+
+enum _SegmentType
+{
+  SEGMENT_NOISE,
+  SEGMENT_SILENCE,
+  SEGMENT_TRANSIENTS
+};
+
+static const SegmentType schedule[] = {
+  SEGMENT_NOISE, SEGMENT_SILENCE, SEGMENT_TRANSIENTS, SEGMENT_SILENCE
+};
+
+static gdouble hours = 2.;
+static gdouble interval = 10.;
+static gint channels = 2;
+static gdouble max_slowdown = 0.3;
+static gint max_rss_growth = 4096;
+
+static GOptionEntry option_entries[] = {
+  {"hours", 0, 0, G_OPTION_ARG_DOUBLE, &hours,
+   "hours of audio to process per mode (default: 2)", "HOURS"},
+  {"interval", 0, 0, G_OPTION_ARG_DOUBLE, &interval,
+   "report every MINUTES of audio (default: 10)", "MINUTES"},
+  {"channels", 'c', 0, G_OPTION_ARG_INT, &channels,
+   "number of channels (default: 2)", "N"},
+  {"max-slowdown", 0, 0, G_OPTION_ARG_DOUBLE, &max_slowdown,
+   "allowed relative throughput drop (default: 0.3)", "FRACTION"},
+  {"max-rss-growth", 0, 0, G_OPTION_ARG_INT, &max_rss_growth,
+   "allowed growth of the resident set size (default: 4096)", "KB"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static guint64
+get_rss (void)
+{
+  guint64 rss = 0;
+#ifdef G_OS_UNIX
+  gchar *contents;
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL)) {
+    gchar **fields = g_strsplit (contents, " ", 3);
+    if (fields[0] && fields[1])
+      rss = g_ascii_strtoull (fields[1], NULL, 10) * sysconf (_SC_PAGESIZE);
+    g_strfreev (fields);
+    g_free (contents);
+  }
+#endif
+  return rss;
+}
+
+static inline gfloat
+next_random (guint32 *seed)
+{
+  *seed = *seed * 1664525 + 1013904223;
+  return (gint32) *seed / 2147483648.f;
+}
+
+static void
+generate_block (guint64 position, guint32 *seed, gfloat *ref, gfloat *test)
+{
+  guint i, c;
+  for (i = 0; i < BLOCK_FRAMES; i++) {
+    guint64 n = position + i;
+    SegmentType type =
+      schedule[(n / (SEGMENT_SECONDS * SAMPLING_RATE)) %
+               G_N_ELEMENTS (schedule)];
+    for (c = 0; c < channels; c++) {
+      gfloat x;
+      switch (type) {
+        case SEGMENT_NOISE:
+          x = next_random (seed);
+          break;
+        case SEGMENT_TRANSIENTS:
+          /* decaying clicks every 100ms */
+          x = exp (-(gdouble) (n % (SAMPLING_RATE / 10)) / 100.) *
+            next_random (seed);
+          break;
+        case SEGMENT_SILENCE:
+        default:
+          x = 0.f;
+          break;
+      }
+      ref[i * channels + c] = x;
+      /* quantization to 8 bit as the impairment */
+      test[i * channels + c] = floorf (x * 128.f + 0.5f) / 128.f;
+    }
+  }
+}
+
+static gboolean
+soak (gboolean advanced)
+{
+  gboolean ok = TRUE;
+  guint32 seed = 1;
+  guint64 position = 0;
+  guint64 total_frames = hours * 3600 * SAMPLING_RATE;
+  guint64 interval_frames = interval * 60 * SAMPLING_RATE;
+  guint64 next_report = interval_frames;
+  gdouble first_realtime_factor = 0.;
+  guint64 first_rss = 0;
+  gfloat *ref = g_new (gfloat, BLOCK_FRAMES * channels);
+  gfloat *test = g_new (gfloat, BLOCK_FRAMES * channels);
+  gsize size = BLOCK_FRAMES * channels * sizeof (gfloat);
+  GstElement *peaq;
+  GstPad *ref_src, *test_src;
+  gint64 interval_start;
+
+  peaq = gst_element_factory_make ("peaq", NULL);
+  if (!peaq) {
+    puts ("Error: peaq element could not be instantiated - is the plugin installed correctly?");
+    exit (2);
+  }
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "console_output", FALSE, NULL);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, channels);
+  peaq_toolutil_start_stream (test_src, channels);
+
+  g_printf ("%-9s %10s %10s %12s %10s %10s\n", "mode", "audio",
+            "realtime", "rss [kB]", "adapters", "DI");
+
+  interval_start = g_get_monotonic_time ();
+  while (ok && position < total_frames) {
+    generate_block (position, &seed, ref, test);
+    if (peaq_toolutil_push_block (ref_src, ref, size) != GST_FLOW_OK ||
+        peaq_toolutil_push_block (test_src, test, size) != GST_FLOW_OK) {
+      puts ("Error: pushing data failed");
+      ok = FALSE;
+      break;
+    }
+    position += BLOCK_FRAMES;
+
+    if (position >= next_report || position >= total_frames) {
+      gint64 now = g_get_monotonic_time ();
+      gdouble realtime_factor =
+        (gdouble) (position - (next_report - interval_frames)) /
+        SAMPLING_RATE / ((now - interval_start) * 1e-6);
+      guint64 rss = get_rss ();
+      guint64 adapters;
+      gdouble di;
+      GstStructure *memory;
+      guint seconds = position / SAMPLING_RATE;
+
+      g_object_get (peaq, "memory", &memory, "di", &di, NULL);
+      gst_structure_get_uint64 (memory, "adapters", &adapters);
+      gst_structure_free (memory);
+
+      g_printf ("%-9s %4u:%02u:%02u %9.1fx %12.0f %10" G_GUINT64_FORMAT
+                " %10.3f\n", advanced ? "advanced" : "basic",
+                seconds / 3600, seconds / 60 % 60, seconds % 60,
+                realtime_factor, rss / 1024., adapters, di);
+
+      if (first_realtime_factor == 0.) {
+        first_realtime_factor = realtime_factor;
+        first_rss = rss;
+      } else {
+        if (realtime_factor < (1. - max_slowdown) * first_realtime_factor) {
+          g_printf ("FAILED: throughput dropped from %.1fx to %.1fx\n",
+                    first_realtime_factor, realtime_factor);
+          ok = FALSE;
+        }
+        if (rss > first_rss + (guint64) max_rss_growth * 1024) {
+          g_printf ("FAILED: resident set size grew by %.0f kB\n",
+                    (rss - first_rss) / 1024.);
+          ok = FALSE;
+        }
+      }
+      if (adapters > MAX_ADAPTER_BYTES) {
+        g_printf ("FAILED: %" G_GUINT64_FORMAT " bytes buffered in adapters\n",
+                  adapters);
+        ok = FALSE;
+      }
+      if (!isfinite (di)) {
+        g_printf ("FAILED: distortion index is %f\n", di);
+        ok = FALSE;
+      }
+
+      next_report += interval_frames;
+      interval_start = g_get_monotonic_time ();
+    }
+  }
+
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+  g_free (ref);
+  g_free (test);
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  gboolean ok;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  g_option_context_set_summary (context,
+                                "soakpeaq checks the peaq element for throughput degradation, memory\n"
+                                "growth and numerical problems over long durations.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (channels < 1 || interval <= 0.) {
+    g_printf ("Error: invalid channel count or interval\n");
+    return 1;
+  }
+
+  ok = soak (FALSE);
+  ok &= soak (TRUE);
+
+  gst_deinit ();
+
+  return ok ? 0 : 1;
+}
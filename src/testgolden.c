@@ -0,0 +1,721 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * testgolden.c: Golden-output differential test for GstPEAQ.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Feeds a number of generated reference/test signal pairs through a GstPeaq
+ * element, in basic and advanced mode, as mono and as stereo items, and
+ * records from its frame trace the per-frame MOV values and a per-frame
+ * checksum (the sum over the row) of each processing stage (power spectra,
+ * the output of the frequency domain spreading, excitation patterns,
+ * modulation), from its results ring the running distortion index after each
+ * frame of the basic version, and the final results. The resulting trace is
+ * then compared against:
+ *
+ *  - the traces obtained with every entry of variants[], using the
+ *    per-quantity tolerances given in tolerances[]; the variants feed the
+ *    same data in different ways, and an alternative implementation of any of
+ *    the processing stages is added to this test by adding an entry to
+ *    variants[] that selects it,
+ *  - optionally, a golden trace previously written with --record by a
+ *    reference build, given as argument.
+ *
+ * "make check" runs this via checkgolden.sh against golden.trace.gz, which was
+ * recorded from a build that still matched the per-stage outputs of the
+ * processing as it was before the optimization series. It must only be
+ * re-recorded ("make golden-record") for intended changes of the output.
+ */
+
+#include "frametrace.h"
+#include "gstpeaq.h"
+#include "resultsring.h"
+#include "toolutil.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+
+#define SAMPLING_RATE 48000
+/* long enough for the advanced version to compute all MOVs (the filter bank
+ * modulation difference starts at frame 125) */
+#define SIGNAL_LENGTH 36000
+
+typedef enum _GoldenQuantity GoldenQuantity;
+typedef struct _GoldenTolerance GoldenTolerance;
+typedef struct _GoldenSection GoldenSection;
+typedef struct _GoldenSignal GoldenSignal;
+typedef struct _GoldenVariant GoldenVariant;
+
+/* the stage quantities come first, in the order of tolerances[], whose names
+ * are those used by #GstPeaq:frame-trace-quantities */
+enum _GoldenQuantity
+{
+  QUANTITY_POWER_SPECTRUM,
+  QUANTITY_WEIGHTED_POWER_SPECTRUM,
+  QUANTITY_UNSMEARED_EXCITATION,
+  QUANTITY_EXCITATION,
+  QUANTITY_MODULATION,
+  QUANTITY_MOVS,
+  QUANTITY_DI,
+  COUNT_QUANTITIES
+};
+
+struct _GoldenTolerance
+{
+  const gchar *name;
+  gdouble reldelta;
+  gdouble delta;
+};
+
+/* a value is accepted if either the relative or the absolute error is within
+ * tolerance; the later stages get more slack as errors accumulate */
+static const GoldenTolerance tolerances[COUNT_QUANTITIES] = {
+  {"power-spectrum", 1e-6, 1e-9},
+  {"weighted-power-spectrum", 1e-6, 1e-9},
+  {"unsmeared-excitation", 1e-6, 1e-9},
+  {"excitation", 1e-6, 1e-9},
+  {"modulation", 1e-5, 1e-8},
+  {"movs", 1e-4, 1e-6},
+  {"di", 0., 5e-4}
+};
+
+struct _GoldenSection
+{
+  gchar *name;
+  GoldenQuantity quantity;
+  guint width;
+  GArray *values;
+};
+
+struct _GoldenSignal
+{
+  const gchar *name;
+  void (*generate) (gfloat *ref, gfloat *test, guint length);
+};
+
+/*
+ * GoldenVariant:
+ * @name: Name to report mismatches with.
+ * @block_size: Number of samples (per channel) pushed at once.
+ * @list_size: If non-zero, each block is pushed as a buffer list of buffers
+ * with this many samples (per channel).
+ * @setup: Function to select the implementation to check on the freshly
+ * created element, or NULL to use the defaults.
+ */
+struct _GoldenVariant
+{
+  const gchar *name;
+  guint block_size;
+  guint list_size;
+  void (*setup) (GstElement *peaq);
+};
+
+static void generate_sine (gfloat *ref, gfloat *test, guint length);
+static void generate_noise (gfloat *ref, gfloat *test, guint length);
+static void generate_transient (gfloat *ref, gfloat *test, guint length);
+static void generate_sweep (gfloat *ref, gfloat *test, guint length);
+
+static const GoldenSignal signals[] = {
+  {"sine", generate_sine},
+  {"noise", generate_noise},
+  {"transient", generate_transient},
+  {"sweep", generate_sweep}
+};
+
+static const GoldenVariant reference_variant = {"current", 4800, 0, NULL};
+
+/* "rerun" uses new instances and thus checks that no state leaks between
+ * instances, the others check that the results do not depend on how the data
+ * is split into buffers */
+static const GoldenVariant variants[] = {
+  {"rerun", 4800, 0, NULL},
+  {"small-buffers", 100, 0, NULL},
+  {"buffer-lists", 4800, 100, NULL}
+};
+
+static gchar *record_filename = NULL;
+static gchar **filenames = NULL;
+
+static GOptionEntry option_entries[] = {
+  {"record", 0, 0, G_OPTION_ARG_FILENAME, &record_filename,
+   "write the golden trace to FILE instead of checking", "FILE"},
+  {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL,
+   "[GOLDENFILE]"},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+static GoldenSection *
+section_new (GPtrArray *trace, gchar const *item, gchar const *name,
+             GoldenQuantity quantity, guint width)
+{
+  GoldenSection *section = g_new (GoldenSection, 1);
+  section->name = g_strdup_printf ("%s/%s", item, name);
+  section->quantity = quantity;
+  section->width = width;
+  section->values = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  g_ptr_array_add (trace, section);
+  return section;
+}
+
+static void
+section_free (gpointer data)
+{
+  GoldenSection *section = data;
+  g_free (section->name);
+  g_array_free (section->values, TRUE);
+  g_free (section);
+}
+
+static void
+section_record (GoldenSection *section, gdouble const *values)
+{
+  g_array_append_vals (section->values, values, section->width);
+}
+
+static void
+generate_sine (gfloat *ref, gfloat *test, guint length)
+{
+  guint i;
+  GRand *rand = g_rand_new_with_seed (1);
+  for (i = 0; i < length; i++) {
+    ref[i] = 0.5 * sin (2 * M_PI * 1019.5 / SAMPLING_RATE * i);
+    test[i] = ref[i] + 1e-3 * g_rand_double_range (rand, -1., 1.);
+  }
+  g_rand_free (rand);
+}
+
+static void
+generate_noise (gfloat *ref, gfloat *test, guint length)
+{
+  guint i;
+  GRand *rand = g_rand_new_with_seed (2);
+  for (i = 0; i < length; i++) {
+    ref[i] = 0.3 * g_rand_double_range (rand, -1., 1.);
+    /* quantization to 8 bit */
+    test[i] = floor (ref[i] * 128. + 0.5) / 128.;
+  }
+  g_rand_free (rand);
+}
+
+static void
+generate_transient (gfloat *ref, gfloat *test, guint length)
+{
+  guint i;
+  gdouble lp_state = 0.;
+  GRand *rand = g_rand_new_with_seed (3);
+  for (i = 0; i < length; i++) {
+    /* a quarter second of silence, then decaying noise bursts */
+    if (i < SAMPLING_RATE / 4)
+      ref[i] = 0.;
+    else
+      ref[i] = 0.8 * exp (-(gdouble) (i % 4800) / 200.) *
+        g_rand_double_range (rand, -1., 1.);
+    /* low-pass filtering smears the attacks */
+    lp_state = 0.7 * lp_state + 0.3 * ref[i];
+    test[i] = lp_state;
+  }
+  g_rand_free (rand);
+}
+
+static void
+generate_sweep (gfloat *ref, gfloat *test, guint length)
+{
+  guint i;
+  gdouble f0 = 50.;
+  gdouble f1 = 18000.;
+  for (i = 0; i < length; i++) {
+    gdouble t = (gdouble) i / SAMPLING_RATE;
+    gdouble T = (gdouble) length / SAMPLING_RATE;
+    ref[i] = 0.4 * sin (2 * M_PI * (f0 * t + (f1 - f0) / (2 * T) * t * t));
+    /* clipping introduces harmonic distortion */
+    test[i] = CLAMP (ref[i], -0.3, 0.3);
+  }
+}
+
+static GstFlowReturn
+push_block (GstPad *src, gfloat const *data, gsize frames, guint channels,
+            guint list_size)
+{
+  GstBufferList *list;
+  gsize position;
+
+  if (list_size == 0)
+    return peaq_toolutil_push_block (src, data,
+                                     frames * channels * sizeof (gfloat));
+  list = gst_buffer_list_new ();
+  for (position = 0; position < frames; position += list_size) {
+    gsize size = MIN (list_size, frames - position) * channels *
+      sizeof (gfloat);
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+    gst_buffer_fill (buffer, 0, data + position * channels, size);
+    gst_buffer_list_add (list, buffer);
+  }
+  return gst_pad_push_list (src, list);
+}
+
+/*
+ * column_quantity:
+ * @name: Name of a frame trace column.
+ *
+ * Returns: The quantity held by the column, i.e. #QUANTITY_MOVS for the
+ * "&lt;table&gt;.mov.&lt;name&gt;" columns and the stage quantity for the
+ * "&lt;table&gt;.&lt;signal&gt;.&lt;quantity&gt;.&lt;channel&gt;" columns, or
+ * #COUNT_QUANTITIES if unknown.
+ */
+static GoldenQuantity
+column_quantity (gchar const *name)
+{
+  gchar **parts = g_strsplit (name, ".", -1);
+  GoldenQuantity quantity = COUNT_QUANTITIES;
+  if (parts[0] && parts[1] && strcmp (parts[1], "mov") == 0) {
+    quantity = QUANTITY_MOVS;
+  } else if (parts[0] && parts[1] && parts[2]) {
+    for (quantity = 0; quantity < QUANTITY_MOVS; quantity++)
+      if (strcmp (parts[2], tolerances[quantity].name) == 0)
+        break;
+    if (quantity == QUANTITY_MOVS)
+      quantity = COUNT_QUANTITIES;
+  }
+  g_strfreev (parts);
+  return quantity;
+}
+
+/*
+ * record_frame_trace:
+ * @trace: The trace to add the sections to.
+ * @item: Prefix of the section names.
+ * @filename: The frame trace written by the element.
+ *
+ * Records the MOV columns as they are and the stage columns as one checksum
+ * per frame.
+ */
+static void
+record_frame_trace (GPtrArray *trace, gchar const *item, gchar const *filename)
+{
+  GError *error = NULL;
+  PeaqFrameTraceReader *reader = peaq_frametrace_reader_new (filename,
+                                                             &error);
+  guint c;
+
+  if (!reader) {
+    g_printf ("Could not read frame trace %s: %s\n", filename,
+              error->message);
+    exit (1);
+  }
+  for (c = 0; c < peaq_frametrace_reader_get_column_count (reader); c++) {
+    gchar const *name = peaq_frametrace_reader_get_column_name (reader, c);
+    guint width = peaq_frametrace_reader_get_column_width (reader, c);
+    guint64 frames = peaq_frametrace_reader_get_frame_count
+      (reader, peaq_frametrace_reader_get_column_table (reader, c));
+    GoldenQuantity quantity = column_quantity (name);
+    gdouble *values = g_new (gdouble, frames * width);
+    guint64 frame;
+    guint i;
+
+    if (quantity == COUNT_QUANTITIES ||
+        !peaq_frametrace_reader_read (reader, c, 0, frames, values)) {
+      g_printf ("Could not read column %s of frame trace %s\n", name,
+                filename);
+      exit (1);
+    }
+    if (quantity == QUANTITY_MOVS) {
+      GoldenSection *section = section_new (trace, item, name, quantity,
+                                            width);
+      g_array_append_vals (section->values, values, frames * width);
+    } else {
+      GoldenSection *section = section_new (trace, item, name, quantity, 1);
+      for (frame = 0; frame < frames; frame++) {
+        gdouble sum = 0.;
+        for (i = 0; i < width; i++)
+          sum += values[frame * width + i];
+        section_record (section, &sum);
+      }
+    }
+    g_free (values);
+  }
+  peaq_frametrace_reader_free (reader);
+}
+
+/*
+ * record_results_ring:
+ * @trace: The trace to add the section to.
+ * @item: Prefix of the section name.
+ * @reader: The results ring of the element.
+ *
+ * Records the running distortion index of every entry, in the order they
+ * were published. Only used for the basic version, as the order in which the
+ * FFT and the filter bank frames of the advanced version are processed, and
+ * thus the running distortion index, depends on the buffer sizes.
+ */
+static void
+record_results_ring (GPtrArray *trace, gchar const *item,
+                     PeaqResultsRingReader *reader)
+{
+  GoldenSection *section = section_new (trace, item, "di", QUANTITY_DI, 1);
+  guint32 head = peaq_resultsring_reader_get_head (reader);
+  gdouble *values =
+    g_new (gdouble, peaq_resultsring_reader_get_value_count (reader));
+  guint32 entry;
+
+  if (head > peaq_resultsring_reader_get_slot_count (reader)) {
+    g_printf ("%s: results ring overflow\n", item);
+    exit (1);
+  }
+  for (entry = 0; entry < head; entry++) {
+    guint table;
+    guint64 frame;
+    if (!peaq_resultsring_reader_read (reader, entry, &table, &frame,
+                                       values)) {
+      g_printf ("%s: could not read results ring entry %u\n", item, entry);
+      exit (1);
+    }
+    section_record (section, values);
+  }
+  g_free (values);
+}
+
+/*
+ * record_results:
+ * @trace: The trace to add the sections to.
+ * @item: Prefix of the section names.
+ * @results: The final #GstPeaq:results.
+ *
+ * Records each numerical field of @results as a section of its own.
+ */
+static void
+record_results (GPtrArray *trace, gchar const *item,
+                GstStructure const *results)
+{
+  gint f;
+  for (f = 0; f < gst_structure_n_fields (results); f++) {
+    gchar const *field = gst_structure_nth_field_name (results, f);
+    gchar *name = g_strdup_printf ("results.%s", field);
+    gboolean is_di = strcmp (field, "di") == 0 || strcmp (field, "odg") == 0 ||
+      strcmp (field, "frames") == 0;
+    GoldenSection *section = section_new (trace, item, name,
+                                          is_di ? QUANTITY_DI :
+                                          QUANTITY_MOVS, 1);
+    gdouble value;
+    guint count;
+    if (gst_structure_get_uint (results, field, &count))
+      value = count;
+    else if (!gst_structure_get_double (results, field, &value))
+      value = NAN;
+    section_record (section, &value);
+    g_free (name);
+  }
+}
+
+/*
+ * run_element:
+ * @trace: The trace to add the sections to.
+ * @variant: How to create the element and feed the data.
+ * @item: Prefix of the section names.
+ * @advanced: Whether to use the advanced version.
+ * @channels: Number of channels.
+ * @ref: Interleaved reference samples.
+ * @test: Interleaved test samples.
+ * @length: Number of samples per channel.
+ */
+static void
+run_element (GPtrArray *trace, GoldenVariant const *variant,
+             gchar const *item, gboolean advanced, guint channels,
+             gfloat const *ref, gfloat const *test, guint length)
+{
+  GstElement *peaq;
+  GstPad *ref_src, *test_src;
+  GstStructure *results;
+  PeaqResultsRingReader *ring_reader = NULL;
+  gchar *trace_file = g_build_filename (g_get_tmp_dir (), "testgolden.ftr",
+                                        NULL);
+  gchar *ring_name = g_strdup_printf ("/testgolden-%u",
+                                      (guint) g_random_int ());
+  guint position;
+
+  peaq = g_object_new (GST_TYPE_PEAQ, NULL);
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "console-output", FALSE, "frame-trace-file", trace_file,
+                "frame-trace-quantities", "power-spectrum,"
+                "weighted-power-spectrum,unsmeared-excitation,excitation,"
+                "modulation,movs", NULL);
+  if (!advanced)
+    g_object_set (G_OBJECT (peaq), "results-ring", ring_name, NULL);
+  if (variant->setup)
+    variant->setup (peaq);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, channels);
+  peaq_toolutil_start_stream (test_src, channels);
+  for (position = 0; position < length; position += variant->block_size) {
+    guint frames = MIN (variant->block_size, length - position);
+    if (push_block (ref_src, ref + position * channels, frames, channels,
+                    variant->list_size) != GST_FLOW_OK ||
+        push_block (test_src, test + position * channels, frames, channels,
+                    variant->list_size) != GST_FLOW_OK) {
+      g_printf ("%s: pushing data failed\n", item);
+      exit (1);
+    }
+    /* the ring is created with the first buffer and holds all entries */
+    if (!advanced && !ring_reader)
+      ring_reader = peaq_resultsring_reader_new (ring_name, NULL);
+  }
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "results", &results, NULL);
+
+  record_frame_trace (trace, item, trace_file);
+  if (!advanced) {
+    if (!ring_reader) {
+      g_printf ("%s: could not open results ring %s\n", item, ring_name);
+      exit (1);
+    }
+    record_results_ring (trace, item, ring_reader);
+    peaq_resultsring_reader_free (ring_reader);
+  }
+  record_results (trace, item, results);
+
+  gst_structure_free (results);
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+  g_unlink (trace_file);
+  g_free (trace_file);
+  g_free (ring_name);
+}
+
+/*
+ * compute_trace:
+ * @variant: How to create the element and feed the data.
+ *
+ * Runs every signal as a mono item and, together with the next signal as
+ * second channel, as a stereo item through the basic and the advanced
+ * version.
+ *
+ * Returns: The trace, to be freed with g_ptr_array_unref().
+ */
+static GPtrArray *
+compute_trace (GoldenVariant const *variant)
+{
+  guint s, c, i;
+  gint advanced;
+  GPtrArray *trace = g_ptr_array_new_with_free_func (section_free);
+  gfloat *channel_ref = g_new (gfloat, SIGNAL_LENGTH);
+  gfloat *channel_test = g_new (gfloat, SIGNAL_LENGTH);
+  gfloat *ref = g_new (gfloat, 2 * SIGNAL_LENGTH);
+  gfloat *test = g_new (gfloat, 2 * SIGNAL_LENGTH);
+
+  for (s = 0; s < G_N_ELEMENTS (signals); s++) {
+    guint channels;
+    for (channels = 1; channels <= 2; channels++) {
+      gchar *name = channels == 1 ? g_strdup (signals[s].name) :
+        g_strdup_printf ("%s+%s", signals[s].name,
+                         signals[(s + 1) % G_N_ELEMENTS (signals)].name);
+      for (c = 0; c < channels; c++) {
+        signals[(s + c) % G_N_ELEMENTS (signals)].generate (channel_ref,
+                                                            channel_test,
+                                                            SIGNAL_LENGTH);
+        for (i = 0; i < SIGNAL_LENGTH; i++) {
+          ref[i * channels + c] = channel_ref[i];
+          test[i * channels + c] = channel_test[i];
+        }
+      }
+      for (advanced = 0; advanced < 2; advanced++) {
+        gchar *item = g_strdup_printf ("%s/%s", name,
+                                       advanced ? "advanced" : "basic");
+        run_element (trace, variant, item, advanced, channels, ref, test,
+                     SIGNAL_LENGTH);
+        g_free (item);
+      }
+      g_free (name);
+    }
+  }
+
+  g_free (channel_ref);
+  g_free (channel_test);
+  g_free (ref);
+  g_free (test);
+  return trace;
+}
+
+static gboolean
+compare_traces (GPtrArray const *golden, GPtrArray const *dut,
+                gchar const *dut_name)
+{
+  guint s, i;
+  gboolean ok = TRUE;
+
+  if (golden->len != dut->len) {
+    g_printf ("%s: %u sections != %u sections\n", dut_name, dut->len,
+              golden->len);
+    return FALSE;
+  }
+  for (s = 0; s < golden->len; s++) {
+    GoldenSection const *ref = g_ptr_array_index (golden, s);
+    GoldenSection const *cmp = g_ptr_array_index (dut, s);
+    GoldenTolerance const *tol = &tolerances[ref->quantity];
+    if (strcmp (ref->name, cmp->name) != 0 ||
+        ref->values->len != cmp->values->len) {
+      g_printf ("%s: section %s (%u values) does not match %s (%u values)\n",
+                dut_name, cmp->name, cmp->values->len, ref->name,
+                ref->values->len);
+      ok = FALSE;
+      continue;
+    }
+    for (i = 0; i < ref->values->len; i++) {
+      gdouble r = g_array_index (ref->values, gdouble, i);
+      gdouble d = g_array_index (cmp->values, gdouble, i);
+      gdouble diff = d - r;
+      gdouble reldiff = 2 * diff / (d + r);
+      if (isnan (r) && isnan (d))
+        continue;
+      if (!(fabs (diff) <= tol->delta || fabs (reldiff) <= tol->reldelta)) {
+        /* only report the first mismatch per section */
+        g_printf ("%s: %s[frame %u][%u] = %g != %g (diff = %g, rel = %g, "
+                  "%s tolerance = %g/%g)\n", dut_name, ref->name,
+                  i / ref->width, i % ref->width, d, r, diff, reldiff,
+                  tol->name, tol->delta, tol->reldelta);
+        ok = FALSE;
+        break;
+      }
+    }
+  }
+  return ok;
+}
+
+static gboolean
+write_trace (GPtrArray const *trace, gchar const *filename)
+{
+  guint s, i;
+  FILE *file = g_fopen (filename, "w");
+  if (!file)
+    return FALSE;
+  for (s = 0; s < trace->len; s++) {
+    GoldenSection const *section = g_ptr_array_index (trace, s);
+    fprintf (file, "%s %u %u %u\n", section->name, section->quantity,
+             section->width, section->values->len);
+    for (i = 0; i < section->values->len; i++)
+      fprintf (file, "%.10g\n", g_array_index (section->values, gdouble, i));
+  }
+  return fclose (file) == 0;
+}
+
+static GPtrArray *
+read_trace (gchar const *filename)
+{
+  gchar name[256];
+  guint quantity, width, count, i;
+  FILE *file = g_fopen (filename, "r");
+  GPtrArray *trace;
+  if (!file)
+    return NULL;
+  trace = g_ptr_array_new_with_free_func (section_free);
+  while (fscanf (file, "%255s %u %u %u", name, &quantity, &width, &count)
+         == 4) {
+    GoldenSection *section;
+    if (quantity >= COUNT_QUANTITIES || width == 0)
+      break;
+    section = g_new (GoldenSection, 1);
+    section->name = g_strdup (name);
+    section->quantity = quantity;
+    section->width = width;
+    section->values = g_array_sized_new (FALSE, FALSE, sizeof (gdouble),
+                                         count);
+    g_ptr_array_add (trace, section);
+    for (i = 0; i < count; i++) {
+      gdouble value;
+      if (fscanf (file, "%lf", &value) != 1) {
+        fclose (file);
+        g_ptr_array_unref (trace);
+        return NULL;
+      }
+      g_array_append_val (section->values, value);
+    }
+  }
+  if (!feof (file)) {
+    fclose (file);
+    g_ptr_array_unref (trace);
+    return NULL;
+  }
+  fclose (file);
+  return trace;
+}
+
+int
+main (int argc, char *argv[])
+{
+  guint v;
+  gboolean ok = TRUE;
+  GError *error = NULL;
+  GOptionContext *context;
+  GPtrArray *reference;
+
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+  g_type_init ();
+#endif
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_set_summary (context,
+                                "Compares the per-frame outputs of the peaq element against\n"
+                                "alternative ways of running it and, if given, a golden trace.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+  gst_init (&argc, &argv);
+
+  reference = compute_trace (&reference_variant);
+
+  if (record_filename) {
+    if (!write_trace (reference, record_filename)) {
+      g_printf ("Could not write golden trace to %s\n", record_filename);
+      return 1;
+    }
+    g_ptr_array_unref (reference);
+    return 0;
+  }
+
+  if (filenames && filenames[0]) {
+    GPtrArray *golden = read_trace (filenames[0]);
+    if (!golden) {
+      g_printf ("Could not read golden trace from %s\n", filenames[0]);
+      return 1;
+    }
+    ok &= compare_traces (golden, reference, "current");
+    g_ptr_array_unref (golden);
+  }
+
+  for (v = 0; v < G_N_ELEMENTS (variants); v++) {
+    GPtrArray *trace = compute_trace (&variants[v]);
+    ok &= compare_traces (reference, trace, variants[v].name);
+    g_ptr_array_unref (trace);
+  }
+
+  g_ptr_array_unref (reference);
+
+  return ok ? 0 : 1;
+}
@@ -22,12 +22,19 @@
 
 #include "fftearmodel.h"
 #include "fbearmodel.h"
+#include "frametrace.h"
+#include "gstpeaq.h"
 #include "leveladapter.h"
 #include "modpatt.h"
+#include "movaccum.h"
+#include "resultsring.h"
+#include "toolutil.h"
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 
 /* allowable tolerance of relative error */
 #define RELDELTA 0.00005
@@ -602,6 +609,10 @@ static double loudness2_ref[] = { 0.547559, 0.759658, 0.934751,
 static void test_ear ();
 static void test_leveladapt ();
 static void test_modulationproc ();
+static void test_checkpoint ();
+static void test_frametrace ();
+static void test_resultsring ();
+static void test_skipwarmup ();
 
 static void
 assertArrayEquals (const gdouble * dut, const gdouble * ref, guint len,
@@ -644,10 +655,15 @@ main (int argc, char *argv[])
 #if !GLIB_CHECK_VERSION(2, 36, 0)
   g_type_init ();
 #endif
+  gst_init (&argc, &argv);
 
   test_ear ();
   test_leveladapt ();
   test_modulationproc ();
+  test_checkpoint ();
+  test_frametrace ();
+  test_resultsring ();
+  test_skipwarmup ();
 
   return 0;
 }
@@ -808,3 +824,300 @@ test_modulationproc ()
   assertArrayEquals (peaq_modulationprocessor_get_average_loudness (modproc),
 		     loudness2_ref, 109, "average_loudness2");
 }
+
+static void
+test_checkpoint ()
+{
+  gint i, frame;
+  gfloat input_data[192];
+  gdouble *checkpoint;
+  gdouble excitation[40];
+  PeaqEarModel *fb_ear;
+  PeaqMovAccum *acc;
+  PeaqMovAccum *replayed;
+  GArray *log;
+
+  /* continuing from a restored checkpoint has to give identical results */
+  fb_ear = g_object_new (PEAQ_TYPE_FILTERBANKEARMODEL, NULL);
+  gpointer state = peaq_earmodel_state_alloc (fb_ear);
+  gpointer restored_state = peaq_earmodel_state_alloc (fb_ear);
+  checkpoint = g_new (gdouble, peaq_earmodel_get_checkpoint_size (fb_ear));
+  for (frame = 0; frame < 150; frame++) {
+    if (frame == 100) {
+      peaq_earmodel_state_save_checkpoint (fb_ear, state, checkpoint);
+      peaq_earmodel_state_restore_checkpoint (fb_ear, restored_state,
+                                              checkpoint);
+    }
+    for (i = 0; i < 192; i++)
+      input_data[i] = sin (2 * M_PI * 1000. / 48000. * (i + frame * 192)) *
+        (frame % 7) / 7.;
+    peaq_earmodel_process_block (fb_ear, state, input_data);
+    if (frame >= 100)
+      peaq_earmodel_process_block (fb_ear, restored_state, input_data);
+  }
+  for (i = 0; i < 40; i++)
+    excitation[i] = peaq_earmodel_get_excitation (fb_ear, state)[i];
+  assertArrayEquals (peaq_earmodel_get_excitation (fb_ear, restored_state),
+                     excitation, 40, "restored_excitation");
+
+  /* a fresh state with the excitation set gives the same loudness */
+  peaq_earmodel_state_free (fb_ear, restored_state);
+  restored_state = peaq_earmodel_state_alloc (fb_ear);
+  peaq_earmodel_state_set_excitation (fb_ear, restored_state, excitation,
+                                      NULL);
+  if (peaq_earmodel_calc_loudness (fb_ear, restored_state) !=
+      peaq_earmodel_calc_loudness (fb_ear, state)) {
+    g_printf ("loudness from set excitation differs\n");
+    exit (1);
+  }
+  g_free (checkpoint);
+  peaq_earmodel_state_free (fb_ear, state);
+  peaq_earmodel_state_free (fb_ear, restored_state);
+  g_object_unref (fb_ear);
+
+  /* replaying the logged contributions has to give the same value */
+  acc = peaq_movaccum_new ();
+  replayed = peaq_movaccum_new ();
+  peaq_movaccum_set_channels (acc, 2);
+  peaq_movaccum_set_channels (replayed, 2);
+  peaq_movaccum_set_mode (acc, MODE_AVG_WINDOW);
+  peaq_movaccum_set_mode (replayed, MODE_AVG_WINDOW);
+  log = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  peaq_movaccum_set_log (acc, log);
+  for (frame = 0; frame < 20; frame++) {
+    peaq_movaccum_set_tentative (acc, frame > 15);
+    for (i = 0; i < 2; i++)
+      peaq_movaccum_accumulate (acc, i, frame + i, 1.);
+  }
+  peaq_movaccum_replay (replayed, (gdouble *) log->data, log->len);
+  if (peaq_movaccum_get_value (replayed) != peaq_movaccum_get_value (acc)) {
+    g_printf ("replayed value %f != %f\n", peaq_movaccum_get_value (replayed),
+              peaq_movaccum_get_value (acc));
+    exit (1);
+  }
+  /* ... also after a reset, without the first replay adding up */
+  peaq_movaccum_reset (replayed);
+  peaq_movaccum_replay (replayed, (gdouble *) log->data, log->len);
+  if (peaq_movaccum_get_value (replayed) != peaq_movaccum_get_value (acc)) {
+    g_printf ("value replayed after reset %f != %f\n",
+              peaq_movaccum_get_value (replayed),
+              peaq_movaccum_get_value (acc));
+    exit (1);
+  }
+  peaq_movaccum_set_log (acc, NULL);
+  g_array_unref (log);
+  g_object_unref (acc);
+  g_object_unref (replayed);
+}
+
+static void
+test_frametrace ()
+{
+  gint i, frame;
+  gchar *filename;
+  guint table, column;
+  gdouble values[2 * 700];
+  gdouble expected[2 * 700];
+  PeaqFrameTrace *trace;
+  PeaqFrameTraceReader *reader;
+
+  /* reading back a trace spanning several chunks gives the written values */
+  filename = g_build_filename (g_get_tmp_dir (), "testpeaq.ftr", NULL);
+  trace = peaq_frametrace_new (filename, 64, 2);
+  table = peaq_frametrace_add_table (trace, "fft", 1024);
+  column = peaq_frametrace_add_column (trace, table, "fft.value", 2);
+  peaq_frametrace_start (trace);
+  for (frame = 0; frame < 700; frame++) {
+    gdouble *row = peaq_frametrace_get_row (trace, column);
+    for (i = 0; i < 2; i++)
+      row[i] = expected[2 * frame + i] = sin (frame + i);
+    peaq_frametrace_next_frame (trace, table);
+  }
+  if (!peaq_frametrace_free (trace)) {
+    g_printf ("writing %s failed\n", filename);
+    exit (1);
+  }
+  reader = peaq_frametrace_reader_new (filename, NULL);
+  if (!reader || peaq_frametrace_reader_get_frame_count (reader, 0) != 700 ||
+      peaq_frametrace_reader_find_column (reader, "fft.value") != 0) {
+    g_printf ("reading %s failed\n", filename);
+    exit (1);
+  }
+  peaq_frametrace_reader_read (reader, 0, 0, 700, values);
+  assertArrayEquals (values, expected, 2 * 700, "trace");
+  peaq_frametrace_reader_read (reader, 0, 100, 300, values);
+  assertArrayEquals (values, expected + 2 * 100, 2 * 300, "trace_range");
+  peaq_frametrace_reader_free (reader);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+test_resultsring ()
+{
+  gint i;
+  guint32 entry;
+  guint table;
+  guint64 frame;
+  gdouble values[2];
+  gdouble expected[2];
+  gchar const *names[] = { "a", "b" };
+  gchar *name;
+  PeaqResultsRing *ring;
+  PeaqResultsRingReader *reader;
+
+  /* the last slot count entries can be read back, older ones are reported as
+   * overwritten, also after the writer has finished */
+  name = g_strdup_printf ("/testpeaq-%u", (guint) g_random_int ());
+  ring = peaq_resultsring_new (name, 6, names, 2);
+  if (!ring) {
+    g_printf ("creating results ring %s failed\n", name);
+    exit (1);
+  }
+  reader = peaq_resultsring_reader_new (name, NULL);
+  if (!reader || peaq_resultsring_reader_get_slot_count (reader) != 8 ||
+      peaq_resultsring_reader_get_value_count (reader) != 2 ||
+      strcmp (peaq_resultsring_reader_get_value_name (reader, 1), "b") != 0) {
+    g_printf ("opening results ring %s failed\n", name);
+    exit (1);
+  }
+  for (i = 0; i < 20; i++) {
+    values[0] = sin (i);
+    values[1] = cos (i);
+    peaq_resultsring_publish (ring, i % 2, 100 + i, values);
+  }
+  peaq_resultsring_free (ring);
+  if (peaq_resultsring_reader_get_head (reader) != 20 ||
+      !peaq_resultsring_reader_is_finished (reader)) {
+    g_printf ("results ring head mismatch\n");
+    exit (1);
+  }
+  for (entry = 12; entry < 20; entry++) {
+    if (!peaq_resultsring_reader_read (reader, entry, &table, &frame,
+                                       values) ||
+        table != entry % 2 || frame != 100 + entry) {
+      g_printf ("reading results ring entry %u failed\n", entry);
+      exit (1);
+    }
+    expected[0] = sin (entry);
+    expected[1] = cos (entry);
+    assertArrayEquals (values, expected, 2, "resultsring");
+  }
+  if (peaq_resultsring_reader_read (reader, 11, &table, &frame, values)) {
+    g_printf ("overwritten results ring entry was read\n");
+    exit (1);
+  }
+  peaq_resultsring_reader_free (reader);
+  g_free (name);
+}
+
+/*
+ * run_peaq:
+ * @advanced: Whether to use the advanced version.
+ * @skip_warm_up: Value for #GstPeaq:skip-warm-up.
+ * @ref: Reference samples (mono).
+ * @test: Test samples (mono).
+ * @frames: Number of samples.
+ *
+ * Runs the signals through a new peaq element, pushing them in blocks of
+ * 4800 samples.
+ *
+ * Returns: The final #GstPeaq:results, to be freed with gst_structure_free().
+ */
+static GstStructure *
+run_peaq (gboolean advanced, gboolean skip_warm_up, gfloat const *ref,
+          gfloat const *test, gsize frames)
+{
+  GstElement *peaq;
+  GstPad *ref_src, *test_src;
+  GstStructure *results;
+  gsize position;
+
+  peaq = g_object_new (GST_TYPE_PEAQ, NULL);
+  gst_object_ref_sink (peaq);
+  g_object_set (G_OBJECT (peaq), "advanced", advanced,
+                "skip-warm-up", skip_warm_up, "console-output", FALSE, NULL);
+  ref_src = peaq_toolutil_create_src_pad (peaq, "ref");
+  test_src = peaq_toolutil_create_src_pad (peaq, "test");
+  gst_element_set_state (peaq, GST_STATE_PLAYING);
+  peaq_toolutil_start_stream (ref_src, 1);
+  peaq_toolutil_start_stream (test_src, 1);
+  for (position = 0; position < frames; position += 4800) {
+    gsize size = MIN (4800, frames - position) * sizeof (gfloat);
+    if (peaq_toolutil_push_block (ref_src, ref + position, size) !=
+        GST_FLOW_OK ||
+        peaq_toolutil_push_block (test_src, test + position, size) !=
+        GST_FLOW_OK) {
+      g_printf ("pushing data failed\n");
+      exit (1);
+    }
+  }
+  gst_element_set_state (peaq, GST_STATE_NULL);
+  g_object_get (peaq, "results", &results, NULL);
+
+  gst_object_unref (ref_src);
+  gst_object_unref (test_src);
+  gst_object_unref (peaq);
+  return results;
+}
+
+static void
+test_skipwarmup ()
+{
+  /* a quarter second of silence before 0.75 s of signal, enough for the
+   * advanced version to compute all MOVs */
+  const gsize silence = 12000;
+  const gsize frames = silence + 36000;
+  gfloat *ref = g_new0 (gfloat, frames);
+  gfloat *test = g_new0 (gfloat, frames);
+  GRand *rand = g_rand_new_with_seed (1);
+  gsize i;
+  gint advanced;
+
+  /* tones up to 16 kHz and a low-pass filtered version with some noise, so
+   * that all MOVs are defined */
+  for (i = silence; i < frames; i++) {
+    gint k;
+    for (k = 0; k < 16; k++)
+      ref[i] += 0.04 * sin (2 * M_PI * (1000. * k + 19.5) / 48000. * i);
+    test[i] = 0.7 * test[i - 1] + 0.3 * ref[i] +
+      1e-3 * g_rand_double_range (rand, -1., 1.);
+  }
+  g_rand_free (rand);
+
+  /* skipping the MOV calculation for the leading silence must not change the
+   * results at all */
+  for (advanced = 0; advanced < 2; advanced++) {
+    GstStructure *skipped = run_peaq (advanced, TRUE, ref, test, frames);
+    GstStructure *computed = run_peaq (advanced, FALSE, ref, test, frames);
+    gint n = gst_structure_n_fields (computed);
+    gint f;
+    if (gst_structure_n_fields (skipped) != n) {
+      g_printf ("skip-warm-up changes the results fields\n");
+      exit (1);
+    }
+    for (f = 0; f < n; f++) {
+      gchar const *name = gst_structure_nth_field_name (computed, f);
+      gdouble a, b;
+      guint frames_a, frames_b;
+      if (gst_structure_get_double (computed, name, &a)) {
+        if (!gst_structure_get_double (skipped, name, &b) ||
+            (a != b && !(isnan (a) && isnan (b)))) {
+          g_printf ("%s %s with skip-warm-up = %g != %g\n",
+                    advanced ? "advanced" : "basic", name, b, a);
+          exit (1);
+        }
+      } else if (gst_structure_get_uint (computed, name, &frames_a) &&
+                 (!gst_structure_get_uint (skipped, name, &frames_b) ||
+                  frames_a != frames_b)) {
+        g_printf ("%s %s differs with skip-warm-up\n",
+                  advanced ? "advanced" : "basic", name);
+        exit (1);
+      }
+    }
+    gst_structure_free (skipped);
+    gst_structure_free (computed);
+  }
+  g_free (ref);
+  g_free (test);
+}
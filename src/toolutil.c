@@ -0,0 +1,196 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * toolutil.c: Helpers shared by the command line tools.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Reading of WAV files and feeding of sample blocks into the sink pads of a
+ * peaq element without a pipeline, as done by screenpeaq, batchpeaq,
+ * monitorpeaq, alignpeaq, soakpeaq and replaypeaq.
+ */
+
+#include "toolutil.h"
+
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLING_RATE 48000
+
+static guint32
+read_le (guchar const *data, guint bytes)
+{
+  guint32 value = 0;
+  guint i;
+  for (i = 0; i < bytes; i++)
+    value |= (guint32) data[i] << (8 * i);
+  return value;
+}
+
+/*
+ * peaq_toolutil_read_wav:
+ * @filename: Name of the file to read.
+ * @channels: Location to store the number of channels.
+ * @frames: Location to store the number of frames.
+ *
+ * Reads a WAVE_FORMAT_PCM or WAVE_FORMAT_IEEE_FLOAT (or the corresponding
+ * WAVE_FORMAT_EXTENSIBLE) file sampled at 48 kHz.
+ *
+ * Returns: The interleaved samples, to be freed with g_free(), or %NULL on
+ * error.
+ */
+gfloat *
+peaq_toolutil_read_wav (gchar const *filename, guint *channels, gsize *frames)
+{
+  gchar *contents;
+  gsize length;
+  gsize offset = 12;
+  guint format = 0;
+  guint bits = 0;
+  guchar const *data = NULL;
+  gsize data_size = 0;
+  gfloat *samples;
+  gsize i, count;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL)) {
+    g_printf ("Error: could not read %s\n", filename);
+    return NULL;
+  }
+  if (length < 12 || memcmp (contents, "RIFF", 4) != 0 ||
+      memcmp (contents + 8, "WAVE", 4) != 0) {
+    g_printf ("Error: %s is no WAV file\n", filename);
+    g_free (contents);
+    return NULL;
+  }
+  *channels = 0;
+  while (offset + 8 <= length) {
+    guchar const *chunk = (guchar const *) contents + offset;
+    gsize size = MIN (read_le (chunk + 4, 4), length - offset - 8);
+    if (memcmp (chunk, "fmt ", 4) == 0 && size >= 16) {
+      format = read_le (chunk + 8, 2);
+      *channels = read_le (chunk + 10, 2);
+      bits = read_le (chunk + 22, 2);
+      if (format == 0xfffe && size >= 26)
+        format = read_le (chunk + 32, 2);
+      if (read_le (chunk + 12, 4) != SAMPLING_RATE) {
+        g_printf ("Error: %s is not sampled at 48 kHz\n", filename);
+        g_free (contents);
+        return NULL;
+      }
+    } else if (memcmp (chunk, "data", 4) == 0) {
+      data = chunk + 8;
+      data_size = size;
+    }
+    offset += 8 + size + (size & 1);
+  }
+  if (!data || *channels == 0 ||
+      !((format == 1 && (bits == 16 || bits == 24 || bits == 32)) ||
+        (format == 3 && bits == 32))) {
+    g_printf ("Error: unsupported sample format in %s\n", filename);
+    g_free (contents);
+    return NULL;
+  }
+
+  *frames = data_size / (*channels * bits / 8);
+  count = *frames * *channels;
+  samples = g_new (gfloat, count);
+  for (i = 0; i < count; i++) {
+    guint32 value = read_le (data + i * bits / 8, bits / 8);
+    if (format == 3) {
+      union { guint32 u; gfloat f; } sample;
+      sample.u = value;
+      samples[i] = sample.f;
+    } else {
+      /* sign-extend from the most significant bit */
+      value <<= 32 - bits;
+      samples[i] = (gint32) value / 2147483648.f;
+    }
+  }
+  g_free (contents);
+  return samples;
+}
+
+/*
+ * peaq_toolutil_create_src_pad:
+ * @peaq: The peaq element.
+ * @sink_name: Name of the sink pad of @peaq to link to.
+ *
+ * Creates an active source pad named like the sink pad and links it to the
+ * latter, exiting on failure.
+ *
+ * Returns: The new source pad.
+ */
+GstPad *
+peaq_toolutil_create_src_pad (GstElement *peaq, gchar const *sink_name)
+{
+  GstPad *src = gst_pad_new (sink_name, GST_PAD_SRC);
+  GstPad *sink = gst_element_get_static_pad (peaq, sink_name);
+  gst_pad_set_active (src, TRUE);
+  if (gst_pad_link (src, sink) != GST_PAD_LINK_OK) {
+    g_printf ("Error: could not link to %s pad\n", sink_name);
+    exit (2);
+  }
+  gst_object_unref (sink);
+  return src;
+}
+
+/*
+ * peaq_toolutil_start_stream:
+ * @src: Source pad created with peaq_toolutil_create_src_pad().
+ * @channels: Number of channels.
+ *
+ * Pushes the stream-start, caps (interleaved 32 bit float at 48 kHz) and
+ * segment events.
+ */
+void
+peaq_toolutil_start_stream (GstPad *src, guint channels)
+{
+  GstSegment segment;
+  GstCaps *caps = gst_caps_new_simple ("audio/x-raw",
+                                       "format", G_TYPE_STRING, "F32LE",
+                                       "layout", G_TYPE_STRING, "interleaved",
+                                       "rate", G_TYPE_INT, SAMPLING_RATE,
+                                       "channels", G_TYPE_INT, channels,
+                                       NULL);
+  gchar *stream_id = gst_pad_get_name (src);
+  gst_pad_push_event (src, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+  gst_pad_push_event (src, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (src, gst_event_new_segment (&segment));
+}
+
+/*
+ * peaq_toolutil_push_block:
+ * @src: Source pad created with peaq_toolutil_create_src_pad().
+ * @data: Interleaved samples.
+ * @size: Size of @data in bytes.
+ *
+ * Pushes a copy of @data as a new buffer.
+ *
+ * Returns: The flow return of the push.
+ */
+GstFlowReturn
+peaq_toolutil_push_block (GstPad *src, gfloat const *data, gsize size)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (buffer, 0, data, size);
+  return gst_pad_push (src, buffer);
+}
@@ -0,0 +1,35 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * toolutil.h: Helpers shared by the command line tools.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __TOOLUTIL_H__
+#define __TOOLUTIL_H__ 1
+
+#include <gst/gst.h>
+
+gfloat *peaq_toolutil_read_wav (gchar const *filename, guint *channels,
+                                gsize *frames);
+GstPad *peaq_toolutil_create_src_pad (GstElement *peaq,
+                                      gchar const *sink_name);
+void peaq_toolutil_start_stream (GstPad *src, guint channels);
+GstFlowReturn peaq_toolutil_push_block (GstPad *src, gfloat const *data,
+                                        gsize size);
+
+#endif
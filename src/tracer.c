@@ -0,0 +1,200 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * tracer.c: Timeline tracing of the processing stages.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:tracer
+ * @short_description: Timeline tracing.
+ * @title: Tracer
+ *
+ * The tracer records the begin and end time of processing sections (like
+ * pad_chain(), adapter mapping, ear model invocations, pre-processing, MOV
+ * calculation and accumulation) and writes them as complete ("X") events in
+ * the Chrome trace event JSON format, which can be displayed with
+ * chrome://tracing or Perfetto, using one track per thread.
+ *
+ * The tracer is process-wide: peaq_tracer_start() and peaq_tracer_stop() are
+ * reference counted and the file name passed to the first
+ * peaq_tracer_start() is used. Events are collected in per-thread ring
+ * buffers without any locking and only written to the file (holding a global
+ * lock) when a ring buffer is full, when its thread terminates, or when
+ * tracing is stopped. When tracing is not active, the instrumentation costs a
+ * single test of #peaq_tracer_active.
+ */
+
+#include "tracer.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#define TRACE_RING_SIZE 4096
+
+typedef struct _TraceEvent TraceEvent;
+typedef struct _TraceRing TraceRing;
+
+struct _TraceEvent
+{
+  gchar const *name;
+  GstClockTime start;
+  GstClockTime end;
+};
+
+struct _TraceRing
+{
+  guint tid;
+  guint count;
+  TraceEvent events[TRACE_RING_SIZE];
+};
+
+static void ring_free (gpointer data);
+
+volatile gint peaq_tracer_active = 0;
+
+static GMutex tracer_mutex;
+static GPrivate ring_key = G_PRIVATE_INIT (ring_free);
+static GSList *rings = NULL;
+static FILE *trace_file = NULL;
+static guint tracer_users = 0;
+static guint next_tid = 1;
+static gboolean first_event;
+static GstClockTime trace_start;
+
+/* must be called with tracer_mutex held */
+static void
+ring_flush (TraceRing *ring)
+{
+  guint i;
+  if (trace_file) {
+    for (i = 0; i < ring->count; i++) {
+      TraceEvent *event = &ring->events[i];
+      /* events started before the tracer are dropped */
+      if (event->start < trace_start)
+        continue;
+      fprintf (trace_file,
+               "%s{\"name\":\"%s\",\"cat\":\"peaq\",\"ph\":\"X\","
+               "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+               first_event ? "" : ",\n", event->name,
+               (event->start - trace_start) * 1e-3,
+               (event->end - event->start) * 1e-3, ring->tid);
+      first_event = FALSE;
+    }
+  }
+  ring->count = 0;
+}
+
+static void
+ring_free (gpointer data)
+{
+  TraceRing *ring = data;
+  g_mutex_lock (&tracer_mutex);
+  ring_flush (ring);
+  rings = g_slist_remove (rings, ring);
+  g_mutex_unlock (&tracer_mutex);
+  g_free (ring);
+}
+
+/**
+ * peaq_tracer_start:
+ * @filename: Name of the file to write the trace to.
+ *
+ * Starts tracing to @filename, unless tracing is already active, in which case
+ * only the reference count is increased.
+ */
+void
+peaq_tracer_start (gchar const *filename)
+{
+  g_mutex_lock (&tracer_mutex);
+  if (tracer_users++ == 0) {
+    trace_file = g_fopen (filename, "w");
+    if (trace_file) {
+      fputs ("{\"traceEvents\":[\n", trace_file);
+      first_event = TRUE;
+      trace_start = gst_util_get_timestamp ();
+      g_atomic_int_set (&peaq_tracer_active, 1);
+    } else {
+      g_warning ("could not open trace file %s", filename);
+    }
+  }
+  g_mutex_unlock (&tracer_mutex);
+}
+
+/**
+ * peaq_tracer_stop:
+ *
+ * Decreases the reference count and, if it drops to zero, writes the events of
+ * all threads to the trace file and closes it. No events may be recorded
+ * concurrently, i.e. the streaming threads have to be stopped.
+ */
+void
+peaq_tracer_stop (void)
+{
+  GSList *ring;
+  g_mutex_lock (&tracer_mutex);
+  if (tracer_users > 0 && --tracer_users == 0) {
+    g_atomic_int_set (&peaq_tracer_active, 0);
+    for (ring = rings; ring; ring = ring->next)
+      ring_flush (ring->data);
+    if (trace_file) {
+      fputs ("\n]}\n", trace_file);
+      fclose (trace_file);
+      trace_file = NULL;
+    }
+  }
+  g_mutex_unlock (&tracer_mutex);
+}
+
+/**
+ * peaq_tracer_record:
+ * @name: Name of the traced section; has to be a static string.
+ * @start: Start time of the section as returned by peaq_tracer_begin().
+ * @end: End time of the section.
+ *
+ * Appends an event to the calling thread's ring buffer, flushing it to the
+ * trace file if it is full. Usually called through peaq_tracer_end().
+ */
+void
+peaq_tracer_record (gchar const *name, GstClockTime start, GstClockTime end)
+{
+  TraceRing *ring = g_private_get (&ring_key);
+  TraceEvent *event;
+
+  /* tracing was activated in the middle of the section */
+  if (start == 0)
+    return;
+
+  if (G_UNLIKELY (ring == NULL)) {
+    ring = g_new (TraceRing, 1);
+    ring->count = 0;
+    g_private_set (&ring_key, ring);
+    g_mutex_lock (&tracer_mutex);
+    ring->tid = next_tid++;
+    rings = g_slist_prepend (rings, ring);
+    g_mutex_unlock (&tracer_mutex);
+  }
+  if (G_UNLIKELY (ring->count == TRACE_RING_SIZE)) {
+    g_mutex_lock (&tracer_mutex);
+    ring_flush (ring);
+    g_mutex_unlock (&tracer_mutex);
+  }
+  event = &ring->events[ring->count++];
+  event->name = name;
+  event->start = start;
+  event->end = end;
+}
@@ -0,0 +1,59 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * tracer.h: Timeline tracing of the processing stages.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __TRACER_H__
+#define __TRACER_H__ 1
+
+#include <gst/gst.h>
+
+extern volatile gint peaq_tracer_active;
+
+void peaq_tracer_start (gchar const *filename);
+void peaq_tracer_stop (void);
+void peaq_tracer_record (gchar const *name, GstClockTime start,
+                         GstClockTime end);
+
+/**
+ * peaq_tracer_begin:
+ *
+ * Returns: The current time if tracing is active, 0 otherwise.
+ */
+static inline GstClockTime
+peaq_tracer_begin (void)
+{
+  return G_UNLIKELY (peaq_tracer_active) ? gst_util_get_timestamp () : 0;
+}
+
+/**
+ * peaq_tracer_end:
+ * @name: Name of the traced section; has to be a static string.
+ * @start: The time returned by peaq_tracer_begin().
+ *
+ * Records the section started at @start as ending now if tracing is active.
+ */
+static inline void
+peaq_tracer_end (gchar const *name, GstClockTime start)
+{
+  if (G_UNLIKELY (peaq_tracer_active))
+    peaq_tracer_record (name, start, gst_util_get_timestamp ());
+}
+
+#endif
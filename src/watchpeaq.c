@@ -0,0 +1,142 @@
+/* GstPEAQ
+ * Copyright (C) 2026 Martin Holters <martin.holters@hsu-hh.de>
+ *
+ * watchpeaq.c: Follow the results ring of a running peaq element.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Example reader of the shared-memory ring written by the peaq element with
+ * the results-ring property set: maps the ring, prints the entries as they
+ * are published and reports entries overwritten before they could be read.
+ * Does not depend on GStreamer; a dashboard would do the same.
+ */
+
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <stdio.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "resultsring.h"
+
+static gint interval = 20;
+static gboolean all_values = FALSE;
+static gboolean from_start = FALSE;
+
+static GOptionEntry option_entries[] = {
+  {"interval", 'i', 0, G_OPTION_ARG_INT, &interval,
+   "poll the ring every N milliseconds (default 20)", "N"},
+  {"all", 'a', 0, G_OPTION_ARG_NONE, &all_values,
+   "print the per-frame MOVs in addition to the grades", NULL},
+  {"from-start", 's', 0, G_OPTION_ARG_NONE, &from_start,
+   "start with the oldest entry still in the ring instead of the newest", NULL},
+  {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
+};
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  PeaqResultsRingReader *reader;
+  guint value_count, printed_count, slot_count, i;
+  gdouble *values;
+  guint32 next;
+  guint64 lost = 0;
+
+  context = g_option_context_new ("NAME");
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_set_summary (context,
+                                "watchpeaq prints the per-frame results the peaq element publishes to the\n"
+                                "shared-memory ring set with its results-ring property.");
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printf ("Failed to initialize: %s\n", error->message);
+    g_error_free (error);
+    g_option_context_free (context);
+    return 1;
+  }
+  if (argc != 2) {
+    gchar *help = g_option_context_get_help (context, TRUE, NULL);
+    puts (help);
+    g_free (help);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  reader = peaq_resultsring_reader_new (argv[1], &error);
+  if (!reader) {
+    g_printf ("Error: %s\n", error->message);
+    g_error_free (error);
+    return 2;
+  }
+
+  value_count = peaq_resultsring_reader_get_value_count (reader);
+  slot_count = peaq_resultsring_reader_get_slot_count (reader);
+  /* the grades come first */
+  printed_count = all_values ? value_count : MIN (value_count, 3);
+  values = g_new (gdouble, value_count);
+
+  g_printf ("%5s %10s", "table", "frame");
+  for (i = 0; i < printed_count; i++)
+    g_printf (" %s", peaq_resultsring_reader_get_value_name (reader, i));
+  g_printf ("\n");
+
+  next = peaq_resultsring_reader_get_head (reader);
+  if (from_start)
+    next = next >= slot_count ? next - slot_count : 0;
+
+  for (;;) {
+    gboolean finished = peaq_resultsring_reader_is_finished (reader);
+    guint32 head = peaq_resultsring_reader_get_head (reader);
+    if (head - next > slot_count) {
+      lost += head - next - slot_count;
+      next = head - slot_count;
+    }
+    while (next != head) {
+      guint table;
+      guint64 frame;
+      if (!peaq_resultsring_reader_read (reader, next, &table, &frame,
+                                         values)) {
+        /* overwritten, continue with the oldest entry still present */
+        lost++;
+        next++;
+        continue;
+      }
+      g_printf ("%5u %10" G_GUINT64_FORMAT, table, frame);
+      for (i = 0; i < printed_count; i++)
+        g_printf (" %8.3f", values[i]);
+      g_printf ("\n");
+      next++;
+    }
+    if (finished)
+      break;
+    g_usleep (interval * 1000);
+  }
+
+  if (lost > 0)
+    g_printf ("%" G_GUINT64_FORMAT " entries were overwritten before they "
+              "could be read\n", lost);
+
+  g_free (values);
+  peaq_resultsring_reader_free (reader);
+
+  return 0;
+}